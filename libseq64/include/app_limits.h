@@ -181,6 +181,84 @@
 #define SEQ64_NO_QUEUE                  (-1)
 #define SEQ64_BAD_QUEUE_ID              (unsigned(-1))
 
+/**
+ *  The largest look-ahead, in milliseconds, allowed for the scheduled output
+ *  mode (see the [output-lookahead] option).  Larger values make muting and
+ *  tempo changes lag noticeably.
+ */
+
+#define SEQ64_OUTPUT_LOOKAHEAD_MAX      200
+
+/**
+ *  The default and largest memory limits, in kilobytes, of the undo (and
+ *  the redo) history of each pattern (see the [undo-memory-limit] option).
+ *  A limit of 0 means no limit.
+ */
+
+#define SEQ64_UNDO_MEMORY_DEFAULT       4096
+#define SEQ64_UNDO_MEMORY_MAX           (1024 * 1024)
+
+/**
+ *  The most events that the JACK process engine can render in one JACK
+ *  cycle (see mastermidibase::set_engine()).  The space is allocated once,
+ *  before the engine starts, so that the process callback never allocates.
+ *  Further events in the same cycle are dropped.
+ */
+
+#define SEQ64_ENGINE_EVENTS_MAX         4096
+
+/**
+ *  The number of events that the output thread can stage in one output
+ *  frame (see mastermidibase::batch_begin()) before the staging buffer has
+ *  to grow.  Reserved up front, so that the first frames do not allocate.
+ */
+
+#define SEQ64_BATCH_EVENTS              1024
+
+/**
+ *  How late, in microseconds, the output thread can wake up after its
+ *  deadline before the wakeup is counted as late (see
+ *  perform::output_late_count()).
+ */
+
+#define SEQ64_LATE_WAKEUP_US            500
+
+/**
+ *  The default, smallest, and largest sizes, in bytes, of the pieces a SysEx
+ *  message is sent in, and the default and largest SysEx pacing rates, in
+ *  bytes per second (see the [sysex-pacing] option).  The default rate is
+ *  that of a DIN MIDI cable: 31250 baud, 10 bits per byte.  A rate of 0
+ *  means no pacing.
+ */
+
+#define SEQ64_SYSEX_CHUNK_DEFAULT       256
+#define SEQ64_SYSEX_CHUNK_MIN           16
+#define SEQ64_SYSEX_CHUNK_MAX           4096
+#define SEQ64_SYSEX_RATE_DEFAULT        3125
+#define SEQ64_SYSEX_RATE_MAX            1000000
+
+/**
+ *  The largest incoming SysEx message, in bytes, that is kept.  The bytes
+ *  of a longer message are dropped, and counted.
+ */
+
+#define SEQ64_SYSEX_INPUT_MAX           (1024 * 1024)
+
+/**
+ *  The number of event tags that the scheduled output mode can hand out to
+ *  patterns (see mastermidibase::pattern_tag()).  ALSA tags are one byte.
+ */
+
+#define SEQ64_SCHEDULE_TAGS             256
+
+/**
+ *  The number of MIDI thru routes (see mastermidibase::set_thru_route())
+ *  that have room set aside at startup.  More can be added, at the cost of
+ *  an allocation.
+ */
+
+#define SEQ64_THRU_ROUTES               16
+
 /**
  *  Guessing that this has to do with the width of the performance piano roll.
  *  See perfroll::init_before_show().
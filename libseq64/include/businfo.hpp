@@ -304,6 +304,13 @@ public:
     void clock (midipulse tick);
     void sysex (event * ev);
     void play (bussbyte bus, event * e24, midibyte channel);
+    void play_at
+    (
+        bussbyte bus, event * e24, midibyte channel,
+        midipulse tick, int tag
+    );
+    void play_frame (bussbyte bus, event * e24, midibyte channel, int frame);
+    void play_due (bussbyte bus, event * e24, midibyte channel, long ago_us);
     bool set_clock (bussbyte bus, clock_e clocktype);
     void set_all_clocks ();
     clock_e get_clock (bussbyte bus);
@@ -315,7 +322,7 @@ public:
     bool get_input (bussbyte bus);
     bool is_system_port (bussbyte bus);
     bool poll_for_midi ();
-    bool get_midi_event (event * inev);
+    bool get_midi_event (event * inev, long * age = nullptr);
     int replacement_port (int bus, int port);
 
 };          // class busarray
@@ -399,6 +399,32 @@ pulses_per_measure (int ppqn = SEQ64_DEFAULT_PPQN)
     return 4 * ppqn;
 }
 
+/**
+ *  Returns the earlier of two pulse values, where SEQ64_NULL_MIDIPULSE
+ *  means "never".
+ *
+ * \param a
+ *      The first pulse value.
+ *
+ * \param b
+ *      The second pulse value.
+ *
+ * \return
+ *      Returns the smaller of the two values, unless one of them is
+ *      SEQ64_NULL_MIDIPULSE, in which case the other is returned.
+ */
+
+inline midipulse
+earlier_pulse (midipulse a, midipulse b)
+{
+    if (a == SEQ64_NULL_MIDIPULSE)
+        return b;
+    else if (b == SEQ64_NULL_MIDIPULSE)
+        return a;
+    else
+        return a < b ? a : b ;
+}
+
 /**
  *  Calculates the length of an integral number of measures, in ticks.
  *  This function is called in seqedit::apply_length(), when the user
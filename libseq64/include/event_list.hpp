@@ -47,6 +47,7 @@
  *  std::multimap implementation is a lot faster at sorting.
  */
 
+#include <memory>                       /* std::shared_ptr<>            */
 #include <string>
 #include <stack>
 
@@ -70,6 +71,7 @@
 #define DREF(e)         event_list::dref(e)
 
 #include "event.hpp"
+#include "node_pool.hpp"                /* seq64::pool_allocator<>      */
 
 /*
  *  Do not document a namespace; it breaks Doxygen.
@@ -89,6 +91,8 @@ class event_list
 {
 
     friend class editable_events;       // access to event_key class
+    friend class event_pack;            // access to storage and flags
+    friend class event_snapshot;        // access to event_list::iterator
     friend class midifile;              // access to print()
     friend class midi_container;        // access to event_list::iterator
     friend class midi_splitter;         // ditto
@@ -139,12 +143,16 @@ private:
      *  Types to use to swap between list and multimap implementations.
      */
 
-    typedef std::multimap<event_key, event> Events;
+    typedef std::multimap
+    <
+        event_key, event, std::less<event_key>,
+        pool_allocator<std::pair<const event_key, event> >
+    > Events;
     typedef std::pair<event_key, event> EventsPair;
 
 #else   // use std::list here:
 
-    typedef std::list<event> Events;
+    typedef std::list<event, pool_allocator<event> > Events;
 
 #endif  // SEQ64_USE_EVENT_MAP
 
@@ -152,14 +160,28 @@ private:
     typedef Events::const_iterator const_iterator;
     typedef Events::reverse_iterator reverse_iterator;
     typedef Events::const_reverse_iterator const_reverse_iterator;
+    typedef Events::allocator_type Allocator;
 
 private:
 
     /**
-     *  This list holds the current pattern/sequence events.
+     *  The pool that the nodes of this list come from, or null to use the
+     *  heap.  It belongs to the list, not to the storage: storage shared
+     *  from another list keeps the nodes of that list until this list
+     *  detaches it, and then the copy is made in this pool.
      */
 
-    Events m_events;
+    std::shared_ptr<node_pool> m_pool;
+
+    /**
+     *  This list holds the current pattern/sequence events.  It is shared
+     *  by copies of the event list (copy-on-write), so that copying an event
+     *  list, for the clipboard, for saving, or between patterns, costs
+     *  nothing until one of the copies is changed.  Shared storage is never
+     *  changed; see storage().
+     */
+
+    std::shared_ptr<Events> m_storage;
 
     /**
      *  A flag to indicate if an event was added or removed.  We may need to
@@ -188,47 +210,109 @@ private:
 
     bool m_has_time_signature;
 
+    /**
+     *  Counts the structural changes made to the container: insertions,
+     *  removals, sorts, merges, and whole-list assignments.  Any of these can
+     *  invalidate or reorder iterators, so a client that caches an iterator
+     *  (such as the play cursor of the sequence class) saves this value and
+     *  compares it before reusing the iterator.  Changing the data bytes of
+     *  an event in place does not bump this counter.
+     */
+
+    unsigned long m_generation;
+
+private:
+
+    /**
+     *  Provides the events for changing them, or for getting an iterator
+     *  through which they might be changed.  If the storage is shared with
+     *  another event list, this list first gets its own copy of it.
+     *
+     * \return
+     *      Returns a reference to storage owned by this list alone.
+     */
+
+    Events & storage ()
+    {
+        if (m_storage.use_count() > 1)
+            detach();
+
+        return *m_storage;
+    }
+
+    /**
+     *  Provides the events for reading only.  No copying is done.
+     */
+
+    const Events & storage () const
+    {
+        return *m_storage;
+    }
+
+    void detach ();
+
 public:
 
     event_list ();
+    explicit event_list (const std::shared_ptr<node_pool> & pool);
     event_list (const event_list & a_rhs);
     event_list & operator = (const event_list & a_rhs);
     ~event_list ();
 
     /**
-     * \getter m_events.begin(), non-constant version.
+     * \getter m_storage->begin(), non-constant version.  Unshares the storage.
      */
 
     iterator begin ()
     {
-        return m_events.begin();
+        return storage().begin();
     }
 
     /**
-     * \getter m_events.begin(), constant version.
+     * \getter m_storage->begin(), constant version.
      */
 
     const_iterator begin () const
     {
-        return m_events.begin();
+        return storage().begin();
     }
 
     /**
-     * \getter m_events.end(), non-constant version.
+     * \getter m_storage->end(), non-constant version.  Unshares the storage.
      */
 
     iterator end ()
     {
-        return m_events.end();
+        return storage().end();
     }
 
     /**
-     * \getter m_events.end(), constant version.
+     * \getter m_storage->end(), constant version.
      */
 
     const_iterator end () const
     {
-        return m_events.end();
+        return storage().end();
+    }
+
+    /**
+     * \getter m_storage->begin(), constant version for non-constant lists.
+     *      Read-only loops use this so that a list shared with a snapshot or
+     *      a copy is not unshared just to be walked.
+     */
+
+    const_iterator cbegin () const
+    {
+        return storage().begin();
+    }
+
+    /**
+     * \getter m_storage->end(), constant version for non-constant lists.
+     */
+
+    const_iterator cend () const
+    {
+        return storage().end();
     }
 
 #ifdef USE_FIND_IN_SEQUENCE_REMOVE      // EXPERIMENTAL
@@ -239,20 +323,20 @@ public:
 
     event_list::iterator find (const event & e)
     {
-        return m_events.find(e);
+        return storage().find(e);
     }
 
 #endif
 
     /**
-     *  Returns the number of events stored in m_events.  We like returning
+     *  Returns the number of events stored in m_storage.  We like returning
      *  an integer instead of size_t, and rename the function so nobody is
      *  fooled.
      */
 
     int count () const
     {
-        return int(m_events.size());
+        return int(storage().size());
     }
 
     midipulse get_length () const;
@@ -260,17 +344,18 @@ public:
     /**
      *  Returns true if there are no events.
      *
-     *  return m_events.size() == 0;
+     *  return m_storage->size() == 0;
      */
 
     bool empty () const
     {
-        return m_events.empty();
+        return storage().empty();
     }
 
+#ifdef SEQ64_USE_EVENT_MAP
+
     /**
-     *  Adds an event to the internal event list in an optionally sorted
-     *  manner.
+     *  Adds an event to the internal event multimap, which keeps it sorted.
      *
      * \param e
      *      Provides the event to be added to the list.
@@ -284,14 +369,14 @@ public:
 
     bool add (const event & e)
     {
-#ifdef SEQ64_USE_EVENT_MAP
         return append(e);
+    }
+
 #else
-        bool result = append(e);
-        sort();                         /* by time-stamp and "rank" */
-        return result;
+
+    bool add (const event & e);
+
 #endif
-    }
 
     bool append (const event & e);
 
@@ -317,7 +402,8 @@ public:
 
     void push_back (const event & e)
     {
-        m_events.push_back(e);
+        storage().push_back(e);
+        ++m_generation;
     }
 
 #endif
@@ -331,6 +417,15 @@ public:
         return m_is_modified;
     }
 
+    /**
+     * \getter m_generation
+     */
+
+    unsigned long generation () const
+    {
+        return m_generation;
+    }
+
     /**
      * \getter m_has_tempo
      */
@@ -371,8 +466,9 @@ public:
 
     void remove (iterator ie)
     {
-        m_events.erase(ie);
+        storage().erase(ie);
         m_is_modified = true;
+        ++m_generation;
     }
 
     /**
@@ -381,8 +477,13 @@ public:
 
     void clear ()
     {
-        m_events.clear();
+        if (m_storage.use_count() > 1)
+            m_storage = std::make_shared<Events>(Allocator(m_pool));
+        else
+            m_storage->clear();
+
         m_is_modified = true;
+        ++m_generation;
     }
 
     void merge (event_list & el, bool presort = true);
@@ -396,7 +497,8 @@ public:
 #ifdef SEQ64_USE_EVENT_MAP
         // we need nothin' for sorting a multimap
 #else
-        m_events.sort();
+        storage().sort();
+        ++m_generation;
 #endif
     }
 
@@ -439,6 +541,7 @@ private:                                // functions for friend sequence
      * involved data from the caller.
      */
 
+    void link_notes ();
     void link_new ();
     void clear_links ();
     void verify_and_link (midipulse slength);
@@ -458,12 +561,12 @@ private:                                // functions for friend sequence
     void print () const;
 
     /**
-     * \getter m_events
+     * \getter m_storage
      */
 
     const Events & events () const
     {
-        return m_events;
+        return storage();
     }
 
 };          // class event_list
@@ -0,0 +1,337 @@
+#ifndef SEQ64_EVENT_PACK_HPP
+#define SEQ64_EVENT_PACK_HPP
+
+/*
+ *  This file is part of seq24/sequencer64.
+ *
+ *  seq24 is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  seq24 is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with seq24; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          event_pack.hpp
+ *
+ *  This module declares a compact, flat copy of an event list, used for the
+ *  undo and redo stacks of a sequence.
+ *
+ * \library       sequencer64 application
+ * \author        Chris Ahlstrom
+ * \date          2017-09-06
+ * \updates       2017-09-06
+ * \license       GNU GPLv2 or above
+ *
+ *  The event class carries a SysEx vector, a link pointer, and a handful of
+ *  flags next to its three bytes of MIDI data.  Copying an event_list thus
+ *  allocates a list node per event, plus a vector for each SysEx or Meta
+ *  event.  The undo stack used to copy the whole event list on every edit.
+ *
+ *  An event_pack stores each event as a packed_event, a plain 16-byte
+ *  structure that can be copied with memcpy(), and keeps the SysEx and Meta
+ *  data bytes of all of the events in one byte arena, referenced by index.
+ *  Packing an event list makes three allocations, no matter how many events
+ *  it holds, and copying a pack is three block copies.
+ *
+ *  The undo history itself is an event_journal, which keeps only the newest
+ *  state whole, and each older state as the stretch of events that differs
+ *  from the state after it.
+ *
+ *  The links between Note On and Note Off events, and the selection flags,
+ *  are not saved.  The sequence relinks the events, and clears the
+ *  selection, after restoring them from an undo or redo pack.
+ */
+
+#include <cstddef>                      /* std::size_t                  */
+#include <deque>                        /* std::deque<>                 */
+#include <vector>                       /* std::vector<>                */
+
+#include "midibyte.hpp"                 /* midibyte, midipulse          */
+
+/**
+ *  Marks a packed_event that has no SysEx or Meta data bytes.
+ */
+
+#define SEQ64_NO_PAYLOAD                (~0U)
+
+/*
+ *  Do not document a namespace; it breaks Doxygen.
+ */
+
+namespace seq64
+{
+    class event_list;
+
+/**
+ *  Holds a packed copy of the events of an event_list, in the same order.
+ */
+
+class event_pack
+{
+
+public:
+
+    /**
+     *  Provides the MIDI part of an event, with no pointers and no
+     *  allocation.  The SysEx or Meta data bytes, if any, are kept in the
+     *  arena of the pack, and m_payload is the index of their span.
+     */
+
+    struct packed_event
+    {
+        midipulse m_timestamp;          /**< Tick of the event in pattern.  */
+        unsigned m_payload;             /**< Span index or SEQ64_NO_PAYLOAD.*/
+        midibyte m_status;              /**< Event code, channel cleared.   */
+        midibyte m_channel;             /**< Channel, or Meta event type.   */
+        midibyte m_data[2];             /**< The data bytes of the event.   */
+    };
+
+    /**
+     *  Locates the data bytes of one SysEx or Meta event in the arena.
+     */
+
+    struct span
+    {
+        unsigned m_offset;              /**< Index of the first byte.       */
+        unsigned m_size;                /**< The number of bytes.           */
+    };
+
+private:
+
+    /**
+     *  The packed events, in the order of the event list.
+     */
+
+    std::vector<packed_event> m_events;
+
+    /**
+     *  The spans of the SysEx and Meta data in m_arena.
+     */
+
+    std::vector<span> m_spans;
+
+    /**
+     *  The SysEx and Meta data bytes of all of the events, back to back.
+     */
+
+    std::vector<midibyte> m_arena;
+
+    /**
+     *  The modified-flag of the event list that was packed.
+     */
+
+    bool m_is_modified;
+
+public:
+
+    event_pack ();
+
+    /*
+     *  Not explicit, so that an event_list can be pushed directly onto a
+     *  stack of event_pack objects.
+     */
+
+    event_pack (const event_list & evl);
+    event_pack (const event_pack & src, int first, int count);
+
+    void unpack (event_list & evl) const;
+    void replace (int first, int count, const event_pack & middle);
+    bool same_event (int index, const event_pack & rhs, int rhsindex) const;
+    std::size_t bytes () const;
+
+    /**
+     * \getter m_events.size()
+     */
+
+    int count () const
+    {
+        return int(m_events.size());
+    }
+
+    /**
+     * \getter m_arena.size()
+     */
+
+    int payload_size () const
+    {
+        return int(m_arena.size());
+    }
+
+    /**
+     * \getter m_is_modified
+     */
+
+    bool is_modified () const
+    {
+        return m_is_modified;
+    }
+
+    /*
+     *  The compiler-generated copy constructor and principal assignment
+     *  operator copy the three vectors, each of which holds plain data.
+     */
+
+private:
+
+    void append_from (const event_pack & src, int first, int count);
+
+};
+
+/**
+ *  Provides the undo (or redo) history of the events of a sequence.  It
+ *  works like the std::stack of event lists it replaces: push() saves the
+ *  state of an event list, top() gets the newest saved state, and pop()
+ *  discards it.
+ *
+ *  Only the newest state is kept whole.  Each older state is kept as an
+ *  edit record: the range of events that differs from the next newer
+ *  state, and the events it held before.  Most edits change one stretch of
+ *  a pattern, so an undo step costs about as much memory as the events it
+ *  changed, not the whole pattern.  Popping a state applies the newest
+ *  record to the whole state to rebuild the one before it.
+ *
+ *  If a memory limit is set, the oldest states are dropped once the
+ *  journal grows past it.  The newest state is always kept.
+ *
+ *  Only the memory is saved, not the time.  The records are found by
+ *  comparing states, not recorded by the edit functions, so each push()
+ *  still packs and compares the whole event list, and each pop() rebuilds
+ *  the whole state.  Each edit thus still costs O(n) in the number of
+ *  events of the pattern, done once, in the user-interface thread.
+ */
+
+class event_journal
+{
+
+private:
+
+    /**
+     *  Changes a saved state back into the next older one: replace the
+     *  m_count events starting at m_first with m_events.
+     */
+
+    struct entry
+    {
+        int m_first;                    /**< Index of the first change.     */
+        int m_count;                    /**< Events to remove from there.   */
+        event_pack m_events;            /**< The events to put back.        */
+    };
+
+    /**
+     *  The edit records, oldest first.
+     */
+
+    std::deque<entry> m_entries;
+
+    /**
+     *  The newest saved state, kept whole.  Meaningful only if m_has_top is
+     *  true.
+     */
+
+    event_pack m_top;
+
+    /**
+     *  Indicates that at least one state is saved.
+     */
+
+    bool m_has_top;
+
+    /**
+     *  The approximate number of bytes used by the saved states.
+     */
+
+    std::size_t m_bytes;
+
+    /**
+     *  The memory limit in bytes; 0 means no limit.
+     */
+
+    std::size_t m_limit;
+
+    /**
+     *  Indicates that the newest state was pushed as the start of a group,
+     *  such as a run of step-entered notes, and that further pushes of the
+     *  same group are to be coalesced into it.
+     */
+
+    bool m_group_open;
+
+public:
+
+    event_journal ();
+
+    void push (const event_list & evl, bool group = false);
+    void pop ();
+    void limit (std::size_t bytes);
+
+    /**
+     *  Gets the newest saved state.  Not to be called when empty().
+     */
+
+    const event_pack & top () const
+    {
+        return m_top;
+    }
+
+    /**
+     * \getter m_has_top
+     */
+
+    bool empty () const
+    {
+        return ! m_has_top;
+    }
+
+    /**
+     *  Gets the number of states saved.
+     */
+
+    int size () const
+    {
+        return m_has_top ? int(m_entries.size()) + 1 : 0 ;
+    }
+
+    /**
+     * \getter m_bytes
+     */
+
+    std::size_t bytes () const
+    {
+        return m_bytes;
+    }
+
+    /**
+     *  Ends the current group, so that the next push, grouped or not, saves
+     *  a new state.
+     */
+
+    void end_group ()
+    {
+        m_group_open = false;
+    }
+
+private:
+
+    void trim ();
+
+};
+
+}           // namespace seq64
+
+#endif      // SEQ64_EVENT_PACK_HPP
+
+/*
+ * event_pack.hpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
+
@@ -0,0 +1,489 @@
+#ifndef SEQ64_EVENT_SNAPSHOT_HPP
+#define SEQ64_EVENT_SNAPSHOT_HPP
+
+/*
+ *  This file is part of seq24/sequencer64.
+ *
+ *  seq24 is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  seq24 is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with seq24; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          event_snapshot.hpp
+ *
+ *  This module declares an immutable, playable copy of the events of a
+ *  sequence, and the holder that publishes it to the output thread.
+ *
+ * \library       sequencer64 application
+ * \author        Chris Ahlstrom
+ * \date          2017-08-12
+ * \updates       2017-09-06
+ * \license       GNU GPLv2 or above
+ *
+ *  The editing side of a sequence (GUI, recording, file loading) owns the
+ *  event_list, and holds the sequence mutex while it changes it.  Some
+ *  edits (sorting, linking, quantizing, pasting) take a while, and the
+ *  output thread used to wait on the same mutex to walk the event list,
+ *  which caused late events while editing during playback.
+ *
+ *  Now, when an edit is done, the sequence builds an event_snapshot, a
+ *  flat copy of only the playable events, and publishes it by swapping a
+ *  pointer.  The output thread reads the current snapshot without taking
+ *  the sequence mutex.  A snapshot is never changed after it is published.
+ *  A retired snapshot is deleted by the editing side only after no reader
+ *  is left that could still be using it (a simple form of RCU, "read, copy,
+ *  update").
+ *
+ *  The snapshot is laid out as a structure of arrays: one array of time
+ *  stamps, and one of 32-bit words that each pack the status, channel, and
+ *  data bytes of an event.  The play loop and the binary search for the
+ *  next event tick read mostly the time stamps, which are contiguous, and
+ *  touch the word only for an event that is played.
+ */
+
+#include <atomic>                       /* std::atomic<>                */
+#include <vector>                       /* std::vector<>                */
+
+#include "app_limits.h"                 /* SEQ64_MIDI_COUNT_MAX         */
+#include "event.hpp"                    /* seq64::event, EVENT_ codes   */
+#include "midibyte.hpp"                 /* midibyte, midipulse, midibpm */
+
+/**
+ *  The velocity scale, in percent, that leaves the velocities alone.
+ */
+
+#define SEQ64_VELOCITY_SCALE_NONE       100
+
+/*
+ *  Do not document a namespace; it breaks Doxygen.
+ */
+
+namespace seq64
+{
+    class event_list;
+
+/**
+ *  Holds a read-only copy of the playable events of an event_list, in the
+ *  same (time-stamp) order.
+ */
+
+class event_snapshot
+{
+
+    friend class snapshot_holder;
+
+public:
+
+    /**
+     *  Packs the status byte (channel cleared) in bits 0 to 7, the channel
+     *  in bits 8 to 15, and the two data bytes in bits 16 to 31.  SysEx and
+     *  Meta events, except for Set Tempo, are not playable, and are left out
+     *  of the snapshot.  For a Set Tempo event, the data bits hold the index
+     *  of its tempo in the tempo array, so a snapshot holds at most 65536
+     *  tempo changes.
+     */
+
+    typedef unsigned word;
+
+private:
+
+    /**
+     *  The time stamps of the playable events, in order.
+     */
+
+    std::vector<midipulse> m_ticks;
+
+    /**
+     *  The packed events, parallel to m_ticks.
+     */
+
+    std::vector<word> m_words;
+
+    /**
+     *  The tempos of the Set Tempo events, in beats per minute.
+     */
+
+    std::vector<midibpm> m_tempos;
+
+    /**
+     *  A number unique to this snapshot for its holder, assigned when
+     *  the snapshot is published.  Lets the output thread tell if a play
+     *  cursor it saved still belongs to the current snapshot, even if a new
+     *  snapshot ends up at the address of a deleted one.
+     */
+
+    unsigned long m_serial;
+
+public:
+
+    event_snapshot (const event_list & evl);
+
+    /**
+     * \getter m_ticks.size()
+     */
+
+    int count () const
+    {
+        return int(m_ticks.size());
+    }
+
+    /**
+     * \getter m_ticks.empty()
+     */
+
+    bool empty () const
+    {
+        return m_ticks.empty();
+    }
+
+    /**
+     *  Provides the array of time stamps, for reading only.  Not to be
+     *  called if the snapshot is empty.
+     */
+
+    const midipulse * ticks () const
+    {
+        return &m_ticks[0];
+    }
+
+    /**
+     *  Provides the array of packed events, for reading only.  Not to be
+     *  called if the snapshot is empty.
+     */
+
+    const word * words () const
+    {
+        return &m_words[0];
+    }
+
+    /**
+     *  Gets the tempo of a Set Tempo word.
+     */
+
+    midibpm tempo (word w) const
+    {
+        return m_tempos[w >> 16];
+    }
+
+    /**
+     *  Packs the parts of an event into a word.
+     */
+
+    static word pack
+    (
+        midibyte status, midibyte channel, midibyte d0, midibyte d1
+    )
+    {
+        return word(status) | (word(channel) << 8) |
+            (word(d0) << 16) | (word(d1) << 24);
+    }
+
+    /**
+     *  Gets the status byte, with the channel cleared, from a word.
+     */
+
+    static midibyte status (word w)
+    {
+        return midibyte(w);
+    }
+
+    /**
+     *  Gets the channel from a word.
+     */
+
+    static midibyte channel (word w)
+    {
+        return midibyte(w >> 8);
+    }
+
+    /**
+     *  Gets the first data byte from a word.
+     */
+
+    static midibyte d0 (word w)
+    {
+        return midibyte(w >> 16);
+    }
+
+    /**
+     *  Gets the second data byte from a word.
+     */
+
+    static midibyte d1 (word w)
+    {
+        return midibyte(w >> 24);
+    }
+
+    /**
+     *  Tests for a Set Tempo word.  It is the only kind of Meta event
+     *  (status 0xFF) in a snapshot.
+     */
+
+    static bool is_tempo (word w)
+    {
+        return status(w) == EVENT_MIDI_META;
+    }
+
+    /**
+     *  Sets the status, channel, and data bytes of an event from a word.
+     *  The time stamp of the event is not touched.
+     */
+
+    static void unpack (word w, event & ev)
+    {
+        ev.set_status(status(w), channel(w));
+        ev.set_data(d0(w), d1(w));
+    }
+
+    /**
+     *  Transposes a Note On, Note Off, or Aftertouch word, as
+     *  event::transpose_note() does for an event.  A note that would go out
+     *  of range is left alone, and so is any other kind of word.
+     *
+     * \param w
+     *      The word to transpose.
+     *
+     * \param steps
+     *      The number of semitones to transpose by.
+     *
+     * \return
+     *      Returns the transposed word.
+     */
+
+    static word transposed (word w, int steps)
+    {
+        if (event::is_note_msg(status(w)))
+        {
+            int note = int(d0(w)) + steps;
+            if (note >= 0 && note < SEQ64_MIDI_COUNT_MAX)
+                w = (w & ~(word(0xFF) << 16)) | (word(note) << 16);
+        }
+        return w;
+    }
+
+    /**
+     * \getter m_serial
+     */
+
+    unsigned long serial () const
+    {
+        return m_serial;
+    }
+
+private:
+
+    event_snapshot (const event_snapshot &);                /* no copying   */
+    event_snapshot & operator = (const event_snapshot &);
+
+};
+
+/**
+ *  Holds the changes that playback makes to the events of a sequence as they
+ *  go to the buss: the song transpose, and a velocity scale.  It works on the
+ *  packed words of a snapshot, so applying it copies no event and allocates
+ *  nothing.  A new kind of change goes here, as a member and a step in
+ *  apply().
+ */
+
+class play_transform
+{
+
+private:
+
+    /**
+     *  The number of semitones to transpose the notes by.
+     */
+
+    int m_transpose;
+
+    /**
+     *  The scale applied to the velocity of Note On events, in percent.
+     */
+
+    int m_velocity_scale;
+
+public:
+
+    /**
+     *  Principal constructor.
+     *
+     * \param transpose
+     *      The number of semitones to transpose by.
+     *
+     * \param velocityscale
+     *      The velocity scale in percent.  SEQ64_VELOCITY_SCALE_NONE (100)
+     *      leaves the velocities alone.
+     */
+
+    play_transform (int transpose, int velocityscale)
+     :
+        m_transpose         (transpose),
+        m_velocity_scale    (velocityscale)
+    {
+        // Empty body
+    }
+
+    /**
+     *  Tells if the transform changes anything, so that the caller can skip
+     *  apply() in the usual case.
+     */
+
+    bool active () const
+    {
+        return
+            m_transpose != 0 || m_velocity_scale != SEQ64_VELOCITY_SCALE_NONE;
+    }
+
+    /**
+     *  Applies the transform to a packed event.  A Note On with a velocity
+     *  of 0 (a Note Off) keeps it, and a scaled velocity stays in the range
+     *  1 to 127.
+     *
+     * \param w
+     *      The word to change.
+     *
+     * \return
+     *      Returns the changed word.
+     */
+
+    event_snapshot::word apply (event_snapshot::word w) const
+    {
+        if (m_transpose != 0)
+            w = event_snapshot::transposed(w, m_transpose);
+
+        if (m_velocity_scale != SEQ64_VELOCITY_SCALE_NONE)
+        {
+            int velocity = int(event_snapshot::d1(w));
+            if (event_snapshot::status(w) == EVENT_NOTE_ON && velocity > 0)
+            {
+                velocity = velocity * m_velocity_scale / 100;
+                if (velocity < 1)
+                    velocity = 1;
+                else if (velocity > SEQ64_MAX_DATA_VALUE)
+                    velocity = SEQ64_MAX_DATA_VALUE;
+
+                w = (w & ~(event_snapshot::word(0xFF) << 24)) |
+                    (event_snapshot::word(velocity) << 24);
+            }
+        }
+        return w;
+    }
+
+};
+
+/**
+ *  Publishes event_snapshot objects to readers that take no lock.  There
+ *  is one writer at a time (the caller serializes the writers, e.g. with
+ *  the sequence mutex), and any number of readers.
+ *
+ *  A reader brackets its use of a snapshot with acquire() and release().
+ *  The writer swaps in a new snapshot with publish(), and keeps the old
+ *  one in a retired list.  Since a reader announces itself (increments
+ *  m_readers) before loading the current pointer, once the writer sees no
+ *  readers after the swap, no reader can still hold a retired snapshot, and
+ *  they can all be deleted.  Neither side ever waits on the other.
+ */
+
+class snapshot_holder
+{
+
+private:
+
+    /**
+     *  The snapshot that the readers see.  Null until the first snapshot is
+     *  published, which readers treat as an empty snapshot.
+     */
+
+    std::atomic<event_snapshot *> m_current;
+
+    /**
+     *  The number of readers between acquire() and release().
+     */
+
+    std::atomic<int> m_readers;
+
+    /**
+     *  Snapshots that have been replaced, but might still be in use by a
+     *  reader.  Touched only by the writer.
+     */
+
+    std::vector<event_snapshot *> m_retired;
+
+    /**
+     *  The serial number given to the next snapshot that is published.
+     *  Touched only by the writer.
+     */
+
+    unsigned long m_next_serial;
+
+public:
+
+    snapshot_holder ();
+    ~snapshot_holder ();
+
+    void publish (event_snapshot * snap);
+
+    /**
+     *  Provides the current snapshot to the writer.  Not for readers, who
+     *  must use acquire().
+     */
+
+    const event_snapshot * current () const
+    {
+        return m_current.load();
+    }
+
+    /**
+     *  Gets the current snapshot for reading.  It stays valid until
+     *  release() is called.  Lock-free and allocation-free.
+     *
+     * \return
+     *      Returns the current snapshot, which is a null pointer if none has
+     *      been published yet.
+     */
+
+    const event_snapshot * acquire ()
+    {
+        ++m_readers;
+        return m_current.load();
+    }
+
+    /**
+     *  Ends the use of the snapshot obtained by acquire().
+     */
+
+    void release ()
+    {
+        --m_readers;
+    }
+
+private:
+
+    void reclaim ();
+
+    snapshot_holder (const snapshot_holder &);              /* no copying   */
+    snapshot_holder & operator = (const snapshot_holder &);
+
+};
+
+}           // namespace seq64
+
+#endif      // SEQ64_EVENT_SNAPSHOT_HPP
+
+/*
+ * event_snapshot.hpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
+
@@ -36,11 +36,15 @@
  *  PortMidi.
  */
 
+#include <atomic>                       /* std::atomic<>                    */
 #include <vector>                       /* for channel-filtered recording   */
+#include <pthread.h>                    /* pthread_t, pthread_self()        */
 
+#include "app_limits.h"                 /* SEQ64_NULL_SEQUENCE              */
 #include "businfo.hpp"                  /* seq64::businfo & busarray        */
 #include "midibus_common.hpp"
 #include "mutex.hpp"
+#include "sysex_stream.hpp"             /* seq64::sysex_stream              */
 #include "user_midi_bus.hpp"
 
 /*
@@ -126,6 +130,207 @@ protected:
 
     midibpm m_beats_per_minute;
 
+    /**
+     *  The look-ahead, in milliseconds, of the scheduled output mode.  Zero
+     *  means that events are sent directly, as they are played.  Set only
+     *  if the MIDI API supports scheduling, via set_lookahead().
+     */
+
+    int m_lookahead;
+
+    /**
+     *  The tick of the output queue of the MIDI API, minus the performance
+     *  tick, at the start of the current output frame.  Added to the tick of
+     *  a scheduled event to get its queue tick.  Measured anew for every
+     *  frame, so that the two clocks cannot drift apart.
+     */
+
+    midipulse m_queue_offset;
+
+    /**
+     *  The tick of the output queue at the start of the current output
+     *  frame.  Scheduled events due before it have been sent.
+     */
+
+    midipulse m_queue_tick;
+
+    /**
+     *  The performance tick at the start of the current output frame, as
+     *  given to frame_start().  The events staged in the frame are due at or
+     *  before it.  Used only by the batching thread.
+     */
+
+    midipulse m_frame_tick;
+
+    /**
+     *  An event tag of the scheduled output mode:  the pattern it is lent
+     *  to, and the last queue tick at which an event of that pattern was
+     *  scheduled with it.
+     */
+
+    struct schedule_tag
+    {
+        int m_seq;                      /**< The pattern, or null if free.  */
+        midipulse m_last;               /**< Queue tick of its last event.  */
+    };
+
+    /**
+     *  The event tags, indexed by tag.  A pattern keeps its tag while it has
+     *  events pending in the queue, so that no two patterns with pending
+     *  events ever share a tag, and cancel_scheduled() removes only the
+     *  events of the pattern it is given.  Protected by m_mutex.
+     */
+
+    schedule_tag m_schedule_tags[SEQ64_SCHEDULE_TAGS];
+
+    /**
+     *  The tag lent to each pattern, indexed by pattern number, or -1 if
+     *  none.  Protected by m_mutex.
+     */
+
+    short m_pattern_tags[SEQ64_SEQUENCE_MAXIMUM];
+
+    /**
+     *  An event held back to be played later:  by the JACK process engine,
+     *  at a frame of the current cycle, or at the end of an output frame (see
+     *  batch_begin()), with the tick at which it was due.
+     */
+
+    struct staged_event
+    {
+        int m_frame;                    /**< Frame offset in the cycle.     */
+        midipulse m_tick;               /**< Tick due, in an output frame.  */
+        bussbyte m_bus;                 /**< The output buss.               */
+        midibyte m_status;              /**< Event code, channel cleared.   */
+        midibyte m_channel;             /**< The channel to play on.        */
+        midibyte m_data[2];             /**< The data bytes of the event.   */
+    };
+
+    /**
+     *  True if the playback engine runs in the process callback of the MIDI
+     *  API (JACK), rather than in the output thread.  Set by set_engine(),
+     *  before the engine starts, and not changed afterward.
+     */
+
+    bool m_engine;
+
+    /**
+     *  The function that renders a cycle in the engine mode (normally
+     *  perform::engine_callback()), and its argument.
+     */
+
+    engine_callback m_engine_callback;
+
+    /**
+     *  The argument passed to m_engine_callback.
+     */
+
+    void * m_engine_arg;
+
+    /**
+     *  The events of the current engine cycle, kept in frame order as they
+     *  are added.  Allocated once by set_engine(), and touched only by the
+     *  process thread afterward, so it needs no lock.
+     */
+
+    std::vector<staged_event> m_engine_events;
+
+    /**
+     *  The number of events in m_engine_events in the current cycle.
+     */
+
+    int m_engine_count;
+
+    /**
+     *  The number of events dropped because m_engine_events was full.
+     */
+
+    int m_engine_dropped;
+
+    /**
+     *  The number of frames in the current engine cycle.
+     */
+
+    int m_engine_frames;
+
+    /**
+     *  The (fractional) tick at frame 0 of the current engine cycle, and
+     *  the number of ticks per frame, as set by engine_window().  Used to
+     *  turn the tick of an event into its frame.
+     */
+
+    double m_engine_tick;
+
+    /**
+     *  The number of ticks per frame in the current engine cycle.
+     */
+
+    double m_engine_ticks_per_frame;
+
+    /**
+     *  The frame at which events played directly, with play(), go in the
+     *  current engine cycle.  Normally 0, the start of the cycle; moved by
+     *  engine_now(), as when the song loops back in the middle of a cycle.
+     */
+
+    int m_engine_now;
+
+    /**
+     *  True while the engine function runs, in the process thread, which is
+     *  m_engine_thread.  Atomic, since every thread that plays reads it,
+     *  via in_engine().
+     */
+
+    std::atomic<bool> m_engine_cycling;
+
+    /**
+     *  The process thread of the MIDI API, as seen by the last engine cycle.
+     */
+
+    std::atomic<pthread_t> m_engine_thread;
+
+    /**
+     *  True between batch_begin() and batch_end().  Meaningful only to the
+     *  thread that started the batch, m_batch_thread.  Atomic, since every
+     *  thread that plays reads it, via in_batch().
+     */
+
+    std::atomic<bool> m_batching;
+
+    /**
+     *  The thread that started the current batch.  Only this thread's calls
+     *  to play(), play_at(), and flush() are batched; other threads play
+     *  directly.  Atomic, like m_batching.
+     */
+
+    std::atomic<pthread_t> m_batch_thread;
+
+    /**
+     *  The events played by the batching thread in the current output frame,
+     *  in the order of the ticks at which they were due, and otherwise in the
+     *  order played.  Cleared, but not freed, by batch_end(), so that steady
+     *  playback does not allocate.
+     */
+
+    std::vector<staged_event> m_batch_events;
+
+    /**
+     *  How long, in microseconds, the last input event waited between its
+     *  arrival and the wakeup of the input thread that read it.  Set by
+     *  those MIDI APIs that stamp input events on arrival; otherwise 0.
+     *  Used only by the input thread.
+     */
+
+    long m_input_age;
+
+    /**
+     *  Assembles the SysEx input for the MIDI APIs, such as ALSA, whose
+     *  input arrives through the master buss rather than through each buss.
+     *  Used only by the input thread.
+     */
+
+    sysex_stream m_sysex_in;
+
     /**
      *  For dumping MIDI input to a sequence for recording.  This value is set
      *  to true when a sequence editor window is open and the user has
@@ -155,6 +360,32 @@ protected:
 
     sequence * m_seq;
 
+    /**
+     *  A MIDI thru route, from the input to the buss and channel of a
+     *  sequence whose thru button is on.  The route is used only while its
+     *  sequence is also the input target (see set_sequence_input()).  The
+     *  Note Ons passed through the route are counted, so that stray Note
+     *  Offs are not passed on, and so that sounding notes can be turned off
+     *  when the route is removed or its sequence stops taking the input.
+     */
+
+    struct thru_route
+    {
+        const sequence * m_seq;         /**< The sequence, used as a key.   */
+        bussbyte m_bus;                 /**< The output buss.               */
+        midibyte m_channel;             /**< The channel to play on.        */
+        midibyte m_notes[SEQ64_MIDI_NOTES_MAX]; /**< Notes now sounding.    */
+    };
+
+    /**
+     *  The thru routes, searched in order by thru(), the first one whose
+     *  sequence takes the input event being used.  Room for
+     *  SEQ64_THRU_ROUTES routes is reserved by the constructor.  Protected by
+     *  m_mutex.
+     */
+
+    std::vector<thru_route> m_thru_routes;
+
     /**
      *  The locking mutex.  This object is passed to an automutex object that
      *  lends exception-safety to the mutex locking.
@@ -277,6 +508,82 @@ public:
     void port_start (int client, int port);
     void port_exit (int client, int port);
     void play (bussbyte bus, event * e24, midibyte channel);
+    void play_at
+    (
+        bussbyte bus, event * e24, midibyte channel,
+        midipulse tick, int seq
+    );
+    bool set_lookahead (int ms);
+    bool set_engine (engine_callback cb, void * arg);
+    void engine_window (double tick, double ticks_per_frame);
+    void engine_now (midipulse tick);
+    void engine_clock (double start, midipulse tick);
+    bool try_init_clock (midipulse tick);
+    bool try_stop ();
+    bool try_beats_per_minute (midibpm bpm);
+
+    /**
+     * \getter m_engine
+     */
+
+    bool engine () const
+    {
+        return m_engine;
+    }
+
+    /**
+     * \getter m_engine_dropped
+     */
+
+    int engine_dropped () const
+    {
+        return m_engine_dropped;
+    }
+
+    midipulse frame_start (midipulse tick);
+    void cancel_scheduled (int seq = SEQ64_NULL_SEQUENCE);
+    void batch_begin ();
+    void batch_end ();
+
+    /**
+     *  Tells if the calling thread is batching its output.
+     */
+
+    bool in_batch () const
+    {
+        return m_batching &&
+            pthread_equal(m_batch_thread.load(), pthread_self()) != 0;
+    }
+
+    /**
+     *  Tells if the calling thread is the engine, in the middle of a cycle,
+     *  and so must not wait on a lock.
+     */
+
+    bool in_engine () const
+    {
+        return m_engine_cycling &&
+            pthread_equal(m_engine_thread.load(), pthread_self()) != 0;
+    }
+
+    /**
+     * \getter m_lookahead
+     */
+
+    int lookahead () const
+    {
+        return m_lookahead;
+    }
+
+    /**
+     * \getter m_lookahead, as a boolean.
+     */
+
+    bool scheduled () const
+    {
+        return m_lookahead > 0;
+    }
+
     void continue_from (midipulse tick);
     void init_clock (midipulse tick);
     void emit_clock (midipulse tick);
@@ -284,6 +591,9 @@ public:
     void print () const;
     void flush ();
     void set_sequence_input (bool state, sequence * seq);
+    void set_thru_route (const sequence * seq, bussbyte bus, midibyte channel);
+    void clear_thru_route (const sequence * seq);
+    bool thru (event & ev);
     void dump_midi_input (event in);                    /* seq32 function */
     bool initialize_buses ();
 
@@ -293,12 +603,14 @@ public:
     int poll_for_midi ();
     bool is_more_input ();
     bool get_midi_event (event * in);
+    midipulse input_age_ticks () const;
 
     bool set_clock (bussbyte bus, clock_e clock_type);
     bool set_input (bussbyte bus, bool inputing);
     bool get_input (bussbyte bus);
     bool is_input_system_port (bussbyte bus);
     clock_e get_clock (bussbyte bus);
+    bool clocking ();
 
     void set_ppqn (int ppqn);
     void set_beats_per_minute (midibpm bpm);
@@ -326,6 +638,17 @@ protected:
         return bus < int(m_master_inputs.size()) ? m_master_inputs[bus] : false ;
     }
 
+    /**
+     * \setter m_input_age
+     *      Called by api_get_midi_event().  A negative age, for an event that
+     *      arrived after the wakeup, is taken as 0.
+     */
+
+    void set_input_age (long us)
+    {
+        m_input_age = us > 0 ? us : 0 ;
+    }
+
     /**
      *  Initializes and ctivates the busses, in a partly API-dependent manner.
      *  Currently re-implemented only in the rtmidi JACK API.
@@ -422,6 +745,52 @@ protected:
         // no code for portmidi
     }
 
+    /**
+     *  Prepares the API for the scheduled output mode, if it can support
+     *  it.  Only the ALSA implementation does so far.
+     *
+     * \return
+     *      Returns true if events can be scheduled.
+     */
+
+    virtual bool api_set_lookahead (int /* ms */)
+    {
+        return false;
+    }
+
+    /**
+     *  Provides the current tick of the output queue, for scheduling.
+     */
+
+    virtual midipulse api_queue_tick ()
+    {
+        return 0;
+    }
+
+    /**
+     *  Removes scheduled events that have not been sent yet.  See
+     *  cancel_scheduled().  The parameter is the event tag, or -1 for all
+     *  events.
+     */
+
+    virtual void api_cancel_scheduled (int /* tag */)
+    {
+        // no code for base, rtmidi, or portmidi
+    }
+
+    /**
+     *  Makes the MIDI API call the given function once per process cycle,
+     *  for the engine mode.  Only the JACK implementation can do so.
+     *
+     * \return
+     *      Returns true if the function will be called.
+     */
+
+    virtual bool api_set_engine (engine_callback /* cb */, void * /* arg */)
+    {
+        return false;
+    }
+
     virtual bool api_is_more_input () = 0;
     virtual bool api_get_midi_event (event * inev) = 0;
     virtual int api_poll_for_midi () = 0;
@@ -439,8 +808,26 @@ protected:
 
 private:
 
+    static void engine_process (void * arg, int nframes, int rate);
+    void engine_cycle (int nframes, int rate);
+    void engine_add
+    (
+        bussbyte bus, event * e24, midibyte channel, midipulse tick
+    );
+    void engine_insert
+    (
+        bussbyte bus, event * e24, midibyte channel, int frame
+    );
+    void batch_stage
+    (
+        bussbyte bus, event * e24, midibyte channel, midipulse tick
+    );
     bool save_clock (bussbyte bus, clock_e clock);
     bool save_input (bussbyte bus, bool inputing);
+    bool is_input_target (const sequence * seq) const;
+    int pattern_tag (int seq, midipulse qtick);
+    void clear_schedule_tags ();
+    bool release_thru_notes (thru_route & route);
 #if 0
     void swap ();
 #endif
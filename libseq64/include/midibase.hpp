@@ -39,6 +39,7 @@
 #include "easy_macros.h"                /* for autoconf header files    */
 #include "mutex.hpp"
 #include "midibus_common.hpp"
+#include "sysex_stream.hpp"             /* seq64::sysex_stream          */
 
 /*
  *  Do not document a namespace; it breaks Doxygen.
@@ -183,6 +184,29 @@ private:
 
     mutex m_mutex;
 
+    /**
+     *  Assembles the SysEx input of the buss, for the MIDI APIs that read
+     *  input per buss, and paces and counts its SysEx output.
+     */
+
+    sysex_stream m_sysex;
+
+    /**
+     *  Lets one SysEx message at a time be sent.  A message is sent in
+     *  pieces, and m_mutex (and the master-buss lock) is held only while
+     *  each piece is sent, so that a long dump does not hold up playback.
+     */
+
+    mutex m_sysex_mutex;
+
+    /**
+     *  How long, in microseconds, the last event read by get_midi_event()
+     *  waited between its arrival and being read.  Set by those MIDI APIs
+     *  that stamp input on arrival (JACK); otherwise 0.
+     */
+
+    long m_input_age;
+
 public:
 
     midibase
@@ -477,16 +501,59 @@ public:
     bool init_out_sub ();
     bool init_in_sub ();
     void play (event * e24, midibyte channel);
-    void sysex (event * e24);
+    void play_at (event * e24, midibyte channel, midipulse tick, int tag);
+    void play_frame (event * e24, midibyte channel, int frame);
+    void play_due (event * e24, midibyte channel, long ago_us);
+    void sysex (event * e24, const mutex * master = nullptr);
     void flush ();
     void start ();
     void stop ();
     void clock (midipulse tick);
+    midipulse next_clock (midipulse tick);
     void continue_from (midipulse tick);
     void init_clock (midipulse tick);
     void print ();
     bool set_input (bool inputing);
 
+    /**
+     * \getter m_sysex
+     *      Used by the MIDI APIs to assemble SysEx input, and to report the
+     *      SysEx statistics of the buss.
+     */
+
+    sysex_stream & sysex_io ()
+    {
+        return m_sysex;
+    }
+
+    /**
+     * \getter m_sysex const version
+     */
+
+    const sysex_stream & sysex_io () const
+    {
+        return m_sysex;
+    }
+
+    /**
+     * \getter m_input_age
+     */
+
+    long input_age () const
+    {
+        return m_input_age;
+    }
+
+    /**
+     * \setter m_input_age
+     *      Used by the MIDI APIs, when they read an input event.
+     */
+
+    void set_input_age (long us)
+    {
+        m_input_age = us > 0 ? us : 0 ;
+    }
+
 protected:
 
     /**
@@ -577,14 +644,64 @@ protected:
     virtual void api_play (event * e24, midibyte channel) = 0;
 
     /**
-     *  Handles implementation details for SysEx messages.
+     *  Handles implementation details for scheduled playing.  An API that
+     *  has no output queue just plays the event directly.  The \a tick
+     *  (queue tick) and \a tag (event tag) parameters are then unused.
+     */
+
+    virtual void api_play_at
+    (
+        event * e24, midibyte channel, midipulse /* tick */, int /* tag */
+    )
+    {
+        api_play(e24, channel);
+    }
+
+    /**
+     *  Handles implementation details for playing an event at a frame of the
+     *  current process cycle, in the engine mode.  An API that has no
+     *  process cycle just plays the event directly.  The \a frame parameter
+     *  is then unused.
+     */
+
+    virtual void api_play_frame
+    (
+        event * e24, midibyte channel, int /* frame */
+    )
+    {
+        api_play(e24, channel);
+    }
+
+    /**
+     *  Handles implementation details for playing an event that was due a
+     *  little while ago, in the direct output mode.  An API that cannot
+     *  stamp its output with a time just plays the event now.  The \a ago_us
+     *  parameter is then unused.
+     */
+
+    virtual void api_play_due
+    (
+        event * e24, midibyte channel, long /* ago_us */
+    )
+    {
+        api_play(e24, channel);
+    }
+
+    /**
+     *  Handles implementation details for SysEx messages.  Sends one piece
+     *  of a message (see sysex()), waiting for room in the output buffer of
+     *  the MIDI API if need be.
+     *
+     *  The \a data and \a len parameters, the bytes of the piece, are
+     *  unused here.
      *
-     *  The \a e24 parameter, the SysEx event pointer, is unused here.
+     * \return
+     *      Returns false, as the piece is not sent.
      */
 
-    virtual void api_sysex (event * /* e24 */)
+    virtual bool api_sysex (const midibyte * /* data */, int /* len */)
     {
-        // no code for portmidi
+        return false;                   // no code for portmidi
     }
 
     /**
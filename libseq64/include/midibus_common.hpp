@@ -28,7 +28,7 @@
  * \library       sequencer64 application
  * \author        Chris Ahlstrom
  * \date          2015-07-24
- * \updates       2016-06-11
+ * \updates       2017-08-22
  * \license       GNU GPLv2 or above
  *
  */
@@ -69,6 +69,16 @@ const int c_midibus_input_size  = 0x100000;     // 1048576
 
 const int c_midibus_sysex_chunk = 0x100;        //     256
 
+/**
+ *  The function that a MIDI API with its own real-time process cycle (JACK)
+ *  calls once per cycle when the playback engine runs in that cycle; see
+ *  mastermidibase::set_engine().  The parameters are the object that
+ *  registered the function, the number of frames in the cycle, and the
+ *  sample rate.
+ */
+
+typedef void (* engine_callback) (void * arg, int nframes, int rate);
+
 /**
  *  A clock enumeration, as used in the File / Options / MIDI Clock dialog.
  *  This enumeration was also defined in midibus_portmidi.h, but we put it
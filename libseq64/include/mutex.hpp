@@ -40,6 +40,7 @@
  */
 
 #include <pthread.h>
+#include <time.h>                       /* struct timespec                  */
 
 /*
  *  Do not document a namespace; it breaks Doxygen.
@@ -79,6 +80,7 @@ public:
 
     mutex ();
     void lock () const;
+    bool try_lock () const;
     void unlock () const;
 
 };
@@ -159,7 +161,9 @@ private:
 public:
 
     condition_var ();
+    ~condition_var ();
     void wait ();
+    bool wait_until (const struct timespec & deadline);
     void signal ();
 
 };
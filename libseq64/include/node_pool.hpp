@@ -0,0 +1,311 @@
+#ifndef SEQ64_NODE_POOL_HPP
+#define SEQ64_NODE_POOL_HPP
+
+/*
+ *  This file is part of seq24/sequencer64.
+ *
+ *  seq24 is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  seq24 is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with seq24; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          node_pool.hpp
+ *
+ *  This module declares a pool of fixed-size memory blocks, and the
+ *  allocator that lets the standard containers of a sequence take their
+ *  nodes from it.
+ *
+ * \library       sequencer64 application
+ * \author        Chris Ahlstrom
+ * \date          2017-09-06
+ * \updates       2017-09-06
+ * \license       GNU GPLv2 or above
+ *
+ *  The events and triggers of a sequence are kept in std::list containers,
+ *  which allocate each node separately.  Reading a large MIDI file, pasting,
+ *  quantizing, restoring an undo state, and clearing the patterns thus
+ *  make and free one small heap block per event.
+ *
+ *  A node_pool carves its blocks out of large chunks, and keeps the freed
+ *  blocks on a free list for reuse.  Each sequence has a pool for its event
+ *  nodes, and its triggers object has a pool for the trigger nodes.  The
+ *  chunks are freed all at once when the pool goes away, or when
+ *  release() finds that no block is in use.
+ *
+ *  A container refers to its pool through a pool_allocator, which holds a
+ *  shared pointer, so that a copy of the events (e.g. the clipboard) can
+ *  outlive the sequence that made it.  Such copies can be used from other
+ *  threads, so the pool has its own lock.
+ */
+
+#include <cstddef>                      /* std::size_t                  */
+#include <memory>                       /* std::shared_ptr<>            */
+#include <new>                          /* ::operator new()             */
+#include <type_traits>                  /* std::true_type               */
+#include <vector>                       /* std::vector<>                */
+
+#include "mutex.hpp"                    /* seq64::mutex, automutex      */
+
+/*
+ *  Do not document a namespace; it breaks Doxygen.
+ */
+
+namespace seq64
+{
+
+/**
+ *  Provides blocks of one size, the size of the first block asked for.
+ *  Blocks of any other size are passed on to the global operator new().
+ */
+
+class node_pool
+{
+
+private:
+
+    /**
+     *  The blocks that have been freed, linked through their first bytes.
+     */
+
+    struct free_block
+    {
+        free_block * m_next;            /**< The next free block, or null.  */
+    };
+
+    /**
+     *  Serializes the users of the pool.
+     */
+
+    mutex m_mutex;
+
+    /**
+     *  The chunks of memory the blocks are carved from.
+     */
+
+    std::vector<char *> m_chunks;
+
+    /**
+     *  The head of the list of freed blocks.
+     */
+
+    free_block * m_free;
+
+    /**
+     *  The part of the newest chunk that has not yet been handed out, and
+     *  its end.
+     */
+
+    char * m_fresh;
+    char * m_fresh_end;
+
+    /**
+     *  The size asked for by the callers, fixed by the first allocation.
+     *  0 until then.
+     */
+
+    std::size_t m_request_size;
+
+    /**
+     *  The size of a block, the request size rounded up for alignment.
+     */
+
+    std::size_t m_block_size;
+
+    /**
+     *  The number of blocks in the next chunk.  It doubles with each chunk,
+     *  up to a limit, so that small patterns do not tie up much memory.
+     */
+
+    std::size_t m_chunk_blocks;
+
+    /**
+     *  The number of blocks handed out and not yet returned.
+     */
+
+    std::size_t m_in_use;
+
+public:
+
+    node_pool ();
+    ~node_pool ();
+
+    void * allocate (std::size_t bytes);
+    void deallocate (void * p, std::size_t bytes);
+    void release ();
+
+    /**
+     * \getter m_in_use
+     */
+
+    std::size_t in_use () const
+    {
+        return m_in_use;
+    }
+
+    /**
+     * \getter m_chunks.size()
+     */
+
+    int chunk_count () const
+    {
+        return int(m_chunks.size());
+    }
+
+private:
+
+    void free_chunks ();
+
+    node_pool (const node_pool &);                          /* no copying   */
+    node_pool & operator = (const node_pool &);
+
+};
+
+/**
+ *  A standard allocator that takes single nodes from a node_pool.  Arrays,
+ *  and all allocations by an allocator with no pool, go to the global
+ *  operator new().
+ *
+ *  Swapping two containers swaps their allocators as well.  Assigning one
+ *  container to another keeps the pool of the target, so the nodes of a
+ *  sequence stay in its own pool.
+ */
+
+template <typename T>
+class pool_allocator
+{
+
+    template <typename U> friend class pool_allocator;
+
+public:
+
+    typedef T value_type;
+    typedef std::true_type propagate_on_container_swap;
+
+    /**
+     *  Needed by older standard libraries that do not yet use
+     *  std::allocator_traits.
+     */
+
+    template <typename U>
+    struct rebind
+    {
+        typedef pool_allocator<U> other;
+    };
+
+private:
+
+    /**
+     *  The pool shared by all copies of this allocator.  Can be null.
+     */
+
+    std::shared_ptr<node_pool> m_pool;
+
+public:
+
+    /**
+     *  Default constructor.  The allocator has no pool.
+     */
+
+    pool_allocator () : m_pool ()
+    {
+        // Empty body
+    }
+
+    /**
+     *  Principal constructor.
+     *
+     * \param pool
+     *      The pool to take nodes from.
+     */
+
+    explicit pool_allocator (const std::shared_ptr<node_pool> & pool)
+     :
+        m_pool  (pool)
+    {
+        // Empty body
+    }
+
+    /**
+     *  Rebinding constructor, used by the containers to make an allocator
+     *  for their node type.
+     */
+
+    template <typename U>
+    pool_allocator (const pool_allocator<U> & rhs) : m_pool (rhs.m_pool)
+    {
+        // Empty body
+    }
+
+    /**
+     *  Allocates memory for n objects.
+     */
+
+    T * allocate (std::size_t n)
+    {
+        if (m_pool && n == 1)
+            return static_cast<T *>(m_pool->allocate(sizeof(T)));
+        else
+            return static_cast<T *>(::operator new(n * sizeof(T)));
+    }
+
+    /**
+     *  Frees memory for n objects obtained from allocate().
+     */
+
+    void deallocate (T * p, std::size_t n)
+    {
+        if (m_pool && n == 1)
+            m_pool->deallocate(p, sizeof(T));
+        else
+            ::operator delete(p);
+    }
+
+    /**
+     * \getter m_pool
+     */
+
+    const std::shared_ptr<node_pool> & pool () const
+    {
+        return m_pool;
+    }
+
+    /**
+     *  Two allocators are equal if memory from one can be freed by the
+     *  other; that is, if they share the same pool.
+     */
+
+    template <typename U>
+    bool operator == (const pool_allocator<U> & rhs) const
+    {
+        return m_pool == rhs.m_pool;
+    }
+
+    template <typename U>
+    bool operator != (const pool_allocator<U> & rhs) const
+    {
+        return m_pool != rhs.m_pool;
+    }
+
+};
+
+}           // namespace seq64
+
+#endif      // SEQ64_NODE_POOL_HPP
+
+/*
+ * node_pool.hpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
+
@@ -53,6 +53,8 @@
  *  handle_midi_control_ex().
  */
 
+#include <atomic>                       /* std::atomic<bool>                */
+#include <deque>                        /* std::deque                       */
 #include <vector>                       /* std::vector                      */
 #include <pthread.h>                    /* pthread_t C structure            */
 
@@ -62,6 +64,7 @@
 #include "keys_perform.hpp"             /* seq64::keys_perform              */
 #include "mastermidibus.hpp"            /* seq64::mastermidibus for ALSA    */
 #include "midi_control.hpp"             /* seq64::midi_control "struct"     */
+#include "mutex.hpp"                    /* seq64::mutex, automutex          */
 #include "sequence.hpp"                 /* seq64::sequence                  */
 
 /**
@@ -200,6 +203,53 @@ class perform
 
 public:
 
+    /**
+     *  Reads the packed list of active sequences, m_active_seqs[], without
+     *  a lock.  While this object exists, the copy of the list it reads, and
+     *  the sequences in that copy, are neither changed nor deleted.  It
+     *  should be short-lived, and the thread that holds it must not make a
+     *  sequence active or inactive, or it would wait for itself.
+     *
+\verbatim
+        perform::active_list active(*this);
+        for (int i = 0; i < active.count(); ++i)
+            active[i]->play_queue(tick, m_playback_mode);
+\endverbatim
+     */
+
+    class active_list
+    {
+
+    private:
+
+        const perform & m_perf;
+        int m_index;
+
+    public:
+
+        active_list (const perform & p) : m_perf (p), m_index (0)
+        {
+            ++m_perf.m_active_readers;
+            m_index = m_perf.m_active_index;
+        }
+
+        ~active_list ()
+        {
+            --m_perf.m_active_readers;
+        }
+
+        int count () const
+        {
+            return m_perf.m_active_count[m_index];
+        }
+
+        sequence * operator [] (int i) const
+        {
+            return m_perf.m_active_seqs[m_index][i];
+        }
+
+    };
+
     /**
      *  Provides settings for tempo recording.  Currently not used, though the
      *  functionality of logging and recording tempo is in place.
@@ -427,6 +477,49 @@ private:
 
     bool m_seqs_active[c_max_sequence];
 
+    /**
+     *  The active sequences, packed at the front of the array in order of
+     *  sequence number, so that the functions called for every output frame
+     *  (play(), set_orig_ticks(), and so on) do not have to skip over the
+     *  empty slots of every screen-set.  Kept in step with m_seqs_active[]
+     *  by set_active().
+     *
+     *  There are two copies of the list.  The readers, which include the
+     *  output thread and the JACK engine, use the one named by
+     *  m_active_index, without a lock, through an active_list object.  A
+     *  change is made in the other copy, which is then published by
+     *  switching m_active_index; the writer then waits until no reader is
+     *  left (see publish_active()) before the old copy, or a sequence
+     *  removed from the list, can be touched again.
+     */
+
+    sequence * m_active_seqs[2][c_max_sequence];
+
+    /**
+     *  The number of sequences in each copy of m_active_seqs[].
+     */
+
+    int m_active_count[2];
+
+    /**
+     *  The copy of m_active_seqs[] that readers use.
+     */
+
+    std::atomic<int> m_active_index;
+
+    /**
+     *  The number of active_list objects now reading m_active_seqs[].
+     */
+
+    mutable std::atomic<int> m_active_readers;
+
+    /**
+     *  Keeps the writers of m_active_seqs[] in line, one at a time.  Readers
+     *  never take it.
+     */
+
+    mutex m_active_mutex;
+
     /**
      *  Each boolean value in this array is set to true if a sequence was
      *  active, meaning that it was found to be active at the time we were
@@ -750,6 +843,62 @@ private:
 
     bool m_dont_reset_ticks;
 
+    /**
+     *  Used by the JACK process engine (see engine_cycle()).  False until
+     *  the first cycle after playback starts, which sets the starting
+     *  position.
+     */
+
+    bool m_engine_rolling;
+
+    /**
+     *  The tick, with its fraction, at the start of the next JACK process
+     *  engine cycle.  Keeping the fraction avoids the drift that rounding
+     *  each cycle to whole ticks would cause.
+     */
+
+    double m_engine_tick;
+
+    /**
+     *  The MIDI clock position, in ticks, at the start of the next JACK
+     *  process engine cycle.  Unlike m_engine_tick, it does not go back when
+     *  the song loops, so the clock does not stall.
+     */
+
+    double m_engine_clock;
+
+    /**
+     *  A tempo set by the JACK process engine (for example, by a Set Tempo
+     *  event of a pattern), which is applied at the start of a later cycle
+     *  (see engine_tempo()), so that the engine does not wait on the lock
+     *  of the master buss.  Zero if there is none.
+     */
+
+    midibpm m_engine_bpm;
+
+    /**
+     *  The period, in microseconds, between the last two wakeup deadlines of
+     *  output_func().  Normally the trigger width, but shorter when the MIDI
+     *  clock needs it.
+     */
+
+    long m_output_period_us;
+
+    /**
+     *  The number of times output_func() woke up (or found its deadline
+     *  already past) more than SEQ64_LATE_WAKEUP_US after its deadline.
+     *  Reset when playback starts.
+     */
+
+    long m_output_late_count;
+
+    /**
+     *  The worst lateness, in microseconds, of an output_func() wakeup since
+     *  playback started.
+     */
+
+    long m_output_worst_late_us;
+
 private:
 
     /**
@@ -898,6 +1047,30 @@ private:
 
     condition_var m_condition_var;
 
+    /**
+     *  Lets the output thread sleep past its usual period, until the next
+     *  event it has to play, while still being woken up early by
+     *  wake_output() when something changes.
+     */
+
+    condition_var m_wake_var;
+
+    /**
+     *  Set by wake_output(), and cleared by the output thread just before
+     *  it works out how long it can sleep.  If set when the thread goes to
+     *  sleep, the sleep is skipped.
+     */
+
+    std::atomic<bool> m_output_wake;
+
+    /**
+     *  True while the output thread is waiting on m_wake_var.  Lets
+     *  wake_output() skip the lock and signal when it is not needed, as
+     *  when called by the output thread itself.
+     */
+
+    std::atomic<bool> m_output_sleeping;
+
 #ifdef SEQ64_JACK_SUPPORT
 
     /**
@@ -922,11 +1095,29 @@ private:
     bool m_have_undo;
 
     /**
-     *  Holds the "track" numbers or the "all tracks" values for undo
-     *  operations.  See the push_trigger_undo() function.
+     *  One entry of the trigger journal: the triggers of a track before an
+     *  edit (in the undo history) or before an undo (in the redo history).
+     */
+
+    struct trigger_change
+    {
+        int m_track;                    /**< The track that changed.        */
+        triggers::List m_triggers;      /**< The triggers to put back.      */
+    };
+
+    /**
+     *  The changes made by one song-editor gesture, one undo step.
      */
 
-    std::vector<int> m_undo_vect;
+    typedef std::vector<trigger_change> TriggerRecord;
+
+    /**
+     *  Holds the trigger undo history, oldest first.  Each record holds only
+     *  the tracks whose triggers the gesture changed.  See the
+     *  push_trigger_undo() function.
+     */
+
+    std::deque<TriggerRecord> m_undo_vect;
 
     /*
      * Used for redo track modification support.
@@ -935,11 +1126,26 @@ private:
     bool m_have_redo;
 
     /**
-     *  Holds the "track" numbers or the "all tracks" values for redo
-     *  operations.  See the pop_trigger_undo() function.
+     *  Holds the trigger redo history.  See the pop_trigger_undo() function.
+     */
+
+    std::deque<TriggerRecord> m_redo_vect;
+
+    /**
+     *  Indicates that the newest undo record is still collecting the changes
+     *  of the current gesture.  The changes are found, by comparing each
+     *  track with its saved triggers, only when the next undo step is
+     *  pushed, or an undo or redo is done.
+     */
+
+    bool m_undo_record_open;
+
+    /**
+     *  The approximate number of bytes used by the trigger undo history,
+     *  kept within the "[undo-memory-limit]" option.
      */
 
-    std::vector<int> m_redo_vect;
+    std::size_t m_undo_bytes;
 
     /*
      *  Can register here for events.  Used in mainwnd and perform.
@@ -978,6 +1184,7 @@ public:
     void modify ()
     {
         m_is_modified = true;
+        wake_output();
     }
 
     /**
@@ -1477,6 +1684,7 @@ public:
     void set_reposition (bool postype = true)
     {
         m_reposition = postype;
+        wake_output();
     }
 
     /**
@@ -1574,6 +1782,33 @@ public:
         return m_jack_tick;
     }
 
+    /**
+     * \getter m_output_period_us
+     */
+
+    long output_period_us () const
+    {
+        return m_output_period_us;
+    }
+
+    /**
+     * \getter m_output_late_count
+     */
+
+    long output_late_count () const
+    {
+        return m_output_late_count;
+    }
+
+    /**
+     * \getter m_output_worst_late_us
+     */
+
+    long output_worst_late_us () const
+    {
+        return m_output_worst_late_us;
+    }
+
     /**
      * \setter m_jack_tick
      *
@@ -1756,6 +1991,12 @@ public:
     void toggle_playing_tracks ();
     void mute_screenset (int ss, bool flag = true);
     void output_func ();
+    void wake_output ();
+    static void engine_func (void * arg, int nframes, int rate);
+    void engine_cycle (int nframes, int rate);
+    void engine_play (midipulse tick);
+    void engine_seek (midipulse tick, bool stop);
+    void engine_tempo ();
     void input_func ();
     void set_group_mute_state (int gtrack, bool muted);
     bool get_group_mute_state (int gtrack);
@@ -2176,6 +2417,10 @@ private:
 
     void split_trigger (int seqnum, midipulse tick);
     midipulse get_max_trigger ();
+    static std::size_t change_bytes (const triggers::List & trigs);
+    void collect_trigger_changes ();
+    void forget_trigger_changes (int track);
+    void trim_trigger_undo ();
 
     /**
      *  Convenience function for perfedit's collapse functionality.
@@ -2336,6 +2581,7 @@ private:
     void set_looping (bool looping)
     {
         m_looping = looping;
+        wake_output();
     }
 
     int max_active_set () const;
@@ -2464,6 +2710,7 @@ private:
     void set_running (bool running)
     {
         m_running = running;
+        wake_output();
     }
 
     /**
@@ -2507,6 +2754,9 @@ private:
     bool is_seq_valid (int seq) const;
     bool is_mseq_valid (int seq) const;
     bool install_sequence (sequence * seq, int seqnum);
+    void add_active (int seq);
+    void remove_active (int seq);
+    void publish_active (int next);
     void inner_start (bool state);
     void inner_stop (bool midiclock = false);
     int clamp_track (int track) const;
@@ -2557,6 +2807,7 @@ private:
 private:
 
     bool log_current_tempo ();
+    long output_idle_us (const jack_scratchpad & pad, midibpm bpm);
     bool create_master_bus ();
 
     /**
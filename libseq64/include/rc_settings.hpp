@@ -213,6 +213,48 @@ private:
 
     int m_tempo_track_number;
 
+    /**
+     *  The look-ahead, in milliseconds, of the scheduled output mode.  If
+     *  non-zero, the events of each output frame are rendered this far
+     *  ahead of time, and scheduled on the output queue of the MIDI API at
+     *  their exact time, instead of being sent directly.  Only the ALSA
+     *  implementation supports it.  The default is 0 (direct output).
+     */
+
+    int m_output_lookahead;
+
+    /**
+     *  If true, and native JACK MIDI is in use, the playback engine runs in
+     *  the JACK process callback, which renders the events of each cycle
+     *  straight into the JACK port buffers.  The output thread is not used.
+     *  The default is false.
+     */
+
+    bool m_jack_engine;
+
+    /**
+     *  The memory limit, in kilobytes, of the undo history (and of the redo
+     *  history) of each pattern.  Once a history grows past it, its oldest
+     *  steps are dropped.  0 means no limit.
+     */
+
+    int m_undo_memory_limit;
+
+    /**
+     *  The size, in bytes, of the pieces an outgoing SysEx message is sent
+     *  in.  The default is SEQ64_SYSEX_CHUNK_DEFAULT.
+     */
+
+    int m_sysex_chunk;
+
+    /**
+     *  The rate, in bytes per second, at which outgoing SysEx messages are
+     *  paced, so as not to overrun slow devices.  0 means no pacing.  The
+     *  default is SEQ64_SYSEX_RATE_DEFAULT, the rate of a DIN MIDI cable.
+     */
+
+    int m_sysex_rate;
+
 public:
 
     rc_settings ();
@@ -540,6 +582,51 @@ public:
         return m_tempo_track_number;
     }
 
+    /**
+     * \getter m_output_lookahead
+     */
+
+    int output_lookahead () const
+    {
+        return m_output_lookahead;
+    }
+
+    /**
+     * \getter m_jack_engine
+     */
+
+    bool jack_engine () const
+    {
+        return m_jack_engine;
+    }
+
+    /**
+     * \getter m_undo_memory_limit
+     */
+
+    int undo_memory_limit () const
+    {
+        return m_undo_memory_limit;
+    }
+
+    /**
+     * \getter m_sysex_chunk
+     */
+
+    int sysex_chunk () const
+    {
+        return m_sysex_chunk;
+    }
+
+    /**
+     * \getter m_sysex_rate
+     */
+
+    int sysex_rate () const
+    {
+        return m_sysex_rate;
+    }
+
 protected:
 
     /**
@@ -690,12 +777,25 @@ protected:
         m_device_ignore = flag;
     }
 
+    /**
+     * \setter m_jack_engine
+     */
+
+    void jack_engine (bool flag)
+    {
+        m_jack_engine = flag;
+    }
+
     /*
      * The setters for non-bool values, defined in the cpp file because
      * they do some heavier validation.
      */
 
     void tempo_track_number (int track);
+    void output_lookahead (int ms);
+    void undo_memory_limit (int kb);
+    void sysex_chunk (int bytes);
+    void sysex_rate (int bytespersec);
     void device_ignore_num (int value);
     bool interaction_method (interaction_method_t value);
     bool mute_group_saving (mute_group_handling_t mgh);
@@ -38,12 +38,15 @@
  *  module, and now just call its member functions to do the actual work.
  */
 
+#include <atomic>                       /* std::atomic<int>         */
+#include <pthread.h>                    /* pthread_t, pthread_self()*/
 #include <string>
-#include <stack>
 
 #include "seq64_features.h"             /* various feature #defines */
 #include "calculations.hpp"             /* measures_to_ticks()      */
 #include "event_list.hpp"               /* seq64::event_list        */
+#include "event_pack.hpp"               /* seq64::event_journal     */
+#include "event_snapshot.hpp"           /* seq64::snapshot_holder   */
 #include "midi_container.hpp"           /* seq64::midi_container    */
 #include "midibus.hpp"                  /* seq64::midibus           */
 #include "mutex.hpp"                    /* seq64::mutex, automutex  */
@@ -145,10 +148,92 @@ private:
 
     /**
      *  Provides a stack of event-lists for use with the undo and redo
-     *  facility.
+     *  facility.  The journal keeps only the newest state whole, and the
+     *  older ones as the stretches of events that each edit changed.
+     */
+
+    typedef event_journal EventStack;
+
+    /**
+     *  Locks m_mutex like an automutex does, for the edits that change what
+     *  gets played.  When the outermost editlock is released, the playable
+     *  snapshot of the events is rebuilt and published to the output
+     *  thread, so that it sees only finished edits.  An edit that can only
+     *  add or remove events (such as selection with e_remove_one) passes
+     *  false for the "inplace" parameter, and then the snapshot is rebuilt
+     *  only if the event list was actually changed.
+     */
+
+    class editlock
+    {
+
+    private:
+
+        sequence & m_seq;
+
+    public:
+
+        editlock (sequence & s, bool inplace = true) : m_seq (s)
+        {
+            m_seq.m_mutex.lock();
+            ++m_seq.m_edit_depth;
+            if (inplace)
+                m_seq.m_snapshot_stale = true;
+
+            m_seq.save_transaction_undo();
+        }
+
+        ~editlock ()
+        {
+            if (--m_seq.m_edit_depth == 0)
+                m_seq.publish_snapshot();
+
+            m_seq.m_mutex.unlock();
+        }
+
+    };
+
+public:
+
+    /**
+     *  Groups a number of edits of a sequence into one edit, by calling
+     *  begin_edit() when created and commit_edit() when destroyed.
+     *
+\verbatim
+        {
+            sequence::transaction t(seq);
+            seq.transpose_notes(2, 0);
+            seq.shift_notes(48);
+            seq.quantize_events(EVENT_NOTE_ON, 0, snap, 1, true);
+        }
+\endverbatim
      */
 
-    typedef std::stack<event_list> EventStack;
+    class transaction
+    {
+
+    private:
+
+        sequence & m_seq;
+
+    public:
+
+        transaction (sequence & s) : m_seq (s)
+        {
+            m_seq.begin_edit();
+        }
+
+        ~transaction ()
+        {
+            m_seq.commit_edit();
+        }
+
+    private:
+
+        transaction (const transaction &);                  /* no copying   */
+        transaction & operator = (const transaction &);
+
+    };
 
 private:
 
@@ -170,6 +255,14 @@ private:
 
     perform * m_parent;
 
+    /**
+     *  The pool that the nodes of m_events come from, so that loading,
+     *  pasting, or restoring the events of the pattern does not make a heap
+     *  allocation per event.  See the node_pool module.
+     */
+
+    std::shared_ptr<node_pool> m_event_pool;
+
     /**
      *  This list holds the current pattern/sequence events.  It used to be
      *  called m_list_events, but a map implementation is now available, and
@@ -236,7 +329,158 @@ private:
      *  An iterator for drawing events.
      */
 
-    event_list::iterator m_iterator_draw;
+    event_list::const_iterator m_iterator_draw;
+
+    /**
+     *  Holds the playable snapshot of m_events that the output thread
+     *  reads, so that play() does not need to lock m_mutex, and is not held
+     *  up by long edits.  A new snapshot is published whenever an edit
+     *  (done under an editlock) is finished.
+     */
+
+    snapshot_holder m_snapshot;
+
+    /**
+     *  The nesting depth of the editlock objects of this sequence.  When
+     *  the outermost editlock is released, the snapshot is published.
+     *  Protected by m_mutex.
+     */
+
+    int m_edit_depth;
+
+    /**
+     *  The generation of m_events when the current snapshot was built.
+     *  Protected by m_mutex.
+     */
+
+    unsigned long m_snapshot_generation;
+
+    /**
+     *  Set by an editlock for an edit that can change the events in place
+     *  (without changing the generation of m_events), so that a new
+     *  snapshot is published when the edit is done.  Protected by m_mutex.
+     */
+
+    bool m_snapshot_stale;
+
+    /**
+     *  The nesting depth of begin_edit() calls.  While it is not 0, the
+     *  edits save no undo state of their own, and the linking of the
+     *  events, the dirty flags, and the modify flag of the performance are
+     *  put off until commit_edit().  Changed only under m_mutex, but atomic
+     *  so that other threads can see it (see in_transaction()).
+     */
+
+    std::atomic<int> m_transaction_depth;
+
+    /**
+     *  The thread that holds the current transaction.  Set before
+     *  m_transaction_depth leaves 0.
+     */
+
+    pthread_t m_transaction_thread;
+
+    /**
+     *  Set by begin_edit(), and cleared when the undo state of the
+     *  transaction is saved, just before its first change, so that a
+     *  transaction that changes nothing leaves no undo state.
+     */
+
+    bool m_transaction_undo;
+
+    /**
+     *  Set when an edit in a transaction has asked for verify_and_link().
+     *  Until that is done, the Note On/Note Off links may be stale, so the
+     *  edits that follow links call link_if_stale() first.
+     */
+
+    bool m_transaction_relink;
+
+    /**
+     *  Set when an edit in a transaction has called set_dirty().
+     */
+
+    bool m_transaction_dirty;
+
+    /**
+     *  Set when an edit in a transaction has called modify().
+     */
+
+    bool m_transaction_modified;
+
+    /**
+     *  The play cursor.  It is the index, in the snapshot, of the first
+     *  event that was not yet played in the previous call to play(), so
+     *  that the next output frame can resume there instead of skipping
+     *  forward from the beginning of the events.  It is valid only while
+     *  m_play_cursor_valid is true, and the serial number of the current
+     *  snapshot matches m_play_serial.
+     */
+
+    int m_play_index;
+
+    /**
+     *  The offset base (a multiple of m_length) that applies to the event
+     *  at m_play_index.  This accounts for the wraparound of the pattern at
+     *  m_length.
+     */
+
+    midipulse m_play_offset_base;
+
+    /**
+     *  The adjusted start tick (in the same units as the offset-adjusted
+     *  event stamps) that the next frame must have for the play cursor to be
+     *  reusable.  A seek or a change in the trigger offset yields a
+     *  different start value, and the cursor is then rebuilt.
+     */
+
+    midipulse m_play_next_tick;
+
+    /**
+     *  The serial number of the snapshot for which the play cursor was
+     *  saved.  Every published snapshot has a new serial number.
+     */
+
+    unsigned long m_play_serial;
+
+    /**
+     *  Indicates that the play cursor can be used.  Cleared when playback of
+     *  the sequence stops, when the last tick is set, and when the length
+     *  changes.
+     */
+
+    bool m_play_cursor_valid;
+
+    /**
+     *  If not SEQ64_NULL_MIDIPULSE, off_playing_notes() queues its Note Offs
+     *  at this tick, instead of cancelling the queued events of the pattern
+     *  and sending the Note Offs at once.  Set by play() when a trigger
+     *  ends, for the scheduled output mode.  Protected by m_play_mutex.
+     */
+
+    midipulse m_off_tick;
+
+    /**
+     *  A position change from the JACK process engine (see engine_seek())
+     *  that could not be done at once, because an editor held the play
+     *  mutex.  It is done by the next real-time play_queue().  If
+     *  SEQ64_NULL_MIDIPULSE, there is none.  Touched only by the engine.
+     */
+
+    midipulse m_engine_seek_tick;
+
+    /**
+     *  If true, the pending engine seek stops the pattern first, as
+     *  perform::reset_sequences() does.
+     */
+
+    bool m_engine_seek_stop;
+
+    /**
+     *  The song mode for the stop of the pending engine seek.
+     */
+
+    bool m_engine_seek_song;
 
     /**
      *  A new feature for recording, based on a "stazed" feature.  If true
@@ -535,11 +779,24 @@ private:
 
     /**
      *  Provides locking for the sequence.  Made mutable for use in
-     *  certain locked getter functions.
+     *  certain locked getter functions.  Edits of the events that change
+     *  what is played lock it by an editlock instead of an automutex.
      */
 
     mutable mutex m_mutex;
 
+    /**
+     *  Provides locking for the playback state:  the triggers, the playing
+     *  and queued flags, the last tick, the trigger offset, the playing
+     *  notes, and the play cursor.  This is the only lock that play() takes,
+     *  and it is held only briefly by other threads, so that editing does
+     *  not delay the output thread.  If both locks are needed, m_mutex must
+     *  be locked first.  A function that holds m_play_mutex must never lock
+     *  m_mutex.
+     */
+
+    mutable mutex m_play_mutex;
+
     /**
      *  Provides the number of ticks to shave off of the end of painted notes.
      *  Also used when the user attempts to shrink a note to zero (or less
@@ -710,12 +967,16 @@ public:
     }
 
     void push_undo (bool hold = false);             // adds stazed parameter
+    void begin_edit ();
+    void commit_edit ();
     void pop_undo ();
     void pop_redo ();
 
-    void push_trigger_undo ();
-    void pop_trigger_undo ();
-    void pop_trigger_redo ();
+    bool save_triggers (triggers::List & previous);
+    void restore_triggers
+    (
+        const triggers::List & trigs, triggers::List & previous
+    );
 
     void set_name (const std::string & name);
 
@@ -1090,6 +1351,27 @@ public:
         return m_midi_channel;
     }
 
+    /**
+     *  Checks to see if the event's channel matches the sequence's nominal
+     *  channel.
+     *
+     * \param e
+     *      The event whose channel nybble is to be checked.
+     *
+     * \return
+     *      Returns true if the channel-matching feature is enable and the
+     *      channels match, or true if the channel-matching feature is turned
+     *      off.
+     */
+
+    bool channel_match (const event & e) const
+    {
+        if (m_channel_match)
+            return (e.get_status() & 0x0F) == m_midi_channel;
+        else
+            return true;
+    }
+
     /**
      *  Returns true if this sequence is an SMF 0 sequence.
      */
@@ -1103,7 +1385,10 @@ public:
     void print () const;
     void print_triggers () const;
     void play (midipulse tick, bool playback_mode);
-    void play_queue (midipulse tick, bool playbackmode);
+    void play_queue (midipulse tick, bool playbackmode, bool realtime = false);
+    void engine_seek (midipulse tick, bool stop, bool song_mode);
+    midipulse next_event_tick (midipulse tick, bool playbackmode);
+    void wake_output ();
     bool add_note
     (
         midipulse tick, midipulse len, int note,
@@ -1333,7 +1618,7 @@ public:
     void pause (bool song_mode = false);
     void inc_draw_marker ();
     void reset_draw_marker ();
-    void reset_draw_trigger_marker ();
+    void reset_draw_trigger_marker (midipulse tick = 0);
     void reset_ex_iterator (event_list::const_iterator & evi);
     draw_type_t get_next_note_event
     (
@@ -1496,7 +1781,66 @@ private:
     ) const;
 
     void set_parent (perform * p);
-    void put_event_on_bus (event & ev);
+    void put_event_on_bus (event & ev, midipulse tick = SEQ64_NULL_MIDIPULSE);
+    void update_thru_route ();
+
+    /**
+     *  Invalidates the play cursor, so that the next call to play() locates
+     *  its starting event from the beginning of the event list.
+     */
+
+    void reset_play_cursor ()
+    {
+        m_play_cursor_valid = false;
+    }
+
+    void publish_snapshot ();
+    void link_if_stale ();
+    void apply_engine_seek ();
+
+    /**
+     *  Saves the events in the undo history before an edit, unless the edit
+     *  is part of a transaction, which saved them once in begin_edit().  The
+     *  caller must hold m_mutex.
+     *
+     * \param group
+     *      Passed along to event_journal::push().
+     */
+
+    void save_undo (bool group = false)
+    {
+        if (m_transaction_depth == 0)
+            m_events_undo.push(m_events, group);
+        else
+            save_transaction_undo();
+    }
+
+    /**
+     *  Saves the events in the undo history once per transaction, before
+     *  its first change.  The caller must hold m_mutex.
+     */
+
+    void save_transaction_undo ()
+    {
+        if (m_transaction_undo)
+        {
+            m_transaction_undo = false;
+            m_events_undo.push(m_events);
+        }
+    }
+
+    /**
+     *  Tells if the calling thread is inside a transaction.  Other threads,
+     *  such as the output thread calling set_playing(), are not, so their
+     *  set_dirty() and modify() calls are not folded into the transaction.
+     */
+
+    bool in_transaction () const
+    {
+        return m_transaction_depth.load() > 0 &&
+            pthread_equal(m_transaction_thread, pthread_self()) != 0;
+    }
+
 #ifdef SEQ64_STAZED_EXPAND_RECORD
     void reset_loop ();
 #endif
@@ -1507,27 +1851,6 @@ private:
     void remove (event & e);
     void remove_all ();
 
-    /**
-     *  Checks to see if the event's channel matches the sequence's nominal
-     *  channel.
-     *
-     * \param e
-     *      The event whose channel nybble is to be checked.
-     *
-     * \return
-     *      Returns true if the channel-matching feature is enable and the
-     *      channels match, or true if the channel-matching feature is turned
-     *      off.
-     */
-
-    bool channel_match (const event & e) const
-    {
-        if (m_channel_match)
-            return (e.get_status() & 0x0F) == m_midi_channel;
-        else
-            return true;
-    }
-
 };          // class sequence
 
 }           // namespace seq64
@@ -0,0 +1,190 @@
+#ifndef SEQ64_SYSEX_STREAM_HPP
+#define SEQ64_SYSEX_STREAM_HPP
+
+/*
+ *  This file is part of seq24/sequencer64.
+ *
+ *  seq24 is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  seq24 is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with seq24; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          sysex_stream.hpp
+ *
+ *  This module declares the class that assembles incoming SysEx messages,
+ *  paces outgoing ones, and keeps statistics on both.
+ *
+ * \library       sequencer64 application
+ * \author        Chris Ahlstrom
+ * \date          2017-09-06
+ * \updates       2017-09-06
+ * \license       GNU GPLv2 or above
+ *
+ *  A bulk dump (a bank of patches, a firmware image) can be a SysEx message
+ *  of hundreds of kilobytes.  The MIDI APIs deliver such a message in
+ *  pieces: ALSA as a series of SysEx events, JACK as one or more events.
+ *  The pieces are collected in an arena, a byte vector that is cleared, but
+ *  not freed, between messages, so that a steady stream of dumps does not
+ *  allocate.
+ *
+ *  On output, midibase::sysex() sends a message in pieces of the size set
+ *  by the [sysex-pacing] option, and, if a rate is set, waits between the
+ *  pieces so as not to overrun a slow DIN device.  The waits are measured
+ *  from the start of the message, so that the time taken to send a piece
+ *  does not add to the pacing.
+ */
+
+#include <string>                       /* std::string                  */
+#include <time.h>                       /* struct timespec              */
+#include <vector>                       /* std::vector<>                */
+
+#include "midibyte.hpp"                 /* seq64::midibyte              */
+#include "mutex.hpp"                    /* seq64::mutex, automutex      */
+
+/*
+ *  Do not document a namespace; it breaks Doxygen.
+ */
+
+namespace seq64
+{
+
+/**
+ *  Holds the SysEx counts of one buss.
+ */
+
+struct sysex_statistics
+{
+    long m_messages_in;                 /**< Complete messages received.    */
+    long m_bytes_in;                    /**< Bytes of those messages.       */
+    long m_dropped_in;                  /**< Bytes received but not kept.   */
+    long m_messages_out;                /**< Messages sent.                 */
+    long m_bytes_out;                   /**< Bytes sent.                    */
+    long m_dropped_out;                 /**< Bytes that could not be sent.  */
+    long m_us_out;                      /**< Time spent sending, in us.     */
+};
+
+/**
+ *  Assembles the incoming SysEx messages of one buss, and paces and counts
+ *  its outgoing ones.  The input side is used only by the input thread.
+ *  The output side is used by one thread at a time (see midibase::sysex()).
+ *  The statistics can be read from any thread.
+ */
+
+class sysex_stream
+{
+
+private:
+
+    /**
+     *  The message being received, from its 0xF0 byte on.
+     */
+
+    std::vector<midibyte> m_arena;
+
+    /**
+     *  True after the start of a message has been received, and until its
+     *  end.
+     */
+
+    bool m_receiving;
+
+    /**
+     *  True if the message being received has grown past
+     *  SEQ64_SYSEX_INPUT_MAX, so that it is to be dropped.
+     */
+
+    bool m_truncated;
+
+    /**
+     *  The time at which the message being sent was started.
+     */
+
+    struct timespec m_start;
+
+    /**
+     *  The pacing rate of the message being sent, in bytes per second, or
+     *  0 for no pacing.
+     */
+
+    int m_rate;
+
+    /**
+     *  The counts.
+     */
+
+    sysex_statistics m_stats;
+
+    /**
+     *  Protects m_stats.
+     */
+
+    mutable mutex m_mutex;
+
+public:
+
+    sysex_stream ();
+
+    bool accepts (midibyte first) const;
+    bool receive (const midibyte * data, int len);
+    void start_output (int rate);
+    void pace (int bytes);
+    void end_output (int sent, int dropped);
+    sysex_statistics statistics () const;
+    void print (const std::string & name) const;
+
+    /**
+     * \getter m_receiving
+     */
+
+    bool receiving () const
+    {
+        return m_receiving;
+    }
+
+    /**
+     *  Gets the bytes of the last complete message, valid until the next
+     *  call to receive().
+     */
+
+    midibyte * data ()
+    {
+        return m_arena.empty() ? nullptr : &m_arena[0] ;
+    }
+
+    /**
+     * \getter m_arena.size()
+     */
+
+    int size () const
+    {
+        return int(m_arena.size());
+    }
+
+private:
+
+    sysex_stream (const sysex_stream &);                    /* no copying   */
+    sysex_stream & operator = (const sysex_stream &);
+
+};
+
+}           // namespace seq64
+
+#endif      // SEQ64_SYSEX_STREAM_HPP
+
+/*
+ * sysex_stream.hpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
+
@@ -37,7 +37,9 @@
 
 #include <string>
 #include <list>
-#include <stack>
+#include <vector>
+
+#include "node_pool.hpp"                /* seq64::pool_allocator<>      */
 
 /**
  *  Indicates that there is no paste-trigger.  This is a new feature from the
@@ -268,6 +270,7 @@ class triggers
     friend class midi_container;
     friend class midifile;
     friend class sequence;
+    friend class perform;               /* the trigger journal          */
     friend class Seq24PerfInput;        /* we need better encapsulation */
     friend class FruityPerfInput;       /* we need better encapsulation */
 
@@ -289,14 +292,16 @@ private:
      *  Exposes the triggers type, currently needed for midi_container only.
      */
 
-    typedef std::list<trigger> List;
+    typedef std::list<trigger, pool_allocator<trigger> > List;
 
     /**
-     *  Provides a stack for use with the undo/redo features of the
-     *  trigger support.
+     *  Provides a random-access index into the trigger list, in the order of
+     *  the list, which is sorted by starting tick.  It allows for a binary
+     *  search of the triggers without changing the list container that all
+     *  of the trigger-editing code relies on.
      */
 
-    typedef std::stack<List> Stack;
+    typedef std::vector<List::iterator> Index;
 
 private:
 
@@ -307,6 +312,14 @@ private:
 
     sequence & m_parent;
 
+    /**
+     *  The pool that the nodes of the trigger lists come from.  Copies of
+     *  the lists, such as the ones in the undo history of the perform
+     *  object, use it as well, and keep it alive.
+     */
+
+    std::shared_ptr<node_pool> m_pool;
+
     /**
      *  This list holds the current pattern/triggers events.
      */
@@ -320,22 +333,45 @@ private:
     trigger m_clipboard;
 
     /**
-     *  Handles the undo list for a series of operations on triggers.
+     *  The triggers as they were when the trigger journal of the perform
+     *  object last saved this track (see save()).  Comparing it with the
+     *  current triggers tells if an edit changed this track, so that only
+     *  the tracks that changed go into the undo history.
      */
 
-    Stack m_undo_stack;
+    List m_saved;
 
     /**
-     *  Handles the redo list for a series of operations on triggers.
+     *  The index of the triggers, rebuilt lazily (see find()) after any
+     *  change to the trigger list.
      */
 
-    Stack m_redo_stack;
+    Index m_index;
 
     /**
-     *  An iterator for cycling through the triggers during playback.
+     *  Indicates that m_index matches the trigger list.  Every function that
+     *  adds, removes, or moves triggers clears this flag, via
+     *  invalidate_index().
      */
 
-    List::iterator m_iterator_play_trigger;
+    bool m_index_valid;
+
+    /**
+     *  The playback cursor.  Holds the position in m_index of the last
+     *  trigger that starts at or before m_play_tick, or -1 if there is no
+     *  such trigger.  As playback moves forward, the cursor normally moves
+     *  at most one trigger per frame.
+     */
+
+    int m_play_cursor;
+
+    /**
+     *  The tick at which m_play_cursor was last located.  If the next lookup
+     *  is for an earlier tick (a seek backwards), a binary search is done
+     *  instead of stepping the cursor.
+     */
+
+    midipulse m_play_tick;
 
     /**
      *  An iterator for cycling through the triggers during drawing.
@@ -423,11 +459,12 @@ public:
         return m_triggers;
     }
 
-    void push_undo ();
-    void pop_undo ();
-    void pop_redo ();
+    bool same_as_saved () const;
+    bool save (List & previous);
+    void restore (const List & trigs, List & previous);
     void print (const std::string & seqname) const;
     bool play (midipulse & starttick, midipulse & endtick);
+    midipulse next_edge (midipulse tick);
     void add
     (
         midipulse tick, midipulse len,
@@ -461,6 +498,7 @@ public:
     void clear ()
     {
         m_triggers.clear();
+        invalidate_index();
     }
 
     bool next
@@ -470,14 +508,7 @@ public:
     );
     trigger next_trigger ();
 
-    /**
-     *  Sets the draw-trigger iterator to the beginning of the trigger list.
-     */
-
-    void reset_draw_trigger_marker ()
-    {
-        m_iterator_draw_trigger = m_triggers.begin();
-    }
+    void reset_draw_trigger_marker (midipulse tick = 0);
 
     void set_trigger_paste_tick (midipulse tick)
     {
@@ -493,6 +524,11 @@ private:
 
     midipulse adjust_offset (midipulse offset);
     void split (trigger & trig, midipulse splittick);
+    void rebuild_index ();
+    int find (midipulse tick);
+    int find_play (midipulse tick);
+
+    void invalidate_index ();
 
 };          // class triggers
 
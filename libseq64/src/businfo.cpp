@@ -218,6 +218,7 @@ businfo::print () const
         "  %s:%s %s\n",
         bus()->bus_name().c_str(), bus()->port_name().c_str(), flags.c_str()
     );
+    bus()->sysex_io().print("   ");
 }
 
 /*
@@ -462,6 +463,84 @@ busarray::play (bussbyte bus, event * e24, midibyte channel)
         m_container[bus].bus()->play(e24, channel);
 }
 
+/**
+ *  Plays an event at the given queue tick, if the bus is proper.
+ *
+ * \param bus
+ *      The MIDI buss on which to play the event.
+ *
+ * \param e24
+ *      A pointer to the event to be played.
+ *
+ * \param channel
+ *      The MIDI channel on which to play the event.
+ *
+ * \param tick
+ *      The tick of the output queue at which to send the event.
+ *
+ * \param tag
+ *      Marks the event for cancelling; the tag of the pattern.
+ */
+
+void
+busarray::play_at
+(
+    bussbyte bus, event * e24, midibyte channel,
+    midipulse tick, int tag
+)
+{
+    if (bus < count() && m_container[bus].active())
+        m_container[bus].bus()->play_at(e24, channel, tick, tag);
+}
+
+/**
+ *  Plays an event at the given frame of the current process cycle, if the
+ *  bus is proper.  For the engine mode.
+ *
+ * \param bus
+ *      The MIDI buss on which to play the event.
+ *
+ * \param e24
+ *      A pointer to the event to be played.
+ *
+ * \param channel
+ *      The MIDI channel on which to play the event.
+ *
+ * \param frame
+ *      The frame offset in the current cycle.
+ */
+
+void
+busarray::play_frame (bussbyte bus, event * e24, midibyte channel, int frame)
+{
+    if (bus < count() && m_container[bus].active())
+        m_container[bus].bus()->play_frame(e24, channel, frame);
+}
+
+/**
+ *  Plays an event that was due a while ago, if the bus is proper.  For the
+ *  direct output mode.
+ *
+ * \param bus
+ *      The MIDI buss on which to play the event.
+ *
+ * \param e24
+ *      A pointer to the event to be played.
+ *
+ * \param channel
+ *      The MIDI channel on which to play the event.
+ *
+ * \param ago_us
+ *      How long before now the event was due, in microseconds.
+ */
+
+void
+busarray::play_due (bussbyte bus, event * e24, midibyte channel, long ago_us)
+{
+    if (bus < count() && m_container[bus].active())
+        m_container[bus].bus()->play_due(e24, channel, ago_us);
+}
+
 /**
  *  Sets the clock type for the given bus, usually the output buss.
  *  This code is a bit more restrictive than the original code in
@@ -770,18 +849,27 @@ busarray::poll_for_midi ()
  * \param inev
  *      A pointer to the event to be modified by incoming data, if any.
  *
+ * \param age
+ *      If not null, gets the input age of the event, in microseconds (see
+ *      midibase::input_age()), or 0 if the MIDI API does not know it.
+ *
  * \return
  *      Returns true if an event's data was copied into the event pointer.
  */
 
 bool
-busarray::get_midi_event (event * inev)
+busarray::get_midi_event (event * inev, long * age)
 {
     std::vector<businfo>::iterator bi;
     for (bi = m_container.begin(); bi != m_container.end(); ++bi)
     {
         if (bi->bus()->get_midi_event(inev))
+        {
+            if (not_nullptr(age))
+                *age = bi->bus()->input_age();
+
             return true;
+        }
     }
     return false;
 }
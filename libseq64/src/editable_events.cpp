@@ -227,8 +227,8 @@ editable_events::load_events ()
 
     for
     (
-        event_list::const_iterator ei = m_sequence.events().begin();
-        ei != m_sequence.events().end(); ++ei
+        event_list::const_iterator ei = m_sequence.events().cbegin();
+        ei != m_sequence.events().cend(); ++ei
     )
     {
         if (! add(DREF(ei)))
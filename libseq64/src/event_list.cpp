@@ -39,7 +39,10 @@
  */
 
 #include <stdio.h>                      /* C::printf()                  */
+#include <unordered_map>                /* std::unordered_map<>         */
+#include <vector>                       /* std::vector<>                */
 
+#include "app_limits.h"                /* SEQ64_MIDI_COUNT_MAX         */
 #include "easy_macros.h"
 #include "event_list.hpp"
 
@@ -113,21 +116,44 @@ event_list::event_key::operator < (const event_key & rhs) const
  */
 
 /**
- *  Principal constructor.
+ *  Default constructor.  The nodes of the list come from the heap.
  */
 
 event_list::event_list ()
  :
-    m_events                (),
+    m_pool                  (),
+    m_storage               (std::make_shared<Events>()),
     m_is_modified           (false),
     m_has_tempo             (false),
-    m_has_time_signature    (false)
+    m_has_time_signature    (false),
+    m_generation            (0)
 {
     // No code needed
 }
 
 /**
- *  Copy constructor.
+ *  Principal constructor.  Used by a sequence to keep its events in its
+ *  own pool.
+ *
+ * \param pool
+ *      The pool to take the nodes of the list from.
+ */
+
+event_list::event_list (const std::shared_ptr<node_pool> & pool)
+ :
+    m_pool                  (pool),
+    m_storage               (std::make_shared<Events>(Allocator(pool))),
+    m_is_modified           (false),
+    m_has_tempo             (false),
+    m_has_time_signature    (false),
+    m_generation            (0)
+{
+    // No code needed
+}
+
+/**
+ *  Copy constructor.  The events are shared, not copied, until one of the
+ *  two lists is changed.
  *
  * \param rhs
  *      Provides the event list to be copied.
@@ -135,17 +161,21 @@ event_list::event_list ()
 
 event_list::event_list (const event_list & rhs)
  :
-    m_events                (rhs.m_events),
+    m_pool                  (rhs.m_pool),
+    m_storage               (rhs.m_storage),
     m_is_modified           (rhs.m_is_modified),
     m_has_tempo             (rhs.m_has_tempo),
-    m_has_time_signature    (rhs.m_has_time_signature)
+    m_has_time_signature    (rhs.m_has_time_signature),
+    m_generation            (0)
 {
     // No code needed
 }
 
 /**
  *  Principal assignment operator.  Follows the stock rules for such an
- *  operator, just assigning member values.
+ *  operator, just assigning member values.  As with the copy constructor,
+ *  the events are shared until one of the lists is changed.  The pool of
+ *  this list is kept.
  *
  * \param rhs
  *      Provides the event list to be assigned.
@@ -156,10 +186,11 @@ event_list::operator = (const event_list & rhs)
 {
     if (this != &rhs)
     {
-        m_events                = rhs.m_events;
+        m_storage               = rhs.m_storage;
         m_is_modified           = rhs.m_is_modified;
         m_has_tempo             = rhs.m_has_tempo;
         m_has_time_signature    = rhs.m_has_time_signature;
+        ++m_generation;                 /* all old iterators are now bad    */
     }
     return *this;
 }
@@ -173,6 +204,50 @@ event_list::~event_list ()
     // No code needed
 }
 
+/**
+ *  Gives this list its own copy of storage that it shares with other event
+ *  lists.  The other lists keep the original, which stays unchanged.
+ *
+ *  Copying an event does not copy its Note On/Note Off link, so the links
+ *  are rebuilt here, each copied event pointing at the copy of the event its
+ *  original was linked to.  Since every iterator into the old storage now
+ *  refers to the wrong list, the generation count is bumped.
+ */
+
+void
+event_list::detach ()
+{
+    const Events & old = *m_storage;
+    std::shared_ptr<Events> mine = std::make_shared<Events>(Allocator(m_pool));
+    *mine = old;                        /* copies into our pool, if any     */
+    std::unordered_map<const event *, event *> where;
+    Events::const_iterator oi = old.begin();
+    for (Events::iterator ni = mine->begin(); ni != mine->end(); ++ni, ++oi)
+    {
+        const event & oe = dref(oi);
+        if (oe.is_linked())
+            where[&oe] = &dref(ni);
+    }
+    if (! where.empty())
+    {
+        oi = old.begin();
+        for (Events::iterator ni = mine->begin(); ni != mine->end(); ++ni, ++oi)
+        {
+            const event & oe = dref(oi);
+            if (oe.is_linked())
+            {
+                std::unordered_map<const event *, event *>::const_iterator w =
+                    where.find(oe.get_linked());
+
+                if (w != where.end())
+                    dref(ni).link(w->second);
+            }
+        }
+    }
+    m_storage = mine;
+    ++m_generation;
+}
+
 /**
  *  Provides the length of the events in MIDI pulses.  This function gets the
  *  iterator for the last element and returns its length value.
@@ -187,7 +262,7 @@ event_list::get_length () const
     midipulse result = 0;
     if (count() > 0)
     {
-        const_reverse_iterator lci = m_events.rbegin(); /* get last element */
+        const_reverse_iterator lci = storage().rbegin(); /* get last element */
 #ifdef SEQ64_USE_EVENT_MAP
         result = lci->second.get_timestamp();           /* get length value */
 #else
@@ -244,15 +319,66 @@ event_list::append (const event & e)
     EventsPair p = std::make_pair<event_key, event>(key, e);
 #endif
 
-    m_events.insert(p);                 /* std::multimap operation  */
+    storage().insert(p);                 /* std::multimap operation  */
 
 #else   // SEQ64_USE_EVENT_MAP
 
-    m_events.push_front(e);             /* std::list operation      */
+    storage().push_front(e);             /* std::list operation      */
 
 #endif
 
     m_is_modified = true;
+    ++m_generation;
+    if (e.is_tempo())
+        m_has_tempo = true;
+
+    if (e.is_time_signature())
+        m_has_time_signature = true;
+
+    return true;
+}
+
+#ifndef SEQ64_USE_EVENT_MAP
+
+/**
+ *  Adds an event to the list at its sorted position, by time-stamp and
+ *  rank.  The event goes in front of any events that compare equal to it,
+ *  which is where the old append() plus sort() put it.
+ *
+ *  This used to be a push_front() followed by a sort of the whole list, for
+ *  every event added.  Now the insertion point is found by walking back from
+ *  the end of the list.  Recording, step entry, and copying events from
+ *  another sorted list all add events at or near the end, so the walk is
+ *  usually only a step or two, and no other event is moved.  List nodes
+ *  never move, so the links between events stay valid.
+ *
+ *  The list is assumed to be sorted already.  To add many events at once,
+ *  append() them to a scratch list and merge() that list, which sorts only
+ *  once.
+ *
+ * \param e
+ *      Provides the event to be added to the list.
+ *
+ * \return
+ *      Returns true.
+ */
+
+bool
+event_list::add (const event & e)
+{
+    Events::iterator pos = storage().end();
+    while (pos != storage().begin())
+    {
+        Events::iterator prev = pos;
+        --prev;
+        if (dref(prev) < e)
+            break;
+
+        pos = prev;
+    }
+    storage().insert(pos, e);
+    m_is_modified = true;
+    ++m_generation;
     if (e.is_tempo())
         m_has_tempo = true;
 
@@ -262,6 +388,8 @@ event_list::append (const event & e)
     return true;
 }
 
+#endif  // ! SEQ64_USE_EVENT_MAP
+
 #ifdef SEQ64_USE_EVENT_MAP
 
 /**
@@ -308,7 +436,8 @@ event_list::merge (event_list & el, bool /*presort*/ )
 {
     int initialsize = count();
     int addedsize = el.count();
-    m_events.insert(el.events().begin(), el.events().end());
+    storage().insert(el.events().begin(), el.events().end());
+    ++m_generation;
     if (count() != (initialsize + addedsize))
     {
         char tmp[64];
@@ -323,76 +452,117 @@ event_list::merge (event_list & el, bool /*presort*/ )
 
 #else   // SEQ64_USE_EVENT_MAP
 
+/*
+ *  The nodes of el are spliced in, so both lists must take their nodes from
+ *  the same pool (see sequence::m_event_pool).  If they do not, the events
+ *  are copied into this list's pool instead, since a node must be freed by
+ *  the allocator that made it.
+ */
+
 void
 event_list::merge (event_list & el, bool presort)
 {
     if (presort)
-        el.m_events.sort();
+        el.storage().sort();
 
-    m_events.merge(el.m_events);
+    Events & mine = storage();
+    Events & theirs = el.storage();
+    if (mine.get_allocator() == theirs.get_allocator())
+    {
+        mine.merge(theirs);                     /* splices the nodes        */
+    }
+    else
+    {
+        Events copy(theirs.begin(), theirs.end(), mine.get_allocator());
+        mine.merge(copy);                       /* nodes from our own pool  */
+        theirs.clear();
+    }
+    ++m_generation;
+    ++el.m_generation;
 }
 
 #endif  // SEQ64_USE_EVENT_MAP
 
 /**
- *  Links a new event.  This function checks for a note on, then look for
- *  its note off.  This function is provided in the event_list because it
- *  does not depend on any external data.  Also note that any desired
- *  thread-safety must be provided by the caller.
+ *  Links the Note On and Note Off events that are not yet linked.  This is
+ *  the single pass used by both link_new() and verify_and_link().
+ *
+ *  Each Note On is paired with the first free Note Off of the same pitch
+ *  that follows it.  The events are walked once, in order.  Unlinked Note
+ *  Ons wait in a queue per pitch, and each unlinked Note Off takes the
+ *  oldest waiting Note On of its pitch.  This gives the same pairs as
+ *  searching forward from each Note On in turn, without the repeated
+ *  searches, which made linking quadratic in the number of events.
+ *
+ *  A Note On still waiting at the end of the pattern has its Note Off
+ *  wrapped around to the start of the pattern.  Every Note Off of that pitch
+ *  left unclaimed lies before every waiting Note On (a Note Off after a
+ *  waiting Note On would have claimed it), so the two leftover queues are
+ *  simply paired in order.
+ *
+ * \threadunsafe
+ *      The caller must hold the lock that protects the event list.
  */
 
 void
-event_list::link_new ()
+event_list::link_notes ()
 {
-    bool endfound = false;
-    for (Events::iterator on = m_events.begin(); on != m_events.end(); ++on)
+    std::vector<event *> ons[SEQ64_MIDI_COUNT_MAX];     /* waiting Note Ons */
+    std::vector<event *> offs[SEQ64_MIDI_COUNT_MAX];    /* unclaimed Offs   */
+    std::size_t onhead[SEQ64_MIDI_COUNT_MAX] = { 0 };   /* oldest waiting   */
+    for (Events::iterator i = storage().begin(); i != storage().end(); ++i)
     {
-        event & eon = dref(on);
-        if (eon.is_note_on() && ! eon.is_linked())  /* note on, unlinked?   */
+        event & e = dref(i);
+        if (e.is_linked())
+            continue;
+
+        int note = e.get_note() & 0x7F;
+        if (e.is_note_on())
         {
-            Events::iterator off = on;              /* point to note on     */
-            ++off;                                  /* get next element     */
-            endfound = false;
-            while (off != m_events.end())
-            {
-                event & eoff = dref(off);
-                if                  /* off event, == notes, and not linked  */
-                (
-                    eoff.is_note_off() &&
-                    eoff.get_note() == eoff.get_note() && ! eoff.is_linked()
-                )
-                {
-                    eon.link(&eoff);                /* link backward        */
-                    eoff.link(&eon);                /* link forward         */
-                    endfound = true;                /* note on fulfilled    */
-                    break;
-                }
-                ++off;
-            }
-            if (! endfound)
+            ons[note].push_back(&e);
+        }
+        else if (e.is_note_off())
+        {
+            if (onhead[note] < ons[note].size())
             {
-                off = m_events.begin();
-                while (off != on)
-                {
-                    event & eoff = dref(off);
-                    if              /* off event, == notes, and not linked  */
-                    (
-                        eoff.is_note_off() &&
-                        eoff.get_note() == eon.get_note() && ! eoff.is_linked()
-                    )
-                    {
-                        eon.link(&eoff);            /* link backward        */
-                        eoff.link(&eon);            /* link forward         */
-                        endfound = true;            /* note on fulfilled    */
-                        break;
-                    }
-                    ++off;
-                }
+                event * eon = ons[note][onhead[note]++];
+                eon->link(&e);                      /* link backward        */
+                e.link(eon);                        /* link forward         */
             }
+            else
+                offs[note].push_back(&e);
+        }
+    }
+    for (int note = 0; note < SEQ64_MIDI_COUNT_MAX; ++note)
+    {
+        std::size_t off = 0;                        /* wrap around          */
+        std::size_t on = onhead[note];
+        while (on < ons[note].size() && off < offs[note].size())
+        {
+            ons[note][on]->link(offs[note][off]);
+            offs[note][off]->link(ons[note][on]);
+            ++on;
+            ++off;
         }
     }
 }
 
+/**
+ *  Links a new event.  This function checks for a note on, then look for
+ *  its note off.  This function is provided in the event_list because it
+ *  does not depend on any external data.  Also note that any desired
+ *  thread-safety must be provided by the caller.
+ *
+ *  The Note Offs used to be matched by comparing the Note Off's note with
+ *  itself, which could link a Note On to a Note Off of another pitch.
+ */
+
+void
+event_list::link_new ()
+{
+    link_notes();
+}
+
 /**
  *  This function verifies state: all note-ons have an off, and it links
  *  note-offs with their note-ons.
@@ -414,58 +584,8 @@ event_list::link_new ()
 void
 event_list::verify_and_link (midipulse slength)
 {
-    clear_links();
-    for (event_list::iterator on = m_events.begin(); on != m_events.end(); ++on)
-    {
-        event & eon = dref(on);
-        if (eon.is_note_on())               /* Note On, find its Note Off   */
-        {
-            event_list::iterator off = on;  /* next possible Note Off...    */
-            ++off;                          /* ...starting here             */
-            bool endfound = false;
-            while (off != m_events.end())
-            {
-                event & eoff = dref(off);
-                if                          /* Off, == notes, not marked    */
-                (
-                    eoff.is_note_off() &&
-                    eoff.get_note() == eon.get_note() && ! eoff.is_marked()
-                )
-                {
-                    eon.link(&eoff);                    /* link + mark */
-                    eoff.link(&eon);
-                    eon.mark();
-                    eoff.mark();
-                    endfound = true;
-                    break;
-                }
-                ++off;
-            }
-            if (! endfound)
-            {
-                off = m_events.begin();
-                while (off != on)
-                {
-                    event & eoff = dref(off);
-                    if
-                    (
-                        eoff.is_note_off() &&
-                        eoff.get_note() == eon.get_note() && ! eoff.is_marked()
-                    )
-                    {
-                        eon.link(&eoff);                /* link + mark */
-                        eoff.link(&eon);
-                        eon.mark();
-                        eoff.mark();
-                        endfound = true;
-                        break;
-                    }
-                    ++off;
-                }
-            }
-        }
-    }
-    unmark_all();
+    clear_links();                          /* also unmarks all events      */
+    link_notes();
     mark_out_of_range(slength);
     remove_marked();                        /* prune out-of-range events    */
 
@@ -484,7 +604,7 @@ event_list::verify_and_link (midipulse slength)
 void
 event_list::clear_links ()
 {
-    for (Events::iterator i = m_events.begin(); i != m_events.end(); ++i)
+    for (Events::iterator i = storage().begin(); i != storage().end(); ++i)
     {
         event & e = dref(i);
         e.clear_link();
@@ -508,14 +628,14 @@ void
 event_list::link_tempos ()
 {
     clear_tempo_links();
-    for (event_list::iterator t = m_events.begin(); t != m_events.end(); ++t)
+    for (event_list::iterator t = storage().begin(); t != storage().end(); ++t)
     {
         event & e = dref(t);
         if (e.is_tempo())
         {
             event_list::iterator t2 = t;    /* next possible Set Tempo...   */
             ++t2;                           /* ...starting here             */
-            while (t2 != m_events.end())
+            while (t2 != storage().end())
             {
                 event & et2 = dref(t2);
                 if (et2.is_tempo())
@@ -536,7 +656,7 @@ event_list::link_tempos ()
 void
 event_list::clear_tempo_links ()
 {
-    for (Events::iterator i = m_events.begin(); i != m_events.end(); ++i)
+    for (Events::iterator i = storage().begin(); i != storage().end(); ++i)
     {
         event & e = dref(i);
         if (e.is_tempo())
@@ -555,7 +675,7 @@ bool
 event_list::mark_selected ()
 {
     bool result = false;
-    for (Events::iterator i = m_events.begin(); i != m_events.end(); ++i)
+    for (Events::iterator i = storage().begin(); i != storage().end(); ++i)
     {
         event & e = dref(i);
         if (e.is_selected())
@@ -575,7 +695,7 @@ event_list::mark_selected ()
 void
 event_list::mark_all ()
 {
-    for (Events::iterator i = m_events.begin(); i != m_events.end(); ++i)
+    for (Events::iterator i = storage().begin(); i != storage().end(); ++i)
         dref(i).mark();
 }
 
@@ -586,7 +706,7 @@ event_list::mark_all ()
 void
 event_list::unmark_all ()
 {
-    for (Events::iterator i = m_events.begin(); i != m_events.end(); ++i)
+    for (Events::iterator i = storage().begin(); i != storage().end(); ++i)
         dref(i).unmark();
 }
 
@@ -609,7 +729,7 @@ event_list::unmark_all ()
 void
 event_list::mark_out_of_range (midipulse slength)
 {
-    for (Events::iterator i = m_events.begin(); i != m_events.end(); ++i)
+    for (Events::iterator i = storage().begin(); i != storage().end(); ++i)
     {
         event & e = dref(i);
         bool prune = e.get_timestamp() > slength;   /* WAS ">=", SEE BANNER */
@@ -639,8 +759,8 @@ bool
 event_list::remove_marked ()
 {
     bool result = false;
-    Events::iterator i = m_events.begin();
-    while (i != m_events.end())
+    Events::iterator i = storage().begin();
+    while (i != storage().end())
     {
         if (DREF(i).is_marked())
         {
@@ -663,7 +783,7 @@ event_list::remove_marked ()
 void
 event_list::unpaint_all ()
 {
-    for (Events::iterator i = m_events.begin(); i != m_events.end(); ++i)
+    for (Events::iterator i = storage().begin(); i != storage().end(); ++i)
         dref(i).unpaint();
 }
 
@@ -675,7 +795,7 @@ int
 event_list::count_selected_notes () const
 {
     int result = 0;
-    for (Events::const_iterator i = m_events.begin(); i != m_events.end(); ++i)
+    for (Events::const_iterator i = storage().begin(); i != storage().end(); ++i)
     {
         if (dref(i).is_note_on() && dref(i).is_selected())
             ++result;
@@ -696,7 +816,7 @@ bool
 event_list::any_selected_notes () const
 {
     bool result = false;
-    for (Events::const_iterator i = m_events.begin(); i != m_events.end(); ++i)
+    for (Events::const_iterator i = storage().begin(); i != storage().end(); ++i)
     {
         if (dref(i).is_note_on() && dref(i).is_selected())
         {
@@ -728,7 +848,7 @@ int
 event_list::count_selected_events (midibyte status, midibyte cc) const
 {
     int result = 0;
-    for (Events::const_iterator i = m_events.begin(); i != m_events.end(); ++i)
+    for (Events::const_iterator i = storage().begin(); i != storage().end(); ++i)
     {
         const event & e = dref(i);
         if (e.is_tempo())
@@ -757,7 +877,7 @@ event_list::count_selected_events (midibyte status, midibyte cc) const
 void
 event_list::select_all ()
 {
-    for (Events::iterator i = m_events.begin(); i != m_events.end(); ++i)
+    for (Events::iterator i = storage().begin(); i != storage().end(); ++i)
         dref(i).select();
 }
 
@@ -768,7 +888,7 @@ event_list::select_all ()
 void
 event_list::unselect_all ()
 {
-    for (Events::iterator i = m_events.begin(); i != m_events.end(); ++i)
+    for (Events::iterator i = storage().begin(); i != storage().end(); ++i)
         dref(i).unselect();
 }
 
@@ -780,7 +900,7 @@ void
 event_list::print () const
 {
     printf("events[%d]:\n", count());
-    for (Events::const_iterator i = m_events.begin(); i != m_events.end(); ++i)
+    for (Events::const_iterator i = storage().begin(); i != storage().end(); ++i)
         dref(i).print();
 }
 
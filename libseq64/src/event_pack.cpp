@@ -0,0 +1,464 @@
+/*
+ *  This file is part of seq24/sequencer64.
+ *
+ *  seq24 is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  seq24 is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with seq24; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          event_pack.cpp
+ *
+ *  This module defines the compact, flat copy of an event list, and the
+ *  journal of such copies used by the undo and redo stacks of a sequence.
+ *
+ * \library       sequencer64 application
+ * \author        Chris Ahlstrom
+ * \date          2017-09-06
+ * \updates       2017-09-06
+ * \license       GNU GPLv2 or above
+ */
+
+#include <string.h>                     /* memcpy(), memcmp()           */
+#include <utility>                      /* std::swap()                  */
+
+#include "easy_macros.h"
+#include "event_list.hpp"               /* seq64::event_list, DREF()    */
+#include "event_pack.hpp"               /* seq64::event_pack            */
+
+/*
+ *  Do not document a namespace; it breaks Doxygen.
+ */
+
+namespace seq64
+{
+
+/**
+ *  Default constructor.  The pack is empty.
+ */
+
+event_pack::event_pack ()
+ :
+    m_events        (),
+    m_spans         (),
+    m_arena         (),
+    m_is_modified   (false)
+{
+    // Empty body
+}
+
+/**
+ *  Principal constructor.  Packs all of the events of the event list, in
+ *  order.  The caller must hold the lock that protects the event list.
+ *
+ * \param evl
+ *      The event list to pack.
+ */
+
+event_pack::event_pack (const event_list & evl)
+ :
+    m_events        (),
+    m_spans         (),
+    m_arena         (),
+    m_is_modified   (evl.is_modified())
+{
+    int payloadcount = 0;
+    int payloadbytes = 0;
+    for (event_list::const_iterator i = evl.begin(); i != evl.end(); ++i)
+    {
+        int sz = DREF(i).get_sysex_size();
+        if (sz > 0)
+        {
+            ++payloadcount;
+            payloadbytes += sz;
+        }
+    }
+    m_events.reserve(evl.count());
+    m_spans.reserve(payloadcount);
+    m_arena.reserve(payloadbytes);
+    for (event_list::const_iterator i = evl.begin(); i != evl.end(); ++i)
+    {
+        const event & er = DREF(i);
+        packed_event p;
+        p.m_timestamp = er.get_timestamp();
+        p.m_payload = SEQ64_NO_PAYLOAD;
+        p.m_status = er.get_status();
+        p.m_channel = er.get_channel();
+        er.get_data(p.m_data[0], p.m_data[1]);
+
+        const event::SysexContainer & sx = er.get_sysex();
+        if (! sx.empty())
+        {
+            span s;
+            s.m_offset = unsigned(m_arena.size());
+            s.m_size = unsigned(sx.size());
+            p.m_payload = unsigned(m_spans.size());
+            m_spans.push_back(s);
+            m_arena.insert(m_arena.end(), sx.begin(), sx.end());
+        }
+        m_events.push_back(p);
+    }
+}
+
+/**
+ *  Replaces the contents of an event list with the packed events.  The
+ *  events come back unlinked and unselected; the caller is expected to call
+ *  sequence::verify_and_link() afterward.
+ *
+ *  The data bytes are copied straight into the SysEx container of each
+ *  event, rather than through event::set_sysex(), which stops at the first
+ *  0xF7 byte, a value that can legitimately appear inside Meta data.
+ *
+ * \param evl
+ *      The event list to fill.  The caller must hold the lock that protects
+ *      it.
+ */
+
+void
+event_pack::unpack (event_list & evl) const
+{
+    evl.clear();
+    evl.m_has_tempo = false;
+    evl.m_has_time_signature = false;
+    for (int i = 0; i < count(); ++i)
+    {
+        const packed_event & p = m_events[i];
+        event e;
+        e.set_timestamp(p.m_timestamp);
+        e.set_status(p.m_status, p.m_channel);
+        e.set_data(p.m_data[0], p.m_data[1]);
+        if (p.m_payload != SEQ64_NO_PAYLOAD)
+        {
+            const span & s = m_spans[p.m_payload];
+            e.set_sysex_size(int(s.m_size));
+            memcpy(&e.get_sysex()[0], &m_arena[s.m_offset], s.m_size);
+        }
+
+#ifdef SEQ64_USE_EVENT_MAP
+        evl.append(e);
+#else
+        evl.storage().push_back(e);     /* already in order, no sorting */
+        if (e.is_tempo())
+            evl.m_has_tempo = true;
+
+        if (e.is_time_signature())
+            evl.m_has_time_signature = true;
+#endif
+    }
+    evl.m_is_modified = m_is_modified;
+    ++evl.m_generation;
+}
+
+/**
+ *  Range constructor.  Copies some of the events of another pack, with
+ *  their data bytes.
+ *
+ * \param src
+ *      The pack to copy from.  Its modified-flag is copied as well.
+ *
+ * \param first
+ *      The index of the first event to copy.
+ *
+ * \param count
+ *      The number of events to copy.
+ */
+
+event_pack::event_pack (const event_pack & src, int first, int count)
+ :
+    m_events        (),
+    m_spans         (),
+    m_arena         (),
+    m_is_modified   (src.m_is_modified)
+{
+    m_events.reserve(count);
+    append_from(src, first, count);
+}
+
+/**
+ *  Appends some of the events of another pack, copying their data bytes
+ *  into the arena of this pack.
+ *
+ * \param src
+ *      The pack to copy from.  Must not be this pack.
+ *
+ * \param first
+ *      The index of the first event to copy.
+ *
+ * \param count
+ *      The number of events to copy.
+ */
+
+void
+event_pack::append_from (const event_pack & src, int first, int count)
+{
+    for (int i = first; i < first + count; ++i)
+    {
+        packed_event p = src.m_events[i];
+        if (p.m_payload != SEQ64_NO_PAYLOAD)
+        {
+            const span & ss = src.m_spans[p.m_payload];
+            span s;
+            s.m_offset = unsigned(m_arena.size());
+            s.m_size = ss.m_size;
+            p.m_payload = unsigned(m_spans.size());
+            m_spans.push_back(s);
+            m_arena.insert
+            (
+                m_arena.end(), src.m_arena.begin() + ss.m_offset,
+                src.m_arena.begin() + ss.m_offset + ss.m_size
+            );
+        }
+        m_events.push_back(p);
+    }
+}
+
+/**
+ *  Replaces a range of events with the events of another pack.  The
+ *  modified-flag is taken from the other pack, since that pack holds the
+ *  events that were changed.
+ *
+ * \param first
+ *      The index of the first event to replace.
+ *
+ * \param count
+ *      The number of events to remove.
+ *
+ * \param middle
+ *      The events to put in their place.
+ */
+
+void
+event_pack::replace (int first, int count, const event_pack & middle)
+{
+    int tailindex = first + count;
+    event_pack result;
+    result.m_events.reserve(this->count() - count + middle.count());
+    result.append_from(*this, 0, first);
+    result.append_from(middle, 0, middle.count());
+    result.append_from(*this, tailindex, this->count() - tailindex);
+    result.m_is_modified = middle.m_is_modified;
+    m_events.swap(result.m_events);
+    m_spans.swap(result.m_spans);
+    m_arena.swap(result.m_arena);
+    m_is_modified = result.m_is_modified;
+}
+
+/**
+ *  Compares an event of this pack with an event of another pack, including
+ *  the data bytes, if any.
+ *
+ * \param index
+ *      The index of the event in this pack.
+ *
+ * \param rhs
+ *      The other pack.
+ *
+ * \param rhsindex
+ *      The index of the event in the other pack.
+ *
+ * \return
+ *      Returns true if the two events are the same.
+ */
+
+bool
+event_pack::same_event (int index, const event_pack & rhs, int rhsindex) const
+{
+    const packed_event & a = m_events[index];
+    const packed_event & b = rhs.m_events[rhsindex];
+    bool result =
+    (
+        a.m_timestamp == b.m_timestamp && a.m_status == b.m_status &&
+        a.m_channel == b.m_channel && a.m_data[0] == b.m_data[0] &&
+        a.m_data[1] == b.m_data[1]
+    );
+    if (result)
+    {
+        bool apay = a.m_payload != SEQ64_NO_PAYLOAD;
+        bool bpay = b.m_payload != SEQ64_NO_PAYLOAD;
+        if (apay && bpay)
+        {
+            const span & sa = m_spans[a.m_payload];
+            const span & sb = rhs.m_spans[b.m_payload];
+            result = sa.m_size == sb.m_size && memcmp
+            (
+                &m_arena[sa.m_offset], &rhs.m_arena[sb.m_offset], sa.m_size
+            ) == 0;
+        }
+        else
+            result = apay == bpay;
+    }
+    return result;
+}
+
+/**
+ *  Gets the approximate memory used by the pack.
+ *
+ * \return
+ *      Returns the size of the pack object plus the bytes used by its
+ *      events, spans, and data bytes.
+ */
+
+std::size_t
+event_pack::bytes () const
+{
+    return sizeof(event_pack) +
+        m_events.capacity() * sizeof(packed_event) +
+        m_spans.capacity() * sizeof(span) + m_arena.capacity();
+}
+
+/**
+ *  Default constructor.  The journal is empty, and has no memory limit.
+ */
+
+event_journal::event_journal ()
+ :
+    m_entries       (),
+    m_top           (),
+    m_has_top       (false),
+    m_bytes         (0),
+    m_limit         (0),
+    m_group_open    (false)
+{
+    // Empty body
+}
+
+/**
+ *  Saves the state of an event list as the newest state.  The previous
+ *  newest state is turned into an edit record: the stretch of events
+ *  between the longest common beginning and the longest common end of the
+ *  two states.  Packing and comparing the states takes time in proportion
+ *  to the size of the event list, however small the edit, but the new pack
+ *  is swapped into place rather than copied again.
+ *
+ * \param evl
+ *      The event list to save.  The caller must hold its lock.
+ *
+ * \param group
+ *      If true, the state starts (or continues) a group.  If a group is
+ *      already open, nothing is saved, so that undoing goes back to the
+ *      state before the whole group.  Any other push, or a pop, ends the
+ *      group.
+ */
+
+void
+event_journal::push (const event_list & evl, bool group)
+{
+    if (group && m_group_open)
+        return;
+
+    m_group_open = group;
+
+    event_pack newest(evl);
+    if (m_has_top)
+    {
+        int n0 = m_top.count();
+        int n1 = newest.count();
+        int prefix = 0;
+        while (prefix < n0 && prefix < n1)
+        {
+            if (! m_top.same_event(prefix, newest, prefix))
+                break;
+
+            ++prefix;
+        }
+
+        int suffix = 0;
+        while (suffix < n0 - prefix && suffix < n1 - prefix)
+        {
+            if (! m_top.same_event(n0 - 1 - suffix, newest, n1 - 1 - suffix))
+                break;
+
+            ++suffix;
+        }
+        m_entries.push_back(entry());
+
+        entry & e = m_entries.back();
+        e.m_first = prefix;
+        e.m_count = n1 - prefix - suffix;
+        e.m_events = event_pack(m_top, prefix, n0 - prefix - suffix);
+        m_bytes += sizeof(entry) + e.m_events.bytes();
+        m_bytes -= m_top.bytes();
+    }
+    std::swap(m_top, newest);               /* moves the vectors, no copy   */
+    m_has_top = true;
+    m_bytes += m_top.bytes();
+    trim();
+}
+
+/**
+ *  Discards the newest state, rebuilding the state before it from the
+ *  newest edit record.  The whole state is copied to do so.
+ */
+
+void
+event_journal::pop ()
+{
+    if (m_has_top)
+    {
+        m_group_open = false;
+        m_bytes -= m_top.bytes();
+        if (m_entries.empty())
+        {
+            m_top = event_pack();
+            m_has_top = false;
+        }
+        else
+        {
+            entry & e = m_entries.back();
+            m_bytes -= sizeof(entry) + e.m_events.bytes();
+            m_top.replace(e.m_first, e.m_count, e.m_events);
+            m_entries.pop_back();
+            m_bytes += m_top.bytes();
+        }
+    }
+}
+
+/**
+ *  Sets the memory limit, dropping the oldest states if the journal is
+ *  already past it.
+ *
+ * \param bytes
+ *      The new limit, in bytes.  0 means no limit.
+ */
+
+void
+event_journal::limit (std::size_t bytes)
+{
+    m_limit = bytes;
+    trim();
+}
+
+/**
+ *  Drops the oldest states until the journal fits in its memory limit.  The
+ *  newest state is never dropped, so that the last edit can always be
+ *  undone.
+ */
+
+void
+event_journal::trim ()
+{
+    while (m_limit > 0 && m_bytes > m_limit && ! m_entries.empty())
+    {
+        m_bytes -= sizeof(entry) + m_entries.front().m_events.bytes();
+        m_entries.pop_front();
+    }
+}
+
+}           // namespace seq64
+
+/*
+ * event_pack.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
+
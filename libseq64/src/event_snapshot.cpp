@@ -0,0 +1,175 @@
+/*
+ *  This file is part of seq24/sequencer64.
+ *
+ *  seq24 is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  seq24 is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with seq24; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          event_snapshot.cpp
+ *
+ *  This module defines the immutable playable copy of the events of a
+ *  sequence, and the holder that publishes it to the output thread.
+ *
+ * \library       sequencer64 application
+ * \author        Chris Ahlstrom
+ * \date          2017-08-12
+ * \updates       2017-09-06
+ * \license       GNU GPLv2 or above
+ *
+ *  See the event_snapshot.hpp module for the rules that make the lock-free
+ *  reading safe.
+ */
+
+#include "easy_macros.h"
+#include "event_list.hpp"               /* seq64::event_list, DREF()    */
+#include "event_snapshot.hpp"           /* seq64::event_snapshot, etc.  */
+
+/*
+ *  Do not document a namespace; it breaks Doxygen.
+ */
+
+namespace seq64
+{
+
+/**
+ *  Principal constructor.  Copies the playable events of the event list,
+ *  packing each one into a word.  The caller must hold the lock that
+ *  protects the event list.
+ *
+ * \param evl
+ *      The event list to copy.  It is assumed to be sorted.
+ */
+
+event_snapshot::event_snapshot (const event_list & evl)
+ :
+    m_ticks     (),
+    m_words     (),
+    m_tempos    (),
+    m_serial    (0)
+{
+    m_ticks.reserve(evl.count());
+    m_words.reserve(evl.count());
+    for (event_list::const_iterator i = evl.begin(); i != evl.end(); ++i)
+    {
+        const event & er = DREF(i);
+        bool playable = true;
+        word w = 0;
+        if (er.is_tempo())
+        {
+            playable = m_tempos.size() <= 0xFFFF;   /* room for its index?  */
+            if (playable)
+            {
+                w = pack(EVENT_MIDI_META, 0, 0, 0) |
+                    (word(m_tempos.size()) << 16);
+
+                m_tempos.push_back(er.tempo());
+            }
+        }
+        else if (er.is_ex_data())
+            playable = false;
+        else
+        {
+            midibyte d0, d1;
+            er.get_data(d0, d1);
+            w = pack(er.get_status(), er.get_channel(), d0, d1);
+        }
+        if (playable)
+        {
+            m_ticks.push_back(er.get_timestamp());
+            m_words.push_back(w);
+        }
+    }
+}
+
+/**
+ *  Default constructor.  No snapshot is published yet.
+ */
+
+snapshot_holder::snapshot_holder ()
+ :
+    m_current       (nullptr),
+    m_readers       (0),
+    m_retired       (),
+    m_next_serial   (1)
+{
+    // Empty body
+}
+
+/**
+ *  Deletes the current snapshot and any retired ones.  There must be no
+ *  readers left at this point.
+ */
+
+snapshot_holder::~snapshot_holder ()
+{
+    for (size_t i = 0; i < m_retired.size(); ++i)
+        delete m_retired[i];
+
+    delete m_current.load();
+}
+
+/**
+ *  Makes a new snapshot the current one.  The previous snapshot is retired,
+ *  and the retired snapshots are deleted if no reader is active.  Called
+ *  only by the writer, which must be serialized by the caller.
+ *
+ * \param snap
+ *      The new snapshot, allocated by new.  The holder takes ownership of
+ *      it.
+ */
+
+void
+snapshot_holder::publish (event_snapshot * snap)
+{
+    if (not_nullptr(snap))
+    {
+        snap->m_serial = m_next_serial++;
+
+        event_snapshot * old = m_current.exchange(snap);
+        if (not_nullptr(old))
+            m_retired.push_back(old);
+
+        reclaim();
+    }
+}
+
+/**
+ *  Deletes the retired snapshots, if there is no reader.  A reader that
+ *  starts after the exchange in publish() loads the new snapshot, so a
+ *  reader count of zero, seen after the exchange, means no retired
+ *  snapshot can be in use.  If there are readers, the retired snapshots are
+ *  kept until the next call.
+ */
+
+void
+snapshot_holder::reclaim ()
+{
+    if (! m_retired.empty() && m_readers.load() == 0)
+    {
+        for (size_t i = 0; i < m_retired.size(); ++i)
+            delete m_retired[i];
+
+        m_retired.clear();
+    }
+}
+
+}           // namespace seq64
+
+/*
+ * event_snapshot.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
+
@@ -33,6 +33,8 @@
  *  buss classes.
  */
 
+#include <string.h>                     /* memset()                         */
+
 #include "calculations.hpp"             /* seq64::extract_port_names()      */
 #include "easy_macros.h"
 #include "event.hpp"                    /* seq64::event                     */
@@ -75,13 +77,39 @@ mastermidibase::mastermidibase
     m_queue             (0),
     m_ppqn              (choose_ppqn(ppqn)),
     m_beats_per_minute  (bpm),          /* beats per minute                 */
+    m_lookahead         (0),            /* direct output, no scheduling     */
+    m_queue_offset      (0),
+    m_queue_tick        (0),
+    m_frame_tick        (0),
+    m_schedule_tags     (),
+    m_pattern_tags      (),
+    m_engine            (false),        /* output thread, not JACK engine   */
+    m_engine_callback   (nullptr),
+    m_engine_arg        (nullptr),
+    m_engine_events     (),
+    m_engine_count      (0),
+    m_engine_dropped    (0),
+    m_engine_frames     (0),
+    m_engine_tick       (0.0),
+    m_engine_ticks_per_frame (1.0),
+    m_engine_now        (0),
+    m_engine_cycling    (false),
+    m_engine_thread     (pthread_self()),
+    m_batching          (false),
+    m_batch_thread      (pthread_self()),
+    m_batch_events      (),
+    m_input_age         (0),
+    m_sysex_in          (),
     m_dumping_input     (false),
     m_vector_sequence   (),             /* stazed feature                   */
     m_filter_by_channel (false),        /* set based on configuration       */
     m_seq               (nullptr),
+    m_thru_routes       (),
     m_mutex             ()
 {
-    // Empty body now
+    m_thru_routes.reserve(SEQ64_THRU_ROUTES);   /* no allocation when live */
+    m_batch_events.reserve(SEQ64_BATCH_EVENTS);
+    clear_schedule_tags();
 }
 
 /**
@@ -242,7 +270,56 @@ mastermidibase::set_beats_per_minute (midibpm bpm)
 void
 mastermidibase::flush ()
 {
+    if (m_engine || in_batch())         /* done at the end of cycle/frame   */
+        return;
+
+    automutex locker(m_mutex);
+    api_flush();
+}
+
+/**
+ *  Starts batching the output of the calling thread, normally the output
+ *  thread at the start of perform::play().  Until batch_end(), the channel
+ *  events that this thread plays directly, by play() or by play_at() when
+ *  output is not scheduled, are staged, in tick order, without taking the
+ *  mutex, and its flush() calls are skipped.  Other threads are not affected.
+ */
+
+void
+mastermidibase::batch_begin ()
+{
+    m_batch_thread = pthread_self();
+    m_batching = true;
+}
+
+/**
+ *  Ends the batch started by batch_begin().  The staged events are handed
+ *  to their busses in the order of their ticks, and the output is flushed
+ *  once, all under a single lock.  Each event goes with the time since it
+ *  was due, from its tick and the tick of the frame (see frame_start()),
+ *  so that a JACK buss stamps it with the frame of its tick, rather than
+ *  with the time at which the output thread happened to wake up.
+ */
+
+void
+mastermidibase::batch_end ()
+{
+    m_batching = false;
     automutex locker(m_mutex);
+    double us_per_tick = 60000000.0 / (m_beats_per_minute * m_ppqn);
+    event ev;
+    for (std::size_t i = 0; i < m_batch_events.size(); ++i)
+    {
+        const staged_event & se = m_batch_events[i];
+        long ago_us = long((m_frame_tick - se.m_tick) * us_per_tick);
+        ev.set_status(se.m_status);
+        ev.set_data(se.m_data[0], se.m_data[1]);
+        m_outbus_array.play_due
+        (
+            se.m_bus, &ev, se.m_channel, ago_us > 0 ? ago_us : 0
+        );
+    }
+    m_batch_events.clear();
     api_flush();
 }
 
@@ -250,7 +327,13 @@ mastermidibase::flush ()
  *  Handle the sending of SYSEX events.  The event is sent to all MIDI output
  *  busses.  Then flush() is called.
  *
- *  There's currently no implementation-specific API function for this call.
+ *  The buss pointers are copied under the master lock, since a buss can be
+ *  added at run time (see port_start()).  The master lock is then taken
+ *  again for each piece of the message, since ALSA sends every buss through
+ *  the one client handle that the output thread writes and drains under
+ *  it, but not between the pieces (see midibase::sysex()).  A paced dump
+ *  can take many seconds, and playback goes on between the pieces.  A buss
+ *  is never deleted before the master buss is.
  *
  * \threadsafe
  *
@@ -261,14 +344,30 @@ mastermidibase::flush ()
 void
 mastermidibase::sysex (event * ev)
 {
-    automutex locker(m_mutex);
-    m_outbus_array.sysex(ev);
-    flush();                /* recursive locking! */
+    std::vector<midibus *> busses;
+    {
+        automutex locker(m_mutex);
+        int count = m_outbus_array.count();
+        busses.reserve(count);
+        for (int b = 0; b < count; ++b)
+            busses.push_back(m_outbus_array.bus(bussbyte(b)));
+    }
+    for (size_t b = 0; b < busses.size(); ++b)
+    {
+        if (not_nullptr(busses[b]))
+            busses[b]->sysex(ev, &m_mutex);    /* locks it per piece   */
+    }
+    flush();
 }
 
 /**
  *  Handle the playing of MIDI events on the MIDI buss given by the
- *  parameter, as long as it is a legal buss number.
+ *  parameter, as long as it is a legal buss number.  If the calling thread
+ *  is batching (see batch_begin()), a channel event is staged instead, and
+ *  played by batch_end().  If it is the engine (see in_engine()), a channel
+ *  event is added to the cycle at the current frame (see engine_now()), so
+ *  that the engine neither takes a lock nor gets ahead of its own events;
+ *  other events are not sent by the engine.
  *
  *  There's currently no implementation-specific API function here.
  *
@@ -288,9 +387,610 @@ mastermidibase::sysex (event * ev)
 
 void
 mastermidibase::play (bussbyte bus, event * e24, midibyte channel)
+{
+    if (in_engine())
+    {
+        if (event::is_channel_msg(e24->get_status()))
+            engine_insert(bus, e24, channel, m_engine_now);
+    }
+    else if (in_batch() && event::is_channel_msg(e24->get_status()))
+    {
+        batch_stage(bus, e24, channel, m_frame_tick);   /* due now      */
+    }
+    else
+    {
+        automutex locker(m_mutex);
+        m_outbus_array.play(bus, e24, channel);
+    }
+}
+
+/**
+ *  Plays an event at a given tick on the given buss.  In the scheduled output
+ *  mode, the event is put on the output queue of the MIDI API, to be sent at
+ *  that tick, under the lock.  Otherwise, if the calling thread is batching,
+ *  it is staged with its tick, in the same buffer as the events of play(),
+ *  which are due at the tick of the frame (see batch_stage()).  Otherwise
+ *  it is played at once by play().
+ *
+ * \threadsafe
+ *
+ * \param bus
+ *      The buss to play on.
+ *
+ * \param e24
+ *      The seq24 event to play on the buss.  For speed, we don't bother to
+ *      check the pointer.
+ *
+ * \param channel
+ *      The channel on which to play the event.
+ *
+ * \param tick
+ *      The performance tick at which the event is due.  It must not be
+ *      earlier than the tick passed to the last frame_start() call.
+ *
+ * \param seq
+ *      The number of the pattern that plays the event, so that its pending
+ *      events can be cancelled by cancel_scheduled().  The event is tagged
+ *      with the tag lent to the pattern (see pattern_tag()).  If no tag is
+ *      free, the event is sent at once.
+ */
+
+void
+mastermidibase::play_at
+(
+    bussbyte bus, event * e24, midibyte channel,
+    midipulse tick, int seq
+)
+{
+    if (m_engine)
+    {
+        engine_add(bus, e24, channel, tick);    /* process thread, no lock  */
+    }
+    else if (m_lookahead > 0)
+    {
+        automutex locker(m_mutex);
+        tick += m_queue_offset;
+
+        int tag = pattern_tag(seq, tick);
+        if (tag >= 0)
+            m_outbus_array.play_at(bus, e24, channel, tick, tag);
+        else
+            m_outbus_array.play(bus, e24, channel);     /* no tag: send now */
+    }
+    else if (in_batch() && event::is_channel_msg(e24->get_status()))
+        batch_stage(bus, e24, channel, tick);   /* see batch_end()          */
+    else
+        play(bus, e24, channel);
+}
+
+/**
+ *  Stages an event of the batching thread, to be played by batch_end().
+ *  The events are kept in the order of their ticks, after the events
+ *  already staged for the same or an earlier tick, so that a JACK buss can
+ *  stamp them in order.  The events of one pattern come in order, so the
+ *  search is short.
+ *
+ * \param bus
+ *      The buss to play on.
+ *
+ * \param e24
+ *      The event to play.
+ *
+ * \param channel
+ *      The channel on which to play the event.
+ *
+ * \param tick
+ *      The performance tick at which the event was due.
+ */
+
+void
+mastermidibase::batch_stage
+(
+    bussbyte bus, event * e24, midibyte channel, midipulse tick
+)
+{
+    staged_event se;
+    se.m_frame = 0;
+    se.m_tick = tick;
+    se.m_bus = bus;
+    se.m_status = e24->get_status();
+    se.m_channel = channel;
+    e24->get_data(se.m_data[0], se.m_data[1]);
+    m_batch_events.push_back(se);
+
+    std::size_t i = m_batch_events.size() - 1;
+    while (i > 0 && m_batch_events[i - 1].m_tick > tick)
+    {
+        m_batch_events[i] = m_batch_events[i - 1];
+        --i;
+    }
+    m_batch_events[i] = se;
+}
+
+/**
+ *  Turns on the engine mode, in which the MIDI API calls the given function
+ *  from its real-time process callback, once per cycle, to render the
+ *  events of that cycle.  The events that the function plays with
+ *  play_at() are collected, in frame order, and handed to the output
+ *  busses with their frame offsets when the function returns.
+ *
+ *  The space for the events is allocated here, and the busses must not be
+ *  changed while the engine runs, so that a cycle needs neither a lock nor
+ *  an allocation.
+ *
+ * \param cb
+ *      The function to call in each cycle.  It should call engine_window()
+ *      before playing any events.
+ *
+ * \param arg
+ *      The value to pass to the function, normally the perform object.
+ *
+ * \return
+ *      Returns true if the MIDI API supports the engine mode.  Otherwise, the
+ *      output thread must be used.
+ */
+
+bool
+mastermidibase::set_engine (engine_callback cb, void * arg)
 {
     automutex locker(m_mutex);
-    m_outbus_array.play(bus, e24, channel);
+    bool result = not_nullptr(cb);
+    if (result)
+    {
+        m_engine_events.resize(SEQ64_ENGINE_EVENTS_MAX);
+        m_engine_callback = cb;
+        m_engine_arg = arg;
+        m_engine = true;                        /* before the first cycle   */
+        result = api_set_engine(engine_process, this);
+        if (! result)
+        {
+            m_engine = false;
+            m_engine_callback = nullptr;
+            m_engine_events.clear();
+        }
+    }
+    return result;
+}
+
+/**
+ *  Sets the tick at the first frame of the current engine cycle, and the
+ *  number of ticks per frame, so that play_at() can convert the tick of an
+ *  event into a frame offset.  May be called more than once in a cycle, as
+ *  when the song loops back in the middle of the cycle.  Called only from
+ *  the engine callback.
+ *
+ * \param tick
+ *      The tick at frame 0 of the cycle.  It can be fractional.
+ *
+ * \param ticks_per_frame
+ *      The number of ticks per frame at the current tempo.
+ */
+
+void
+mastermidibase::engine_window (double tick, double ticks_per_frame)
+{
+    m_engine_tick = tick;
+    if (ticks_per_frame > 0.0)
+        m_engine_ticks_per_frame = ticks_per_frame;
+}
+
+/**
+ *  The engine_callback that is given to the MIDI API by set_engine().
+ *
+ * \param arg
+ *      The mastermidibase object.
+ *
+ * \param nframes
+ *      The number of frames in the cycle.
+ *
+ * \param rate
+ *      The sample rate.
+ */
+
+void
+mastermidibase::engine_process (void * arg, int nframes, int rate)
+{
+    mastermidibase * self = reinterpret_cast<mastermidibase *>(arg);
+    if (not_nullptr(self))
+        self->engine_cycle(nframes, rate);
+}
+
+/**
+ *  Renders one engine cycle.  Calls the engine function, which plays the
+ *  patterns for the cycle, then passes the collected events, in frame
+ *  order, to the output busses.  Runs in the process thread of the MIDI
+ *  API; it takes no lock and allocates nothing.  While the engine function
+ *  runs, in_engine() is true for this thread, so that play() adds to the
+ *  cycle rather than locking.
+ *
+ * \param nframes
+ *      The number of frames in the cycle.
+ *
+ * \param rate
+ *      The sample rate.
+ */
+
+void
+mastermidibase::engine_cycle (int nframes, int rate)
+{
+    m_engine_count = 0;
+    m_engine_frames = nframes;
+    m_engine_now = 0;
+    m_engine_thread = pthread_self();
+    m_engine_cycling = true;
+    m_engine_callback(m_engine_arg, nframes, rate);
+    m_engine_cycling = false;
+
+    event ev;
+    for (int i = 0; i < m_engine_count; ++i)
+    {
+        const staged_event & ee = m_engine_events[i];
+        ev.set_status(ee.m_status);
+        ev.set_data(ee.m_data[0], ee.m_data[1]);
+        m_outbus_array.play_frame(ee.m_bus, &ev, ee.m_channel, ee.m_frame);
+    }
+}
+
+/**
+ *  Adds an event to the current engine cycle, at the frame of its tick.
+ *
+ * \param bus
+ *      The buss to play on.
+ *
+ * \param e24
+ *      The event to play.
+ *
+ * \param channel
+ *      The channel on which to play the event.
+ *
+ * \param tick
+ *      The performance tick at which the event is due.
+ */
+
+void
+mastermidibase::engine_add
+(
+    bussbyte bus, event * e24, midibyte channel, midipulse tick
+)
+{
+    int frame = int((tick - m_engine_tick) / m_engine_ticks_per_frame);
+    engine_insert(bus, e24, channel, frame);
+}
+
+/**
+ *  Adds an event to the current engine cycle, after the events already
+ *  added for the same or an earlier frame.  The events of one pattern come
+ *  in order, so the search is short.  If there is no room left, the event
+ *  is dropped and counted.
+ *
+ * \param bus
+ *      The buss to play on.
+ *
+ * \param e24
+ *      The event to play.
+ *
+ * \param channel
+ *      The channel on which to play the event.
+ *
+ * \param frame
+ *      The frame offset in the cycle, clamped to the cycle.
+ */
+
+void
+mastermidibase::engine_insert
+(
+    bussbyte bus, event * e24, midibyte channel, int frame
+)
+{
+    if (m_engine_count < int(m_engine_events.size()))
+    {
+        if (frame >= m_engine_frames)
+            frame = m_engine_frames - 1;
+
+        if (frame < 0)
+            frame = 0;
+
+        int i = m_engine_count++;
+        while (i > 0 && m_engine_events[i - 1].m_frame > frame)
+        {
+            m_engine_events[i] = m_engine_events[i - 1];
+            --i;
+        }
+
+        staged_event & ee = m_engine_events[i];
+        ee.m_frame = frame;
+        ee.m_bus = bus;
+        ee.m_status = e24->get_status();
+        ee.m_channel = channel;
+        e24->get_data(ee.m_data[0], ee.m_data[1]);
+    }
+    else
+        ++m_engine_dropped;
+}
+
+/**
+ *  Sets the frame at which play() puts the events of the engine for the
+ *  rest of the current cycle.  Called only from the engine callback, with
+ *  a tick in the current window (see engine_window()).
+ *
+ * \param tick
+ *      The performance tick that is now "now".
+ */
+
+void
+mastermidibase::engine_now (midipulse tick)
+{
+    int frame = int((tick - m_engine_tick) / m_engine_ticks_per_frame);
+    if (frame >= m_engine_frames)
+        frame = m_engine_frames - 1;
+
+    m_engine_now = frame > 0 ? frame : 0 ;
+}
+
+/**
+ *  The engine form of emit_clock().  Each output buss that sends the MIDI
+ *  clock gets a clock event at the frame of each clock tick it is due, in
+ *  the current cycle, rather than a burst at the end of the cycle.  No lock
+ *  is taken:  the busses are not changed while the engine runs, and only
+ *  the engine touches their clocks then.  Called only from the engine
+ *  callback, after engine_window().
+ *
+ * \param start
+ *      The clock position, in ticks, at frame 0 of the cycle.  It goes on
+ *      counting when the song loops back, unlike the tick of the patterns.
+ *
+ * \param tick
+ *      The last clock tick of the cycle.
+ */
+
+void
+mastermidibase::engine_clock (double start, midipulse tick)
+{
+    event clk;
+    clk.make_clock();
+    int count = m_outbus_array.count();
+    for (int b = 0; b < count; ++b)
+    {
+        midibus * mb = m_outbus_array.bus(bussbyte(b));
+        if (not_nullptr(mb))
+        {
+            for (;;)
+            {
+                midipulse due = mb->next_clock(tick);
+                if (is_null_midipulse(due))
+                    break;
+
+                int frame = int((due - start) / m_engine_ticks_per_frame);
+                engine_insert(bussbyte(b), &clk, 0, frame);
+            }
+        }
+    }
+}
+
+/**
+ *  The form of init_clock() for the engine, which must not wait.  If the
+ *  lock is held by another thread, nothing is done, and the engine tries
+ *  again in its next cycle.
+ *
+ * \param tick
+ *      Provides the tick value with which to initialize the buss clock.
+ *
+ * \return
+ *      Returns true if the clock was initialized.
+ */
+
+bool
+mastermidibase::try_init_clock (midipulse tick)
+{
+    bool result = m_mutex.try_lock();
+    if (result)
+    {
+        api_init_clock(tick);
+        m_outbus_array.init_clock(tick);
+        m_mutex.unlock();
+    }
+    return result;
+}
+
+/**
+ *  The form of stop() for the engine.  See try_init_clock().
+ *
+ * \return
+ *      Returns true if the busses were stopped.
+ */
+
+bool
+mastermidibase::try_stop ()
+{
+    bool result = m_mutex.try_lock();
+    if (result)
+    {
+        m_outbus_array.stop();
+        api_stop();
+        m_mutex.unlock();
+    }
+    return result;
+}
+
+/**
+ *  The form of set_beats_per_minute() for the engine.  See
+ *  try_init_clock().
+ *
+ * \param bpm
+ *      Provides the beats/minute value to set.
+ *
+ * \return
+ *      Returns true if the tempo was set.
+ */
+
+bool
+mastermidibase::try_beats_per_minute (midibpm bpm)
+{
+    bool result = m_mutex.try_lock();
+    if (result)
+    {
+        m_beats_per_minute = bpm;
+        api_set_beats_per_minute(bpm);
+        m_mutex.unlock();
+    }
+    return result;
+}
+
+/**
+ *  Sets the look-ahead of the scheduled output mode.  The mode is enabled
+ *  only if the MIDI API supports scheduling.
+ *
+ * \threadsafe
+ *
+ * \param ms
+ *      The look-ahead in milliseconds.  If 0, output is direct.
+ *
+ * \return
+ *      Returns true if the scheduled output mode is now in force.
+ */
+
+bool
+mastermidibase::set_lookahead (int ms)
+{
+    automutex locker(m_mutex);
+    if (ms > 0 && api_set_lookahead(ms))
+        m_lookahead = ms;
+    else
+        m_lookahead = 0;
+
+    return m_lookahead > 0;
+}
+
+/**
+ *  Starts an output frame.  Notes the tick of the frame, for batch_end().
+ *  In the scheduled output mode, this function also ties the performance
+ *  tick to the current tick of the output queue, and extends the frame by
+ *  the look-ahead.
+ *
+ * \threadsafe
+ *
+ * \param tick
+ *      The current performance tick.
+ *
+ * \return
+ *      Returns the tick up to which the frame is to be played.  This is the
+ *      \a tick parameter if the output is direct.
+ */
+
+midipulse
+mastermidibase::frame_start (midipulse tick)
+{
+    automutex locker(m_mutex);
+    m_frame_tick = tick;
+    if (m_lookahead > 0)
+    {
+        double ticks_per_ms = m_beats_per_minute * m_ppqn / 60000.0;
+        m_queue_tick = api_queue_tick();
+        m_queue_offset = m_queue_tick - tick;
+        tick += midipulse(m_lookahead * ticks_per_ms);
+    }
+    return tick;
+}
+
+/**
+ *  Cancels the scheduled events that have not been sent yet, except Note
+ *  Offs, so that the caller can silence notes at once.  Note Offs are kept
+ *  so that notes already sounding, and counted as off by the sequence,
+ *  still get turned off.  Does nothing if output is direct.
+ *
+ * \threadsafe
+ *
+ * \param seq
+ *      The pattern whose pending events are to be cancelled.  If
+ *      SEQ64_NULL_SEQUENCE (the default), all pending events are cancelled,
+ *      as for a stop or a change in position.
+ */
+
+void
+mastermidibase::cancel_scheduled (int seq)
+{
+    if (m_lookahead > 0)                    /* set only at start-up     */
+    {
+        automutex locker(m_mutex);
+        if (seq == SEQ64_NULL_SEQUENCE)
+        {
+            api_cancel_scheduled(-1);
+            clear_schedule_tags();          /* only Note Offs are left  */
+        }
+        else if (seq >= 0 && seq < SEQ64_SEQUENCE_MAXIMUM)
+        {
+            int tag = m_pattern_tags[seq];
+            if (tag >= 0)                   /* else nothing is pending  */
+                api_cancel_scheduled(tag);
+        }
+    }
+}
+
+/**
+ *  Gets the event tag of a pattern for a scheduled event, lending it one if
+ *  it has none.  A tag is free if it is not lent, or if the last event
+ *  scheduled with it was due before the current output frame, and thus has
+ *  been sent; the pattern that had it then loses it.  No allocation is
+ *  done.  The caller must hold m_mutex.
+ *
+ * \param seq
+ *      The number of the pattern.
+ *
+ * \param qtick
+ *      The queue tick at which the event is to be sent.
+ *
+ * \return
+ *      Returns the tag, or -1 if the pattern number is not valid or every
+ *      tag is in use, in which case the event is to be sent at once rather
+ *      than share a tag with another pattern.
+ */
+
+int
+mastermidibase::pattern_tag (int seq, midipulse qtick)
+{
+    if (seq < 0 || seq >= SEQ64_SEQUENCE_MAXIMUM)
+        return -1;
+
+    int tag = m_pattern_tags[seq];
+    if (tag < 0)
+    {
+        for (int t = 0; t < SEQ64_SCHEDULE_TAGS; ++t)
+        {
+            schedule_tag & st = m_schedule_tags[t];
+            if (st.m_seq == SEQ64_NULL_SEQUENCE || st.m_last < m_queue_tick)
+            {
+                if (st.m_seq != SEQ64_NULL_SEQUENCE)
+                    m_pattern_tags[st.m_seq] = -1;
+
+                st.m_seq = seq;
+                st.m_last = qtick;
+                m_pattern_tags[seq] = short(t);
+                return t;
+            }
+        }
+        return -1;
+    }
+    if (qtick > m_schedule_tags[tag].m_last)
+        m_schedule_tags[tag].m_last = qtick;
+
+    return tag;
+}
+
+/**
+ *  Frees all of the event tags of the scheduled output mode.  The caller
+ *  must hold m_mutex, or be the constructor.
+ */
+
+void
+mastermidibase::clear_schedule_tags ()
+{
+    for (int t = 0; t < SEQ64_SCHEDULE_TAGS; ++t)
+    {
+        m_schedule_tags[t].m_seq = SEQ64_NULL_SEQUENCE;
+        m_schedule_tags[t].m_last = 0;
+    }
+    for (int s = 0; s < SEQ64_SEQUENCE_MAXIMUM; ++s)
+        m_pattern_tags[s] = -1;
 }
 
 /**
@@ -362,6 +1062,25 @@ mastermidibase::get_clock (bussbyte bus)
     return m_outbus_array.get_clock(bus);
 }
 
+/**
+ *  Tells if any output buss is set to send MIDI clock.
+ *
+ * \return
+ *      Returns true if the clock setting of at least one output buss is not
+ *      e_clock_off.
+ */
+
+bool
+mastermidibase::clocking ()
+{
+    for (int bus = 0; bus < m_outbus_array.count(); ++bus)
+    {
+        if (m_outbus_array.get_clock(bussbyte(bus)) != e_clock_off)
+            return true;
+    }
+    return false;
+}
+
 /**
  *  Initializes all fo the busses in the input and output buss arrays.
  *
@@ -545,6 +1264,7 @@ mastermidibase::print () const
 {
     m_inbus_array.print();
     m_outbus_array.print();
+    m_sysex_in.print("Input");
 }
 
 /**
@@ -640,7 +1360,8 @@ mastermidibase::port_exit (int client, int port)
 }
 
 /**
- *  Grab a MIDI event via the currently-selected MIDI API.
+ *  Grab a MIDI event via the currently-selected MIDI API.  The age of the
+ *  event is cleared first, for the APIs that do not set it.
  *
  * \param ev
  *      The event to be set based on the found input event.
@@ -649,9 +1370,27 @@ mastermidibase::port_exit (int client, int port)
 bool
 mastermidibase::get_midi_event (event * ev)
 {
+    m_input_age = 0;
     return api_get_midi_event(ev);
 }
 
+/**
+ *  Converts the age of the last input event to ticks, at the current tempo
+ *  and PPQN, so that the input thread can place a recorded event at the
+ *  tick at which it arrived, rather than the tick at which it was read.
+ *
+ * \return
+ *      Returns the number of ticks the last event from get_midi_event()
+ *      waited before being read, or 0 if the MIDI API does not know.
+ */
+
+midipulse
+mastermidibase::input_age_ticks () const
+{
+    double ticks = double(m_input_age) * m_beats_per_minute * m_ppqn / 60e6;
+    return midipulse(ticks);
+}
+
 /**
  *  Set the input sequence object, and set the m_dumping_input value to
  *  the given state.
@@ -727,6 +1466,44 @@ mastermidibase::set_sequence_input (bool state, sequence * seq)
         m_seq = seq;
         m_dumping_input = state;
     }
+
+    bool released = false;                      /* input moved elsewhere?   */
+    std::vector<thru_route>::iterator r;
+    for (r = m_thru_routes.begin(); r != m_thru_routes.end(); ++r)
+    {
+        if (! is_input_target(r->m_seq) && release_thru_notes(*r))
+            released = true;
+    }
+    if (released)
+        flush();
+}
+
+/**
+ *  Checks if a sequence is one that the input goes to, as set by
+ *  set_sequence_input():  one of m_vector_sequence if filtering by channel,
+ *  otherwise m_seq.  The caller must hold m_mutex.
+ *
+ * \param seq
+ *      The sequence to check.
+ *
+ * \return
+ *      Returns true if the sequence takes the input.
+ */
+
+bool
+mastermidibase::is_input_target (const sequence * seq) const
+{
+    if (m_filter_by_channel)
+    {
+        for (size_t i = 0; i < m_vector_sequence.size(); ++i)
+        {
+            if (m_vector_sequence[i] == seq)
+                return true;
+        }
+        return false;
+    }
+    else
+        return not_nullptr(seq) && seq == m_seq;
 }
 
 /**
@@ -759,6 +1536,173 @@ mastermidibase::dump_midi_input (event ev)
     }
 }
 
+/**
+ *  Adds or updates the MIDI thru route of a sequence, so that thru() sends
+ *  the input that the sequence takes straight to the buss and channel of the
+ *  sequence.  Called when the thru button of the sequence is turned on, or
+ *  its buss or channel is changed.  The route is used only while the
+ *  sequence is an input target (see set_sequence_input()).
+ *
+ * \threadsafe
+ *
+ * \param seq
+ *      The sequence, used to identify the route, and to check the channel
+ *      of the input.
+ *
+ * \param bus
+ *      The output buss of the sequence.
+ *
+ * \param channel
+ *      The output channel of the sequence.
+ */
+
+void
+mastermidibase::set_thru_route
+(
+    const sequence * seq, bussbyte bus, midibyte channel
+)
+{
+    automutex locker(m_mutex);
+    std::vector<thru_route>::iterator r;
+    for (r = m_thru_routes.begin(); r != m_thru_routes.end(); ++r)
+    {
+        if (r->m_seq == seq && r->m_bus == bus && r->m_channel == channel)
+            return;                             /* notes still sounding     */
+    }
+    clear_thru_route(seq);                      /* buss or channel moved    */
+
+    thru_route route;
+    route.m_seq = seq;
+    route.m_bus = bus;
+    route.m_channel = channel;
+    memset(route.m_notes, 0, sizeof route.m_notes);
+    m_thru_routes.push_back(route);
+}
+
+/**
+ *  Removes the MIDI thru route of a sequence, if any, first turning off the
+ *  notes still sounding through it.
+ *
+ * \threadsafe
+ *
+ * \param seq
+ *      The sequence whose thru button was turned off.
+ */
+
+void
+mastermidibase::clear_thru_route (const sequence * seq)
+{
+    automutex locker(m_mutex);
+    std::vector<thru_route>::iterator r;
+    for (r = m_thru_routes.begin(); r != m_thru_routes.end(); ++r)
+    {
+        if (r->m_seq == seq)
+        {
+            if (release_thru_notes(*r))
+                flush();
+
+            m_thru_routes.erase(r);
+            break;
+        }
+    }
+}
+
+/**
+ *  Turns off the notes still sounding through a MIDI thru route, and forgets
+ *  them.  The caller must hold m_mutex, and flush the busses if needed.
+ *
+ * \param route
+ *      The route whose notes are to be turned off.
+ *
+ * \return
+ *      Returns true if any Note Off was played.
+ */
+
+bool
+mastermidibase::release_thru_notes (thru_route & route)
+{
+    bool result = false;
+    event off;
+    off.set_status(EVENT_NOTE_OFF);
+    for (int note = 0; note < SEQ64_MIDI_NOTES_MAX; ++note)
+    {
+        if (route.m_notes[note] > 0)
+        {
+            off.set_data(midibyte(note), 0);
+            m_outbus_array.play(route.m_bus, &off, route.m_channel);
+            route.m_notes[note] = 0;
+            result = true;
+        }
+    }
+    return result;
+}
+
+/**
+ *  The MIDI thru fast path.  Sends an incoming channel event to the buss and
+ *  channel of the first thru route whose sequence takes it, at once, as the
+ *  input thread reads it.  A sequence takes the event if it is an input
+ *  target (see is_input_target()) and sequence::channel_match() accepts the
+ *  channel of the event, the same test that recording makes; thus thru goes
+ *  where recording goes, as it did when sequence::stream_event() played it.
+ *  No sequence is locked, and nothing is allocated.  Recording is a separate
+ *  consumer of the same event, done afterward.
+ *
+ *  The channel nybble of the event is cleared while the event is played,
+ *  since the buss adds the output channel, and is then put back.
+ *
+ * \threadsafe
+ *
+ * \param ev
+ *      The incoming event, with its channel nybble.
+ *
+ * \return
+ *      Returns true if the event was sent.
+ */
+
+bool
+mastermidibase::thru (event & ev)
+{
+    midibyte status = ev.get_status();
+    if (! event::is_channel_msg(status & EVENT_CLEAR_CHAN_MASK))
+        return false;
+
+    bool result = false;
+    automutex locker(m_mutex);
+    std::vector<thru_route>::iterator r;
+    for (r = m_thru_routes.begin(); r != m_thru_routes.end(); ++r)
+    {
+        if (is_input_target(r->m_seq) && r->m_seq->channel_match(ev))
+        {
+            ev.set_status(status);              /* clear the channel nybble */
+            midibyte & count = r->m_notes[ev.get_note()];
+            bool skip = false;
+            if (ev.is_note_on())
+            {
+                if (count < 0xFF)
+                    ++count;
+            }
+            else if (ev.is_note_off())
+            {
+                if (count == 0)
+                    skip = true;                /* never passed its Note On */
+                else
+                    --count;
+            }
+            if (! skip)
+            {
+                m_outbus_array.play(r->m_bus, &ev, r->m_channel);
+                result = true;
+            }
+            ev.set_status_keep_channel(status);
+            break;
+        }
+    }
+    if (result)
+        flush();
+
+    return result;
+}
+
 }           // namespace seq64
 
 /*
@@ -508,8 +508,8 @@ midi_container::song_fill_seq_event
     for (int p = 0; p <= times_played; ++p)
     {
         midipulse delta_time = 0;
-        event_list::Events::iterator i;
-        for (i = m_sequence.events().begin(); i != m_sequence.events().end(); ++i)
+        event_list::const_iterator i;
+        for (i = m_sequence.events().cbegin(); i != m_sequence.events().cend(); ++i)
         {
             const event & e = DREF(i);
             midipulse timestamp = e.get_timestamp() + timestamp_adjust;
@@ -669,7 +669,7 @@ midi_container::song_fill_seq_trigger
 void
 midi_container::fill (int track, const perform & p)
 {
-    event_list evl = m_sequence.events();           /* used below */
+    const event_list evl = m_sequence.events();     /* shared, no copying */
     fill_seq_number(track);
     fill_seq_name(m_sequence.name());
 
@@ -689,10 +689,9 @@ midi_container::fill (int track, const perform & p)
     midipulse timestamp = 0;
     midipulse deltatime = 0;
     midipulse prevtimestamp = 0;
-    for (event_list::iterator i = evl.begin(); i != evl.end(); ++i)
+    for (event_list::const_iterator i = evl.begin(); i != evl.end(); ++i)
     {
-        event & er = DREF(i);
-        const event & e = er;
+        const event & e = DREF(i);
         timestamp = e.get_timestamp();
         deltatime = timestamp - prevtimestamp;
         if (deltatime < 0)                          /* midipulse == long    */
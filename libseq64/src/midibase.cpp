@@ -176,7 +176,10 @@ midibase::midibase
     m_is_virtual_port   (makevirtual),
     m_is_input_port     (isinput),
     m_is_system_port    (makesystem),
-    m_mutex             ()
+    m_mutex             (),
+    m_sysex             (),
+    m_sysex_mutex       (),
+    m_input_age         (0)
 {
     if (! makevirtual)
     {
@@ -446,7 +449,8 @@ midibase::poll_for_midi ()
 }
 
 /**
- *  Obtains a MIDI event.
+ *  Obtains a MIDI event.  The input age is cleared first, for the MIDI APIs
+ *  that do not set it (see input_age()).
  *
  * \param inev
  *      Points the event to be filled with the MIDI event data.
@@ -459,6 +463,7 @@ midibase::poll_for_midi ()
 bool
 midibase::get_midi_event (event * inev)
 {
+    m_input_age = 0;
     return api_get_midi_event(inev);
 }
 
@@ -562,18 +567,131 @@ midibase::play (event * e24, midibyte channel)
 }
 
 /**
- *  Takes a native SYSEX event, encodes it to an ALSA event, and then
- *  puts it in the queue.
+ *  Like play(), but puts the event on the output queue of the MIDI API, to
+ *  be sent at the given tick of that queue.
+ *
+ * \threadsafe
  *
  * \param e24
- *      The event to be handled.
+ *      The event to be played on this bus.
+ *
+ * \param channel
+ *      The channel of the playback.
+ *
+ * \param tick
+ *      The queue tick at which the event is to be sent.
+ *
+ * \param tag
+ *      A value that marks the event, so that it can be cancelled later.
+ *      The tag that mastermidibase::pattern_tag() lent to the pattern that
+ *      plays the event.
+ */
+
+void
+midibase::play_at (event * e24, midibyte channel, midipulse tick, int tag)
+{
+    automutex locker(m_mutex);
+    api_play_at(e24, channel, tick, tag);
+}
+
+/**
+ *  Like play(), but writes the event at the given frame of the current
+ *  process cycle of the MIDI API.  Used only by the engine mode (see
+ *  mastermidibase::set_engine()), from the process thread.  It does not
+ *  lock, because it must not block that thread; the API keeps what it
+ *  touches here to that thread.
+ *
+ * \param e24
+ *      The event to be played on this bus.
+ *
+ * \param channel
+ *      The channel of the playback.
+ *
+ * \param frame
+ *      The frame offset in the current cycle.
+ */
+
+void
+midibase::play_frame (event * e24, midibyte channel, int frame)
+{
+    api_play_frame(e24, channel, frame);
+}
+
+/**
+ *  Like play(), but tells the MIDI API how long ago the event was due, so
+ *  that an API that stamps its output with a time (JACK) can keep the
+ *  events of an output frame at their own spacing.  See
+ *  mastermidibase::batch_end().
+ *
+ * \threadsafe
+ *
+ * \param e24
+ *      The event to be played on this bus.
+ *
+ * \param channel
+ *      The channel of the playback.
+ *
+ * \param ago_us
+ *      How long before now the event was due, in microseconds.
  */
 
 void
-midibase::sysex (event * e24)
+midibase::play_due (event * e24, midibyte channel, long ago_us)
 {
     automutex locker(m_mutex);
-    api_sysex(e24);
+    api_play_due(e24, channel, ago_us);
+}
+
+/**
+ *  Sends a native SYSEX event.  The message is sent in pieces of the size
+ *  set by rc().sysex_chunk(), each sent by api_sysex() under the lock, and
+ *  each followed by a wait, if need be, to keep to the rate set by
+ *  rc().sysex_rate().  The locks are not held during the waits, so that
+ *  playback on the buss goes on during a long dump.  If the MIDI API cannot
+ *  take a piece, the rest of the message is dropped.
+ *
+ * \threadsafe
+ *
+ * \param e24
+ *      The event to be handled.
+ *
+ * \param master
+ *      If not null, the lock of the master buss, which is also held while
+ *      each piece is sent, before the lock of this buss.  Some MIDI APIs
+ *      (ALSA) write all busses through one client handle, which the output
+ *      thread uses under that lock.
+ */
+
+void
+midibase::sysex (event * e24, const mutex * master)
+{
+    automutex sending(m_sysex_mutex);
+    const event::SysexContainer & data = e24->get_sysex();
+    int size = e24->get_sysex_size();
+    int chunk = rc().sysex_chunk();
+    int sent = 0;
+    bool ok = true;
+    m_sysex.start_output(rc().sysex_rate());
+    while (ok && sent < size)
+    {
+        int len = size - sent < chunk ? size - sent : chunk ;
+        if (not_nullptr(master))
+            master->lock();
+
+        {
+            automutex locker(m_mutex);
+            ok = api_sysex(&data[sent], len);
+        }
+        if (not_nullptr(master))
+            master->unlock();
+
+        if (ok)
+        {
+            sent += len;
+            m_sysex.pace(sent);
+        }
+    }
+    m_sysex.end_output(sent, size - sent);
 }
 
 /**
@@ -746,6 +864,36 @@ midibase::clock (midipulse tick)
     }
 }
 
+/**
+ *  The form of clock() for the engine (see mastermidibase::engine_clock()),
+ *  which sends the clock events itself, each at its own frame.  Advances the
+ *  clock to the next clock tick due, no further than the given tick.  No
+ *  lock is taken; only the engine drives the clock while it runs.
+ *
+ * \param tick
+ *      Provides the last tick of the current cycle.
+ *
+ * \return
+ *      Returns the next clock tick due, or SEQ64_NULL_MIDIPULSE if none is
+ *      due by the given tick, or the clock is off.
+ */
+
+midipulse
+midibase::next_clock (midipulse tick)
+{
+    if (m_clock_type != e_clock_off)
+    {
+        int ct = clock_ticks_from_ppqn(m_ppqn);         /* ppqn / 24    */
+        while (m_lasttick < tick)
+        {
+            ++m_lasttick;
+            if ((m_lasttick % ct) == 0)                 /* tick time?   */
+                return m_lasttick;
+        }
+    }
+    return SEQ64_NULL_MIDIPULSE;
+}
+
 /**
  * Shows most midibase members.
  */
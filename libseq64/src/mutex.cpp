@@ -24,7 +24,7 @@
  * \library       sequencer64 application
  * \author        Seq24 team; modifications by Chris Ahlstrom
  * \date          2015-07-24
- * \updates       2017-09-03
+ * \updates       2017-09-05
  * \license       GNU GPLv2 or above
  *
  *  Sequencer64 needs a mutex for sequencer operations.
@@ -87,6 +87,21 @@ mutex::lock () const
     pthread_mutex_lock(&m_mutex_lock);
 }
 
+/**
+ *  Locks the mutex, but only if that can be done without waiting.  Meant
+ *  for the real-time JACK process thread, which must never block.
+ *
+ * \return
+ *      Returns true if the mutex is now locked, and must be unlocked by the
+ *      caller.
+ */
+
+bool
+mutex::try_lock () const
+{
+    return pthread_mutex_trylock(&m_mutex_lock) == 0;
+}
+
 /**
  *  Unlock the mutex.
  */
@@ -98,7 +113,10 @@ mutex::unlock () const
 }
 
 /**
- *  Initialize the condition variable with the global variable.
+ *  Initialize the condition variable with the global variable.  Except on
+ *  Windows, it is then set up to time its waits with CLOCK_MONOTONIC, so that
+ *  the deadline given to wait_until() is not affected by changes to the
+ *  system time.
  */
 
 condition_var::condition_var ()
@@ -106,7 +124,24 @@ condition_var::condition_var ()
     mutex   (),                         // @new ca 2016-05-06 (!)
     m_cond  (sm_cond)
 {
-    // Empty body
+#ifndef PLATFORM_WINDOWS
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&m_cond, &attr);
+    pthread_condattr_destroy(&attr);
+#endif
+}
+
+/**
+ *  Frees the condition variable.
+ */
+
+condition_var::~condition_var ()
+{
+#ifndef PLATFORM_WINDOWS
+    pthread_cond_destroy(&m_cond);
+#endif
 }
 
 /**
@@ -129,6 +164,25 @@ condition_var::wait ()
     pthread_cond_wait(&m_cond, &m_mutex_lock);
 }
 
+/**
+ *  Waits for the condition variable, but not past the given time.  Like
+ *  wait(), the mutex must be locked (once) by the caller.
+ *
+ * \param deadline
+ *      The absolute CLOCK_MONOTONIC time at which to give up waiting.  On
+ *      Windows the default clock is used, so this function is not used there.
+ *
+ * \return
+ *      Returns true if the condition was signalled (or the wait ended
+ *      spuriously) before the deadline.
+ */
+
+bool
+condition_var::wait_until (const struct timespec & deadline)
+{
+    return pthread_cond_timedwait(&m_cond, &m_mutex_lock, &deadline) == 0;
+}
+
 }           // namespace seq64
 
 /*
@@ -0,0 +1,199 @@
+/*
+ *  This file is part of seq24/sequencer64.
+ *
+ *  seq24 is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  seq24 is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with seq24; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          node_pool.cpp
+ *
+ *  This module defines the pool of fixed-size blocks used for the event and
+ *  trigger nodes of a sequence.
+ *
+ * \library       sequencer64 application
+ * \author        Chris Ahlstrom
+ * \date          2017-09-06
+ * \updates       2017-09-06
+ * \license       GNU GPLv2 or above
+ */
+
+#include "easy_macros.h"                /* not_nullptr()                */
+#include "node_pool.hpp"                /* seq64::node_pool             */
+
+/**
+ *  The number of blocks in the first chunk of a pool, and the most blocks
+ *  in any chunk.
+ */
+
+#define SEQ64_POOL_FIRST_CHUNK          64
+#define SEQ64_POOL_MAX_CHUNK            4096
+
+/*
+ *  Do not document a namespace; it breaks Doxygen.
+ */
+
+namespace seq64
+{
+
+/**
+ *  Default constructor.  No memory is taken until the first allocation.
+ */
+
+node_pool::node_pool ()
+ :
+    m_mutex         (),
+    m_chunks        (),
+    m_free          (nullptr),
+    m_fresh         (nullptr),
+    m_fresh_end     (nullptr),
+    m_request_size  (0),
+    m_block_size    (0),
+    m_chunk_blocks  (SEQ64_POOL_FIRST_CHUNK),
+    m_in_use        (0)
+{
+    // Empty body
+}
+
+/**
+ *  Frees all of the chunks.  By now, every container that used the pool
+ *  is gone, since each one holds a reference to it.
+ */
+
+node_pool::~node_pool ()
+{
+    free_chunks();
+}
+
+/**
+ *  Gets a block.  The first call fixes the block size of the pool.
+ *
+ * \param bytes
+ *      The size of the block.  If it is not the size fixed by the first
+ *      call, the global operator new() is used instead.
+ *
+ * \return
+ *      Returns the block.  Throws std::bad_alloc if memory runs out, like
+ *      operator new().
+ */
+
+void *
+node_pool::allocate (std::size_t bytes)
+{
+    automutex locker(m_mutex);
+    if (m_request_size == 0)
+    {
+        const std::size_t align = sizeof(long double) > sizeof(void *) ?
+            sizeof(long double) : sizeof(void *) ;
+
+        m_request_size = bytes;
+        m_block_size = (bytes + align - 1) / align * align;
+    }
+    if (bytes != m_request_size)
+        return ::operator new(bytes);
+
+    void * result;
+    if (not_nullptr(m_free))
+    {
+        result = m_free;
+        m_free = m_free->m_next;
+    }
+    else
+    {
+        if (m_fresh == m_fresh_end)
+        {
+            std::size_t chunkbytes = m_chunk_blocks * m_block_size;
+            m_chunks.reserve(m_chunks.size() + 1);
+            m_fresh = static_cast<char *>(::operator new(chunkbytes));
+            m_fresh_end = m_fresh + chunkbytes;
+            m_chunks.push_back(m_fresh);
+            if (m_chunk_blocks < SEQ64_POOL_MAX_CHUNK)
+                m_chunk_blocks *= 2;
+        }
+        result = m_fresh;
+        m_fresh += m_block_size;
+    }
+    ++m_in_use;
+    return result;
+}
+
+/**
+ *  Returns a block to the pool, for reuse.
+ *
+ * \param p
+ *      The block, as returned by allocate().
+ *
+ * \param bytes
+ *      The size that was given to allocate().
+ */
+
+void
+node_pool::deallocate (void * p, std::size_t bytes)
+{
+    automutex locker(m_mutex);
+    if (bytes != m_request_size)
+    {
+        ::operator delete(p);
+    }
+    else
+    {
+        free_block * fb = static_cast<free_block *>(p);
+        fb->m_next = m_free;
+        m_free = fb;
+        --m_in_use;
+    }
+}
+
+/**
+ *  Frees all of the chunks at once, if no block is in use, as after
+ *  clearing a pattern.  Otherwise, does nothing, and the freed blocks wait
+ *  for reuse.
+ */
+
+void
+node_pool::release ()
+{
+    automutex locker(m_mutex);
+    if (m_in_use == 0)
+    {
+        free_chunks();
+        m_free = nullptr;
+        m_fresh = m_fresh_end = nullptr;
+        m_chunk_blocks = SEQ64_POOL_FIRST_CHUNK;
+    }
+}
+
+/**
+ *  Returns all of the chunks to the heap.  The caller must hold the lock,
+ *  or be the destructor.
+ */
+
+void
+node_pool::free_chunks ()
+{
+    std::vector<char *>::iterator i;
+    for (i = m_chunks.begin(); i != m_chunks.end(); ++i)
+        ::operator delete(*i);
+
+    m_chunks.clear();
+}
+
+}           // namespace seq64
+
+/*
+ * node_pool.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
+
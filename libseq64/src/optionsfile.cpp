@@ -221,6 +221,30 @@ optionsfile::error_message
  *  Set to 1 if you want seq24 to create its own ALSA ports and not
  *  connect to other clients.
  *
+ *  [output-lookahead]
+ *
+ *  The look-ahead, in milliseconds, of the scheduled output mode.  If not
+ *  0, events are rendered this far ahead, and put on the ALSA queue with
+ *  their exact time stamps, so that their timing depends on the ALSA timer
+ *  instead of on the wake-ups of the output thread.
+ *
+ *  [jack-engine]
+ *
+ *  Set to 1 to run the playback engine in the JACK process callback, when
+ *  native JACK MIDI is used.  Each JACK cycle then renders its own events,
+ *  at their exact frames, with no output thread in between.
+ *
+ *  [undo-memory-limit]
+ *
+ *  The memory limit, in kilobytes, of the undo history of each pattern.
+ *  The oldest undo steps are dropped once it is reached.  0 means no limit.
+ *
+ *  [sysex-pacing]
+ *
+ *  The size, in bytes, of the pieces outgoing SysEx messages are sent in,
+ *  and the rate, in bytes per second, at which they are sent.  A rate of 0
+ *  sends them as fast as the MIDI API takes them.
+ *
  *  [last-used-dir]
  *
  *  This section simply holds the last path-name that was used to read or
@@ -659,6 +683,36 @@ optionsfile::parse (perform & p)
         if (! rc().reveal_alsa_ports())
             rc().reveal_alsa_ports(bool(flag));
     }
+    if (line_after(file, "[output-lookahead]"))
+    {
+        int ms = 0;
+        sscanf(m_line, "%d", &ms);
+        rc().output_lookahead(ms);
+    }
+    if (line_after(file, "[jack-engine]"))
+    {
+        int flag = 0;
+        sscanf(m_line, "%d", &flag);
+        rc().jack_engine(bool(flag));
+    }
+    if (line_after(file, "[undo-memory-limit]"))
+    {
+        int kb = SEQ64_UNDO_MEMORY_DEFAULT;
+        sscanf(m_line, "%d", &kb);
+        rc().undo_memory_limit(kb);
+    }
+    if (line_after(file, "[sysex-pacing]"))
+    {
+        int chunk = SEQ64_SYSEX_CHUNK_DEFAULT;
+        int rate = SEQ64_SYSEX_RATE_DEFAULT;
+        sscanf(m_line, "%d", &chunk);
+        rc().sysex_chunk(chunk);
+        if (next_data_line(file))
+        {
+            sscanf(m_line, "%d", &rate);
+            rc().sysex_rate(rate);
+        }
+    }
 
     if (line_after(file, "[last-used-dir]"))
     {
@@ -1235,6 +1289,70 @@ optionsfile::write (const perform & p)
         << "   # flag for reveal ALSA ports\n"
         ;
 
+    /*
+     * Scheduled output look-ahead
+     */
+
+    file
+        << "\n[output-lookahead]\n\n"
+        << "# Set to the number of milliseconds (e.g. 20) by which to render\n"
+        << "# the output ahead of time, putting each event on the ALSA queue\n"
+        << "# with its exact time stamp.  This removes the timing jitter due\n"
+        << "# to the output thread, at the cost of that much delay in muting.\n"
+        << "# Use 0 to send events directly, as they are played.\n"
+        << "\n"
+        << rc().output_lookahead()
+        << "   # look-ahead of scheduled output in ms\n"
+        ;
+
+    /*
+     * JACK process engine
+     */
+
+    file
+        << "\n[jack-engine]\n\n"
+        << "# Set to 1 to play the patterns from the JACK process callback,\n"
+        << "# when native JACK MIDI is used.  The events of each JACK cycle\n"
+        << "# are then written at their exact frames, with no output thread\n"
+        << "# and no ring-buffer in between.  Set to 0 to use the output\n"
+        << "# thread.\n"
+        << "\n"
+        << (rc().jack_engine() ? "1" : "0")
+        << "   # flag for the JACK process engine\n"
+        ;
+
+    /*
+     * Undo history memory limit
+     */
+
+    file
+        << "\n[undo-memory-limit]\n\n"
+        << "# Set to the number of kilobytes of undo history to keep for each\n"
+        << "# pattern.  The oldest undo steps are dropped past this limit.\n"
+        << "# Use 0 to keep all of the undo history.\n"
+        << "\n"
+        << rc().undo_memory_limit()
+        << "   # undo memory limit per pattern in kB\n"
+        ;
+
+    /*
+     * SysEx pacing
+     */
+
+    file
+        << "\n[sysex-pacing]\n\n"
+        << "# The first number is the size, in bytes, of the pieces in which\n"
+        << "# SysEx messages (e.g. patch dumps) are sent.  The second is the\n"
+        << "# rate, in bytes per second, at which they are sent; 3125 is the\n"
+        << "# speed of a DIN MIDI cable.  Use a lower rate for devices that\n"
+        << "# need time to digest a dump, and 0 to send as fast as possible.\n"
+        << "\n"
+        << rc().sysex_chunk()
+        << "   # SysEx piece size in bytes\n"
+        << rc().sysex_rate()
+        << "   # SysEx rate in bytes per second\n"
+        ;
+
     /*
      * Interaction-method
      */
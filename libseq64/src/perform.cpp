@@ -139,7 +139,8 @@
 #include <windows.h>                    /* Muahhhahahahahah!                */
 #include <mmsystem.h>                   /* Windows timeBeginPeriod()        */
 #else
-#include <time.h>                       /* struct timespec                  */
+#include <errno.h>                      /* EINTR                            */
+#include <time.h>                       /* struct timespec, clock_nanosleep */
 #endif
 
 /**
@@ -289,6 +290,11 @@ perform::perform (gui_assistant & mygui, int ppqn)
     m_midi_mute_group_present   (false),
     m_seqs                      (),         // pointer array [c_max_sequence]
     m_seqs_active               (),         // boolean array [c_max_sequence]
+    m_active_seqs               (),         // two pointer arrays
+    m_active_count              (),         // both 0
+    m_active_index              (0),
+    m_active_readers            (0),
+    m_active_mutex              (),
     m_was_active_main           (),         // boolean array [c_max_sequence]
     m_was_active_edit           (),         // boolean array [c_max_sequence]
     m_was_active_perf           (),         // boolean array [c_max_sequence]
@@ -330,6 +336,13 @@ perform::perform (gui_assistant & mygui, int ppqn)
     m_midiclocktick             (0),
     m_midiclockpos              (-1),
     m_dont_reset_ticks          (false),
+    m_engine_rolling            (false),
+    m_engine_tick               (0.0),
+    m_engine_clock              (0.0),
+    m_engine_bpm                (0.0),
+    m_output_period_us          (c_thread_trigger_width_us),
+    m_output_late_count         (0),
+    m_output_worst_late_us      (0),
     m_screenset_notepad         (),         // string array [c_max_sets]
     m_midi_cc_toggle            (),         // midi_control []
     m_midi_cc_on                (),         // midi_control []
@@ -351,6 +364,9 @@ perform::perform (gui_assistant & mygui, int ppqn)
 #endif
     m_is_modified               (false),
     m_condition_var             (),
+    m_wake_var                  (),
+    m_output_wake               (false),
+    m_output_sleeping           (false),
 #ifdef SEQ64_JACK_SUPPORT
     m_jack_asst
     (
@@ -362,16 +378,18 @@ perform::perform (gui_assistant & mygui, int ppqn)
     ),
 #endif
     m_have_undo                 (false),
-    m_undo_vect                 (),          // vector of int
+    m_undo_vect                 (),
     m_have_redo                 (false),
-    m_redo_vect                 (),          // vector of int
+    m_redo_vect                 (),
+    m_undo_record_open          (false),
+    m_undo_bytes                (0),
     m_notify                    (),          // vector of callback pointers
     m_gui_support               (mygui)
 {
     keys().group_max(m_max_groups);
     for (int i = 0; i < m_sequence_max; ++i)
     {
-        m_seqs[i] = nullptr;
+        m_seqs[i] = m_active_seqs[0][i] = m_active_seqs[1][i] = nullptr;
         m_seqs_active[i] =                      /* seq24 0.9.3 addition     */
             m_sequence_state[i] =               /* ca 2016-11-27            */
             m_was_active_main[i] = m_was_active_edit[i] =
@@ -412,6 +430,7 @@ perform::~perform ()
 {
     m_inputing = m_outputing = m_running = false;
     m_condition_var.signal();                       /* signal end of play   */
+    wake_output();                                  /* end any idle sleep   */
     if (m_out_thread_launched)
         pthread_join(m_out_thread, NULL);
 
@@ -490,6 +509,24 @@ perform::launch (int ppqn)
 
         m_master_bus->init(ppqn, m_bpm);     /* calls api_init() per API */
 
+        int lookahead = rc().output_lookahead();
+        if (lookahead > 0 && ! m_master_bus->set_lookahead(lookahead))
+        {
+            warnprint("Scheduled output not supported, using direct output");
+        }
+
+        if (rc().jack_engine())
+        {
+            if (rc().with_jack())
+            {
+                warnprint("JACK engine ignores JACK transport, not used");
+            }
+            else if (! m_master_bus->set_engine(engine_func, this))
+            {
+                warnprint("JACK engine needs native JACK MIDI, not used");
+            }
+        }
+
         /*
          * We may need to copy the actually input buss settings back to here,
          * as they can change.  LATER.  They get saved properly anyway,
@@ -500,7 +537,8 @@ perform::launch (int ppqn)
         if (activate())
         {
             launch_input_thread();
-            launch_output_thread();
+            if (! m_master_bus->engine())       /* JACK cycles do output    */
+                launch_output_thread();
         }
     }
 }
@@ -549,6 +587,8 @@ perform::clear_all ()
         m_undo_vect.clear();                    /* ca 2016-08-16            */
         set_have_redo(false);
         m_redo_vect.clear();                    /* ca 2016-08-16            */
+        m_undo_record_open = false;
+        m_undo_bytes = 0;
         is_modified(false);                     /* new, we start afresh     */
     }
     return result;
@@ -1293,6 +1333,8 @@ perform::set_left_tick (midipulse tick, bool setstart)
     m_reposition = false;
     if (m_left_tick >= m_right_tick)
         m_right_tick = m_left_tick + m_one_measure;
+
+    wake_output();
 }
 
 /**
@@ -1331,6 +1373,7 @@ perform::set_right_tick (midipulse tick, bool setstart)
                 m_reposition = false;
             }
         }
+        wake_output();
     }
 }
 
@@ -1363,6 +1406,12 @@ perform::install_sequence (sequence * seq, int seqnum)
     if (not_nullptr(m_seqs[seqnum]))
     {
         errprintf("m_seqs[%d] not null, deleting old sequence\n", seqnum);
+        if (m_seqs_active[seqnum])
+        {
+            remove_active(seqnum);              /* re-added for new one */
+            m_seqs_active[seqnum] = false;
+        }
+        forget_trigger_changes(seqnum);
         delete m_seqs[seqnum];
         m_seqs[seqnum] = nullptr;
         if (m_sequence_count > 0)
@@ -1507,6 +1556,10 @@ perform::new_sequence (int seq)
  *  false.  But there are a few other flags that are not modified; shouldn't
  *  we also falsify them here?
  *
+ *  set_active() takes the sequence out of the active list, and returns only
+ *  when no reader of that list, such as the output thread, can still be
+ *  using it (see publish_active()).  Only then is it deleted.
+ *
  * \param seq
  *      The sequence number of the sequence to be deleted.  It is validated.
  */
@@ -1520,6 +1573,7 @@ perform::delete_sequence (int seq)
         if (! m_seqs[seq]->get_editing())           /* clarify this!        */
         {
             m_seqs[seq]->set_playing(false);
+            forget_trigger_changes(seq);
             delete m_seqs[seq];
             m_seqs[seq] = nullptr;
             modify();                               /* it is dirty, man     */
@@ -1548,6 +1602,13 @@ perform::set_active (int seq, bool active)
         if (m_seqs_active[seq] && ! active)
             set_was_active(seq);
 
+        if (active != m_seqs_active[seq])
+        {
+            if (active)
+                add_active(seq);
+            else
+                remove_active(seq);
+        }
         m_seqs_active[seq] = active;
         if (active)
         {
@@ -1558,6 +1619,98 @@ perform::set_active (int seq, bool active)
     }
 }
 
+/**
+ *  Adds a sequence to the packed list of active sequences, m_active_seqs[],
+ *  keeping the list in order of sequence number, which is the order in which
+ *  the patterns have always been played.  The sequence must not already be
+ *  in the list.  The new list is built in the copy that readers are not
+ *  using, and then published.
+ *
+ * \threadsafe
+ *
+ * \param seq
+ *      Provides the sequence number, already validated.
+ */
+
+void
+perform::add_active (int seq)
+{
+    automutex locker(m_active_mutex);
+    int current = m_active_index;
+    int next = 1 - current;
+    int position = 0;
+    for (int s = 0; s < seq; ++s)
+    {
+        if (m_seqs_active[s])
+            ++position;
+    }
+
+    sequence ** from = m_active_seqs[current];
+    sequence ** to = m_active_seqs[next];
+    int count = m_active_count[current];
+    for (int i = 0; i < position; ++i)
+        to[i] = from[i];
+
+    to[position] = m_seqs[seq];
+    for (int i = position; i < count; ++i)
+        to[i + 1] = from[i];
+
+    m_active_count[next] = count + 1;
+    publish_active(next);
+}
+
+/**
+ *  Removes a sequence from the packed list of active sequences.  See
+ *  add_active().  When this function returns, no reader can still be
+ *  using the sequence, so the caller may delete it.
+ *
+ * \threadsafe
+ *
+ * \param seq
+ *      Provides the sequence number, already validated.
+ */
+
+void
+perform::remove_active (int seq)
+{
+    automutex locker(m_active_mutex);
+    int current = m_active_index;
+    int next = 1 - current;
+    int count = 0;
+    for (int i = 0; i < m_active_count[current]; ++i)
+    {
+        sequence * s = m_active_seqs[current][i];
+        if (s != m_seqs[seq])
+            m_active_seqs[next][count++] = s;
+    }
+    if (count < m_active_count[current])
+    {
+        m_active_count[next] = count;
+        publish_active(next);
+    }
+}
+
+/**
+ *  Makes the given copy of m_active_seqs[] the one that readers use, then
+ *  waits until no reader is left, since one might have started on the
+ *  old copy.  After that, the old copy can be written, and a sequence
+ *  that is only in the old copy can be deleted.  A reader holds the list
+ *  for the length of one loop, at most one output frame, so the wait is
+ *  short; the writers are the user interface and file loading.  The caller
+ *  must hold m_active_mutex.
+ *
+ * \param next
+ *      The copy to publish, 0 or 1.
+ */
+
+void
+perform::publish_active (int next)
+{
+    m_active_index = next;
+    while (m_active_readers > 0)
+        sched_yield();
+}
+
 /**
  *  Sets was-active flags:  main, edit, perf, and names.
  *  Why do we need this routine?
@@ -1711,6 +1864,10 @@ perform::is_dirty_names (int seq)
  *  changed the beats per minute.  This setting does get saved to the MIDI
  *  file, with the c_bpmtag.
  *
+ *  If called by the JACK process engine, the tempo is only noted, and set
+ *  by engine_tempo() in a later cycle, since the engine must not wait on the
+ *  lock of the master buss.
+ *
  * \param bpm
  *      Provides the beats/minute value to be set.  It is clamped, if
  *      necessary, between the values SEQ64_MINIMUM_BPM to SEQ64_MAXIMUM_BPM.
@@ -1726,6 +1883,11 @@ perform::set_beats_per_minute (midibpm bpm)
     else if (bpm > SEQ64_MAXIMUM_BPM)
         bpm = SEQ64_MAXIMUM_BPM;
 
+    if (not_nullptr(m_master_bus) && m_master_bus->in_engine())
+    {
+        m_engine_bpm = bpm;                         /* see engine_tempo()   */
+        return;
+    }
     if (bpm != m_bpm)
     {
 
@@ -1745,6 +1907,7 @@ perform::set_beats_per_minute (midibpm bpm)
         m_master_bus->set_beats_per_minute(bpm);
         m_us_per_quarter_note = tempo_us_from_bpm(bpm);
         m_bpm = bpm;
+        wake_output();                              /* event times changed  */
 
         /*
          * Do we need to adjust the BPM of all of the sequences, including the
@@ -2277,6 +2440,18 @@ perform::set_playing_screenset ()
  *  Finally, we stop the looping at m_sequence_high rather than
  *  m_sequence_max, to save a little time.
  *
+ *  In the scheduled output mode (see mastermidibase::set_lookahead()), the
+ *  patterns play up to the look-ahead past the tick, and their events are
+ *  queued to go out at their own ticks.  When looping in the song editor,
+ *  the look-ahead stops at the right marker; the loop restart cancels
+ *  anything queued.
+ *
+ *  The output of the frame is batched (see mastermidibase::batch_begin()),
+ *  so that the events of all patterns go out under one lock and one flush,
+ *  rather than a lock and a flush for each event.  Each event goes out with
+ *  the time since its own tick, so that a JACK buss can place it at the
+ *  frame of that tick.
+ *
  * \param tick
  *      Provides the tick at which to start playing.  This value is also
  *      copied to m_tick.
@@ -2286,13 +2461,30 @@ void
 perform::play (midipulse tick)
 {
     m_tick = tick;
-    for (int s = 0; s < m_sequence_high; ++s)       /* modest speed up  */
+    if (is_nullptr(m_master_bus))
+        return;
+
+    m_master_bus->batch_begin();                    /* see batch_end()      */
+    midipulse endtick = m_master_bus->frame_start(tick);
+    if (m_master_bus->scheduled())
     {
-        if (is_active(s))
-            m_seqs[s]->play_queue(tick, m_playback_mode);
+        bool perfloop = m_looping &&
+            (m_playback_mode || start_from_perfedit() || song_start_mode());
+
+        if (perfloop)                               /* see output_func()    */
+        {
+            midipulse rtick = get_right_tick() - 1; /* do not look past it  */
+            if (endtick > rtick)
+                endtick = tick > rtick ? tick : rtick ;
+        }
+        tick = endtick;
     }
-    if (not_nullptr(m_master_bus))
-        m_master_bus->flush();                       /* flush MIDI buss  */
+
+    active_list active(*this);
+    for (int i = 0; i < active.count(); ++i)
+        active[i]->play_queue(tick, m_playback_mode);
+
+    m_master_bus->batch_end();                      /* send, flush once     */
 }
 
 /**
@@ -2308,11 +2500,12 @@ perform::play (midipulse tick)
 void
 perform::set_orig_ticks (midipulse tick)
 {
-    for (int s = 0; s < m_sequence_max; ++s)        /* m_sequence_high  */
-    {
-        if (is_active(s))
-            m_seqs[s]->set_last_tick(tick);         /* set_orig_tick()  */
-    }
+    if (not_nullptr(m_master_bus))
+        m_master_bus->cancel_scheduled();           /* a change of position */
+
+    active_list active(*this);
+    for (int i = 0; i < active.count(); ++i)
+        active[i]->set_last_tick(tick);
 }
 
 /**
@@ -2354,110 +2547,213 @@ perform::move_triggers (bool direction)
 }
 
 /**
- *  For every active sequence, call that sequence's push_trigger_undo()
- *  function.  Too bad we cannot yet keep track of all the undoes for the sake
- *  of properly handling the "is modified" flag.
+ *  Gets the approximate memory used by one change in the trigger journal.
  *
- *  This function now has a new parameter.  Not added to this function is the
- *  seemingly redundant undo-push the seq32 code does; is this actually a
- *  seq42 thing?
+ * \param trigs
+ *      The triggers held by the change.
  *
- *  Also, there is still an issue with our undo-handling for a single track.
- *  See pop_trigger_undo().
+ * \return
+ *      Returns the size of the change plus its list nodes.
+ */
+
+std::size_t
+perform::change_bytes (const triggers::List & trigs)
+{
+    return sizeof(trigger_change) +
+        trigs.size() * (sizeof(trigger) + 2 * sizeof(void *));
+}
+
+/**
+ *  Finds the tracks whose triggers changed since they were last saved, and
+ *  saves them.  If an undo record is open, the triggers they had before go
+ *  into it.  Changes made with no undo record open are not undoable, as
+ *  before.  This compares the trigger lists, but copies only the ones that
+ *  changed.
+ */
+
+void
+perform::collect_trigger_changes ()
+{
+    active_list active(*this);
+    for (int i = 0; i < active.count(); ++i)
+    {
+        sequence * s = active[i];
+        triggers::List previous;
+        if (s->save_triggers(previous) && m_undo_record_open)
+        {
+            m_undo_bytes += change_bytes(previous);
+            m_undo_vect.back().push_back(trigger_change());
+
+            trigger_change & tc = m_undo_vect.back().back();
+            tc.m_track = s->number();
+            tc.m_triggers.swap(previous);
+        }
+    }
+}
+
+/**
+ *  Removes a track from the trigger undo and redo histories, when its
+ *  sequence is deleted, so that its triggers are not put back into another
+ *  sequence that takes its slot.
  *
  * \param track
- *      A new parameter (found in the stazed seq32 code) that allows this
- *      function to operate on a single track.  A parameter value of
- *      SEQ64_ALL_TRACKS (-1, the default) implements the original behavior.
+ *      The number of the track to forget.
  */
 
 void
-perform::push_trigger_undo (int track)
+perform::forget_trigger_changes (int track)
 {
-    m_undo_vect.push_back(track);                       /* stazed   */
-    if (track == SEQ64_ALL_TRACKS)
+    for (std::size_t r = 0; r < m_undo_vect.size(); ++r)
     {
-        for (int i = 0; i < m_sequence_max; ++i)        /* m_sequence_high  */
+        TriggerRecord & rec = m_undo_vect[r];
+        for (std::size_t c = 0; c < rec.size(); /* conditional */)
         {
-            if (is_active(i))
-                m_seqs[i]->push_trigger_undo();
+            if (rec[c].m_track == track)
+            {
+                m_undo_bytes -= change_bytes(rec[c].m_triggers);
+                rec.erase(rec.begin() + c);
+            }
+            else
+                ++c;
         }
     }
-    else
+    for (std::size_t r = 0; r < m_redo_vect.size(); ++r)
     {
-        if (is_active(track))
-            m_seqs[track]->push_trigger_undo();
+        TriggerRecord & rec = m_redo_vect[r];
+        for (std::size_t c = 0; c < rec.size(); /* conditional */)
+        {
+            if (rec[c].m_track == track)
+                rec.erase(rec.begin() + c);
+            else
+                ++c;
+        }
     }
-    set_have_undo(true);                                /* stazed   */
 }
 
 /**
- *  For every active sequence, call that sequence's pop_trigger_undo()
- *  function.
+ *  Drops the oldest trigger undo records until the history fits in the
+ *  "[undo-memory-limit]".  The newest record is always kept.  The redo
+ *  history is not trimmed; it can only hold what undo once held.
+ */
+
+void
+perform::trim_trigger_undo ()
+{
+    std::size_t limit = std::size_t(rc().undo_memory_limit()) * 1024;
+    while (limit > 0 && m_undo_bytes > limit && m_undo_vect.size() > 1)
+    {
+        const TriggerRecord & rec = m_undo_vect.front();
+        for (std::size_t c = 0; c < rec.size(); ++c)
+            m_undo_bytes -= change_bytes(rec[c].m_triggers);
+
+        m_undo_vect.pop_front();
+    }
+}
+
+/**
+ *  Starts a new undo step for the trigger changes of a song-editor gesture.
  *
- * \todo
- *      Look at seq32/src/perform.cpp and the perform ::
- *      push_trigger_undo(track) function, which has a track parameter that
- *      has a -1 values the supports all tracks.  It requires two new vectors
- *      (one for undo, one for redo), two new flags (likewise).  We've put
- *      this code in place, no longer macroed out, now permanent.
+ *  This used to push a copy of the whole trigger list of every track (or
+ *  of one track) onto that track's own undo stack, for every gesture.
+ *  Now the changes are recorded in a journal in the perform object.  Every
+ *  track keeps a saved copy of its triggers; when the next step is pushed,
+ *  or an undo or redo is done, only the tracks that differ from their saved
+ *  copies are recorded.  A step in which nothing changed is reused by the
+ *  next push.
+ *
+ * \param track
+ *      A parameter (found in the stazed seq32 code) that named the one track
+ *      to be saved, or SEQ64_ALL_TRACKS (-1, the default).  The journal finds
+ *      the changed tracks itself, so this parameter is no longer needed.
+ */
+
+void
+perform::push_trigger_undo (int /* track */)
+{
+    collect_trigger_changes();
+    if (! m_undo_record_open || ! m_undo_vect.back().empty())
+    {
+        m_undo_vect.push_back(TriggerRecord());
+        m_undo_record_open = true;
+    }
+    trim_trigger_undo();
+    set_have_undo(true);                                /* stazed   */
+}
+
+/**
+ *  Undoes the newest recorded trigger step, putting back the triggers that
+ *  the changed tracks had before it, and recording their current triggers
+ *  as a redo step.  Steps in which nothing changed are skipped.
  */
 
 void
 perform::pop_trigger_undo ()
 {
+    collect_trigger_changes();
+    m_undo_record_open = false;
+    while (! m_undo_vect.empty() && m_undo_vect.back().empty())
+        m_undo_vect.pop_back();
+
     if (! m_undo_vect.empty())
     {
-        int track = m_undo_vect.back();
-        m_undo_vect.pop_back();
-        m_redo_vect.push_back(track);
-        if (track == SEQ64_ALL_TRACKS)
+        TriggerRecord & rec = m_undo_vect.back();
+        TriggerRecord redo(rec.size());
+        for (std::size_t c = 0; c < rec.size(); ++c)
         {
-            for (int s = 0; s < m_sequence_max; ++s)    /* m_sequence_high  */
+            int track = rec[c].m_track;
+            m_undo_bytes -= change_bytes(rec[c].m_triggers);
+            redo[c].m_track = track;
+            if (is_active(track))
             {
-                if (is_active(s))
-                    m_seqs[s]->pop_trigger_undo();
+                m_seqs[track]->restore_triggers
+                (
+                    rec[c].m_triggers, redo[c].m_triggers
+                );
             }
         }
-        else
-        {
-            if (is_active(track))
-                m_seqs[track]->pop_trigger_undo();
-        }
-        set_have_undo(! m_undo_vect.empty());
-        set_have_redo(! m_redo_vect.empty());
+        m_undo_vect.pop_back();
+        m_redo_vect.push_back(TriggerRecord());
+        m_redo_vect.back().swap(redo);
     }
+    set_have_undo(! m_undo_vect.empty());
+    set_have_redo(! m_redo_vect.empty());
 }
 
 /**
- *  For every active sequence, call that sequence's pop_trigger_redo()
- *  function.
+ *  Redoes the newest undone trigger step, recording the triggers it
+ *  replaces as an undo step.
  */
 
 void
 perform::pop_trigger_redo ()
 {
+    collect_trigger_changes();
+    m_undo_record_open = false;
     if (! m_redo_vect.empty())
     {
-        int track = m_redo_vect.back();
-        m_redo_vect.pop_back();
-        m_undo_vect.push_back(track);
-        if (track == SEQ64_ALL_TRACKS)
+        TriggerRecord & rec = m_redo_vect.back();
+        TriggerRecord undo(rec.size());
+        for (std::size_t c = 0; c < rec.size(); ++c)
         {
-            for (int s = 0; s < m_sequence_max; ++s)    /* m_sequence_high */
+            int track = rec[c].m_track;
+            undo[c].m_track = track;
+            if (is_active(track))
             {
-                if (is_active(s))                   /* oops, was "track"!   */
-                    m_seqs[s]->pop_trigger_redo();
+                m_seqs[track]->restore_triggers
+                (
+                    rec[c].m_triggers, undo[c].m_triggers
+                );
             }
+
+            m_undo_bytes += change_bytes(undo[c].m_triggers);
         }
-        else
-        {
-            if (is_active(track))
-                m_seqs[track]->pop_trigger_redo();
-        }
-        set_have_undo(! m_undo_vect.empty());
-        set_have_redo(! m_redo_vect.empty());
+        m_redo_vect.pop_back();
+        m_undo_vect.push_back(TriggerRecord());
+        m_undo_vect.back().swap(undo);
+        trim_trigger_undo();
     }
+    set_have_undo(! m_undo_vect.empty());
+    set_have_redo(! m_redo_vect.empty());
 }
 
 /**
@@ -2473,11 +2769,9 @@ perform::copy_triggers ()
     if (m_left_tick < m_right_tick)
     {
         midipulse distance = m_right_tick - m_left_tick;
-        for (int s = 0; s < m_sequence_max; ++s)    /* m_sequence_high */
-        {
-            if (is_active(s))
-                m_seqs[s]->copy_triggers(m_left_tick, distance);
-        }
+        active_list active(*this);
+        for (int i = 0; i < active.count(); ++i)
+            active[i]->copy_triggers(m_left_tick, distance);
     }
 }
 
@@ -2828,11 +3122,12 @@ perform::inner_stop (bool midiclock)
 void
 perform::off_sequences ()
 {
-    for (int s = 0; s < m_sequence_high; ++s)       /* modest speed-up */
-    {
-        if (is_active(s))
-            m_seqs[s]->set_playing(false);
-    }
+    if (not_nullptr(m_master_bus))
+        m_master_bus->cancel_scheduled();
+
+    active_list active(*this);
+    for (int i = 0; i < active.count(); ++i)
+        active[i]->set_playing(false);
 }
 
 /**
@@ -2882,11 +3177,12 @@ perform::unqueue_sequences (int current_seq)
 void
 perform::all_notes_off ()
 {
-    for (int s = 0; s < m_sequence_high; ++s)   /* a modest speed-up    */
-    {
-        if (is_active(s))
-            m_seqs[s]->off_playing_notes();
-    }
+    if (not_nullptr(m_master_bus))
+        m_master_bus->cancel_scheduled();
+
+    active_list active(*this);
+    for (int i = 0; i < active.count(); ++i)
+        active[i]->off_playing_notes();
     if (not_nullptr(m_master_bus))
         m_master_bus->flush();                  /* flush the MIDI buss  */
 }
@@ -2910,11 +3206,12 @@ void
 perform::reset_sequences (bool pause)
 {
     void (sequence::* f) (bool) = pause ? &sequence::pause : &sequence::stop ;
-    for (int s = 0; s < m_sequence_max; ++s)            /* m_sequence_high  */
-    {
-        if (is_active(s))
-            (m_seqs[s]->*f)(m_playback_mode);           /* (new parameter)  */
-    }
+    if (not_nullptr(m_master_bus))
+        m_master_bus->cancel_scheduled();               /* stop or pause    */
+
+    active_list active(*this);
+    for (int i = 0; i < active.count(); ++i)
+        (active[i]->*f)(m_playback_mode);
 
 #if 0
     if (pause)
@@ -2935,7 +3232,8 @@ perform::reset_sequences (bool pause)
     }
 #endif
 
-    m_master_bus->flush();                           /* flush the MIDI buss  */
+    if (not_nullptr(m_master_bus))
+        m_master_bus->flush();                       /* flush the MIDI buss  */
 }
 
 /**
@@ -3007,18 +3305,64 @@ midipulse
 perform::get_max_trigger ()
 {
     midipulse result = 0;
-    for (int s = 0; s < m_sequence_high; ++s)           /* modest speed-up */
+    active_list active(*this);
+    for (int i = 0; i < active.count(); ++i)
     {
-        if (is_active(s))
-        {
-            midipulse t = m_seqs[s]->get_max_trigger();
-            if (t > result)
-                result = t;
-        }
+        midipulse t = active[i]->get_max_trigger();
+        if (t > result)
+            result = t;
     }
     return result;
 }
 
+#ifndef PLATFORM_WINDOWS
+
+/**
+ *  Advances a time value by the given number of microseconds.  Used for the
+ *  absolute deadlines of output_func().
+ *
+ * \param ts
+ *      The time value to be advanced.
+ *
+ * \param us
+ *      The number of microseconds to add.  Must not be negative.
+ */
+
+static void
+timespec_add_us (struct timespec & ts, long us)
+{
+    ts.tv_sec += us / 1000000;
+    ts.tv_nsec += (us % 1000000) * 1000;
+    if (ts.tv_nsec >= 1000000000)
+    {
+        ts.tv_nsec -= 1000000000;
+        ++ts.tv_sec;
+    }
+}
+
+/**
+ *  Calculates the difference between two time values.
+ *
+ * \param later
+ *      The time value to subtract from.
+ *
+ * \param earlier
+ *      The time value to subtract.
+ *
+ * \return
+ *      Returns later - earlier in microseconds, which is negative if
+ *      "earlier" is actually the later of the two times.
+ */
+
+static long
+timespec_diff_us (const struct timespec & later, const struct timespec & earlier)
+{
+    return (later.tv_sec - earlier.tv_sec) * 1000000 +
+        (later.tv_nsec - earlier.tv_nsec) / 1000;
+}
+
+#endif  // ! PLATFORM_WINDOWS
+
 /**
  *  Set up the performance, set the process to realtime privileges, and then
  *  start the output function.
@@ -3115,6 +3459,7 @@ perform::output_func ()
         struct timespec stats_loop_finish;
 #endif
         struct timespec delta;              // difference between last & current
+        struct timespec deadline;           // absolute time of next wakeup
 #endif
 
         jack_scratchpad pad;
@@ -3204,7 +3549,7 @@ perform::output_func ()
         if (rc().stats())
             stats_last_clock_us = last * 1000;
 #else
-        clock_gettime(CLOCK_REALTIME, &last);   // get start time position
+        clock_gettime(CLOCK_MONOTONIC, &last);  // get start time position
         if (rc().stats())
             stats_last_clock_us = (last.tv_sec*1000000) + (last.tv_nsec/1000);
 #endif
@@ -3214,11 +3559,18 @@ perform::output_func ()
 #ifdef PLATFORM_WINDOWS
         last = timeGetTime();                   // get start time position
 #else
-        clock_gettime(CLOCK_REALTIME, &last);   // get start time position
+        clock_gettime(CLOCK_MONOTONIC, &last);  // get start time position
 #endif
 
 #endif  // SEQ64_STATISTICS_SUPPORT
 
+#ifndef PLATFORM_WINDOWS
+        deadline = last;                        // first wakeup is "now"
+#endif
+        m_output_period_us = c_thread_trigger_width_us;
+        m_output_late_count = 0;
+        m_output_worst_late_us = 0;
+
         while (m_running)
         {
             /**
@@ -3235,7 +3587,7 @@ perform::output_func ()
 #ifdef PLATFORM_WINDOWS
                 stats_loop_start = timeGetTime();
 #else
-                clock_gettime(CLOCK_REALTIME, &stats_loop_start);
+                clock_gettime(CLOCK_MONOTONIC, &stats_loop_start);
 #endif
             }
 #endif  // SEQ64_STATISTICS_SUPPORT
@@ -3249,7 +3601,7 @@ perform::output_func ()
             delta = current - last;
             long delta_us = delta * 1000;
 #else
-            clock_gettime(CLOCK_REALTIME, &current);
+            clock_gettime(CLOCK_MONOTONIC, &current);
             delta.tv_sec  = current.tv_sec - last.tv_sec;       // delta!
             delta.tv_nsec = current.tv_nsec - last.tv_nsec;     // delta!
             long delta_us = (delta.tv_sec * 1000000) + (delta.tv_nsec / 1000);
@@ -3458,35 +3810,23 @@ perform::output_func ()
             }
 
             /**
-             *  Figure out how much time we need to sleep, and do it.
+             *  Figure out how much time we need to sleep, and do it.  On
+             *  Windows, we sleep the rest of the trigger width.  Elsewhere,
+             *  the wakeups are kept on a grid of absolute CLOCK_MONOTONIC
+             *  deadlines, one period apart, so that the time spent playing
+             *  and the sleep overshoot do not add up over time, and the
+             *  setting of the system clock (e.g. by NTP) has no effect.
              */
 
             last = current;
 
-#ifdef PLATFORM_WINDOWS
-            current = timeGetTime();
-            delta = current - last;
-            long elapsed_us = delta * 1000;
-#else
-            clock_gettime(CLOCK_REALTIME, &current);
-            delta.tv_sec  = current.tv_sec  - last.tv_sec;
-            delta.tv_nsec = current.tv_nsec - last.tv_nsec;
-            long elapsed_us = (delta.tv_sec * 1000000) + (delta.tv_nsec / 1000);
-#endif
-
-            /**
-             * Now we want to trigger every c_thread_trigger_width_us, and it
-             * took us delta_us to play().  Also known as the "sleeping_us".
-             */
-
-            delta_us = c_thread_trigger_width_us - elapsed_us;
-
             /**
              * Check MIDI clock adjustment.  Note that we replaced
              * "60000000.0f / m_ppqn / bpm" with a call to a function.  We
              * also removed the "f" specification from the constants.
              */
 
+            long period_us = c_thread_trigger_width_us;
             double dct = double_ticks_from_ppqn(m_ppqn);
             double next_total_tick = pad.js_total_tick + dct;
             double next_clock_delta = next_total_tick - pad.js_total_tick - 1;
@@ -3494,21 +3834,103 @@ perform::output_func ()
                 next_clock_delta * pulse_length_us(bpm, m_ppqn);
 
             if (next_clock_delta_us < (c_thread_trigger_width_us * 2.0))
-                delta_us = long(next_clock_delta_us);
+                period_us = long(next_clock_delta_us);
 
+#ifdef PLATFORM_WINDOWS
+            current = timeGetTime();
+            delta = current - last;
+            long elapsed_us = delta * 1000;
+
+            /**
+             * Now we want to trigger every c_thread_trigger_width_us, and it
+             * took us delta_us to play().  Also known as the "sleeping_us".
+             */
+
+            delta_us = period_us - elapsed_us;
             if (delta_us > 0)
             {
-#ifdef PLATFORM_WINDOWS
                 delta = delta_us / 1000;
                 Sleep(delta);
+            }
 #else
-                delta.tv_sec = delta_us / 1000000;
-                delta.tv_nsec = (delta_us % 1000000) * 1000;
-                nanosleep(&delta, NULL);    /* nanosleep() is Linux */
-#endif
+
+            /*
+             * If nothing is due for a while, sleep until just before it is,
+             * instead of waking up every period.  The wake flag is cleared
+             * before looking at the patterns, so that a change made after
+             * the look is caught by the sleep below.
+             */
+
+            m_output_wake = false;
+            long idle_us = output_idle_us(pad, bpm);
+            bool idle = idle_us > period_us;
+            if (idle)
+                period_us = idle_us;
+
+            if (period_us > 0)
+            {
+                m_output_period_us = period_us;
+                timespec_add_us(deadline, period_us);
+            }
+
+            struct timespec now;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            delta_us = timespec_diff_us(deadline, now);     /* sleep time   */
+            if (delta_us > 0)
+            {
+                if (idle)
+                {
+                    m_wake_var.lock();
+                    m_output_sleeping = true;
+                    bool woken = m_output_wake;
+                    while (! woken && m_wake_var.wait_until(deadline))
+                        woken = m_output_wake;      /* spurious wakeup?     */
+
+                    m_output_sleeping = false;
+                    m_wake_var.unlock();
+                    clock_gettime(CLOCK_MONOTONIC, &now);
+                    if (woken)
+                        deadline = now;             /* start a new grid     */
+                }
+                else
+                {
+                    while
+                    (
+                        clock_nanosleep
+                        (
+                            CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL
+                        ) == EINTR
+                    )
+                    {
+                        /* restart the sleep if interrupted by a signal */
+                    }
+                    clock_gettime(CLOCK_MONOTONIC, &now);
+                }
             }
+
+            long late_us = timespec_diff_us(now, deadline);
+            if (late_us > m_output_worst_late_us)
+                m_output_worst_late_us = late_us;
+
+            if (late_us > SEQ64_LATE_WAKEUP_US)
+            {
+                ++m_output_late_count;
+
+                /*
+                 * If we fell more than a period behind (e.g. the system was
+                 * suspended or badly loaded), do not try to catch up with a
+                 * burst of short loops; start a new grid of deadlines now.
+                 * The delta-tick calculation above still accounts for all
+                 * the time that passed.
+                 */
+
+                if (late_us > m_output_period_us)
+                    deadline = now;
+            }
+#endif
+
 #ifdef SEQ64_STATISTICS_SUPPORT
-            else
+            if (delta_us <= 0)
             {
                 if (rc().stats())
                 {
@@ -3525,7 +3947,7 @@ perform::output_func ()
                 delta = stats_loop_finish - stats_loop_start;
                 long delta_us = delta * 1000;
 #else
-                clock_gettime(CLOCK_REALTIME, &stats_loop_finish);
+                clock_gettime(CLOCK_MONOTONIC, &stats_loop_finish);
                 delta.tv_sec  = stats_loop_finish.tv_sec-stats_loop_start.tv_sec;
                 delta.tv_nsec = stats_loop_finish.tv_nsec-stats_loop_start.tv_nsec;
                 long delta_us = (delta.tv_sec*1000000) + (delta.tv_nsec/1000);
@@ -3581,6 +4003,11 @@ perform::output_func ()
             {
                 printf("[%3d][%8ld]\n", i * 300, stats_clock[i]);
             }
+            printf
+            (
+                "\n\n-- wakeups --\nperiod [%ld us] late [%ld] worst [%ld us]\n",
+                m_output_period_us, m_output_late_count, m_output_worst_late_us
+            );
         }
 #endif  // SEQ64_STATISTICS_SUPPORT
 
@@ -3636,6 +4063,316 @@ perform::output_func ()
     pthread_exit(0);
 }
 
+/**
+ *  The engine_callback given to mastermidibase::set_engine().  Called by
+ *  the JACK process callback, once per cycle, in the JACK thread.
+ *
+ * \param arg
+ *      Provides the perform object.
+ *
+ * \param nframes
+ *      The number of frames in the JACK cycle.
+ *
+ * \param rate
+ *      The JACK sample rate.
+ */
+
+void
+perform::engine_func (void * arg, int nframes, int rate)
+{
+    perform * p = reinterpret_cast<perform *>(arg);
+    if (not_nullptr(p) && nframes > 0 && rate > 0)
+        p->engine_cycle(nframes, rate);
+}
+
+/**
+ *  Wakes up the output thread if it is sleeping until its next event (see
+ *  output_idle_us()), because something that might make that event sooner
+ *  has changed:  the events or triggers of a pattern, a queue or mute
+ *  change, the tempo, the loop markers, or the running status.  The flag is
+ *  set before the sleeping flag is checked, and the output thread does the
+ *  reverse, so that the wakeup cannot be lost.  The lock is taken only if
+ *  the thread is actually asleep, so the output thread (and the JACK process
+ *  engine) can call this function freely.
+ *
+ * \threadsafe
+ */
+
+void
+perform::wake_output ()
+{
+    m_output_wake = true;
+    if (m_output_sleeping)
+    {
+        m_wake_var.lock();
+        m_wake_var.signal();
+        m_wake_var.unlock();
+    }
+}
+
+/**
+ *  Works out how long the output thread can sleep before it has something
+ *  to do:  the earliest event, queue toggle, or trigger edge of all of the
+ *  active patterns (see sequence::next_event_tick()), the end of the song
+ *  loop, and the next MIDI clock, if any buss sends the clock.  With the
+ *  output look-ahead, pattern events are due that much earlier.
+ *
+ *  The sleep is limited to c_redraw_ms, so that the progress bars of the
+ *  user-interface still move smoothly.  There is no idle sleep if the
+ *  position is driven from outside, by JACK transport or incoming MIDI
+ *  clock.
+ *
+ * \param pad
+ *      Provides the current position of the output thread.
+ *
+ * \param bpm
+ *      Provides the current tempo.
+ *
+ * \return
+ *      Returns the time to sleep, in microseconds.  If it is shorter than
+ *      the normal period of the output thread, the caller uses the normal
+ *      period.
+ */
+
+long
+perform::output_idle_us (const jack_scratchpad & pad, midibpm bpm)
+{
+    long result = 0;
+    if (m_usemidiclock || is_jack_running() || ! pad.js_dumping)
+        return result;
+
+    /*
+     * With the output look-ahead, the patterns have already been played up
+     * to "ahead" ticks past the current tick, as in frame_start().
+     */
+
+    midipulse ahead = midipulse
+    (
+        m_master_bus->lookahead() * bpm * m_ppqn / 60000.0
+    );
+    midipulse now = midipulse(pad.js_current_tick);
+    midipulse tick = now + ahead + 1;                   /* not played yet   */
+    midipulse next = SEQ64_NULL_MIDIPULSE;
+    active_list active(*this);
+    for (int i = 0; i < active.count(); ++i)
+    {
+        next = earlier_pulse
+        (
+            next, active[i]->next_event_tick(tick, m_playback_mode)
+        );
+    }
+    if (next != SEQ64_NULL_MIDIPULSE)
+        next -= ahead;                                  /* when to play it  */
+
+    bool perfloop = m_looping &&
+        (m_playback_mode || start_from_perfedit() || song_start_mode());
+
+    if (perfloop)
+        next = earlier_pulse(next, get_right_tick());
+
+    if (m_master_bus->clocking())
+    {
+        midipulse ct = clock_ticks_from_ppqn(m_ppqn);
+        if (ct > 0)
+        {
+            midipulse clk = midipulse(pad.js_clock_tick);
+            midipulse nextclock = (clk / ct + 1) * ct;
+            next = earlier_pulse(next, now + nextclock - clk);
+        }
+    }
+
+    result = c_redraw_ms * 1000;
+    if (next != SEQ64_NULL_MIDIPULSE)
+    {
+        double us = (double(next) - pad.js_current_tick) *
+            pulse_length_us(bpm, m_ppqn);
+
+        if (us < double(result))
+            result = long(us);
+    }
+    return result;
+}
+
+/**
+ *  The JACK process engine, which replaces output_func() when the
+ *  "[jack-engine]" option is set and native JACK MIDI is used.  Instead of
+ *  sleeping and measuring the time that has passed, each JACK cycle
+ *  advances the performance by exactly its own number of frames, and plays
+ *  the patterns for that window of ticks.  The events go into the JACK port
+ *  buffers at their own frames (see mastermidibase::engine_cycle()), so
+ *  there is no extra period of latency, and no drift between the JACK clock
+ *  and ours.  So do the MIDI clock (see mastermidibase::engine_clock()) and
+ *  the Note Offs of a stop or of the song loop.
+ *
+ *  This function runs in the JACK thread, which must not block, and
+ *  nothing is allocated.  The patterns are played with try-locks (see
+ *  engine_play()), and moved with engine_seek().  Starting and stopping
+ *  the busses, and a change of tempo (see engine_tempo()), use try-locks
+ *  too; if the lock is busy, they are tried again in the next cycle.
+ *  set_tick() and set_jack_tick() only store a value.
+ *
+ * \param nframes
+ *      The number of frames in the JACK cycle.
+ *
+ * \param rate
+ *      The JACK sample rate.
+ */
+
+void
+perform::engine_cycle (int nframes, int rate)
+{
+    engine_tempo();
+    if (! is_running())
+    {
+        if (m_engine_rolling && m_master_bus->try_stop())   /* output_func() */
+        {
+            m_engine_rolling = false;
+            if (! m_usemidiclock)
+            {
+                if (m_playback_mode)
+                    set_tick(m_left_tick);      /* song mode default        */
+                else if (! m_dont_reset_ticks)
+                    set_tick(0);                /* live mode default        */
+            }
+        }
+        return;
+    }
+    if (! m_engine_rolling)                     /* first cycle of playback  */
+    {
+        midipulse tick = 0;
+        bool seek = false;
+        if (m_dont_reset_ticks)
+            tick = get_jack_tick();             /* resume after a pause     */
+        else if (m_playback_mode)
+        {
+            tick = m_starting_tick;
+            seek = true;
+        }
+        if (! m_master_bus->try_init_clock(tick))
+            return;                             /* start in the next cycle  */
+
+        if (seek)
+            engine_seek(tick, false);
+
+        m_dont_reset_ticks = false;
+        m_engine_tick = m_engine_clock = double(tick);
+        m_engine_rolling = true;
+    }
+
+    double tpf = m_master_bus->get_beats_per_minute() * m_ppqn / (60.0 * rate);
+    double start = m_engine_tick;
+    double finish = start + nframes * tpf;      /* first tick of next cycle */
+    m_master_bus->engine_window(start, tpf);
+
+    bool perfloop = m_looping &&
+        (m_playback_mode || start_from_perfedit() || song_start_mode());
+
+    if (perfloop)
+    {
+        midipulse rtick = get_right_tick();
+        if (finish >= double(rtick))
+        {
+            /*
+             * Play to the right marker, then go back to the left marker.
+             * The Note Offs of the stop go at the frame of the right marker,
+             * and the rest of the cycle plays from the left marker, so its
+             * frames start there too.
+             */
+
+            midipulse ltick = get_left_tick();
+            engine_play(rtick - 1);
+            m_master_bus->engine_now(rtick);
+            engine_seek(ltick, true);
+            start += double(ltick - rtick);
+            finish += double(ltick - rtick);
+            m_master_bus->engine_window(start, tpf);
+        }
+    }
+
+    midipulse last = midipulse(finish);         /* last tick of this cycle  */
+    if (double(last) >= finish)
+        --last;
+
+    engine_play(last);
+    m_engine_tick = finish;
+    set_jack_tick(last);                        /* for pausing              */
+
+    double cfinish = m_engine_clock + nframes * tpf;
+    midipulse clast = midipulse(cfinish);       /* last clock tick of cycle */
+    if (double(clast) >= cfinish)
+        --clast;
+
+    m_master_bus->engine_clock(m_engine_clock, clast);
+    m_engine_clock = cfinish;
+}
+
+/**
+ *  Like play(), for the JACK process engine.  Each pattern is played with
+ *  sequence::play_queue() in its real-time form, which skips a pattern that
+ *  is locked by an editor for this cycle; it catches up in the next cycle.
+ *  There is no flush, since the events are written to the JACK buffers
+ *  after the engine function returns.
+ *
+ * \param tick
+ *      Provides the last tick to play in this cycle.  Also copied to
+ *      m_tick, for the progress bars.
+ */
+
+void
+perform::engine_play (midipulse tick)
+{
+    m_tick = tick;
+    active_list active(*this);
+    for (int i = 0; i < active.count(); ++i)
+        active[i]->play_queue(tick, m_playback_mode, true);
+}
+
+/**
+ *  Like reset_sequences() followed by set_orig_ticks(), or just the latter,
+ *  for the JACK process engine.  See sequence::engine_seek(), which puts
+ *  off the change for a pattern that an editor has locked.
+ *
+ * \param tick
+ *      Provides the new position of the patterns.
+ *
+ * \param stop
+ *      If true, the patterns are stopped first, turning off their notes.
+ */
+
+void
+perform::engine_seek (midipulse tick, bool stop)
+{
+    active_list active(*this);
+    for (int i = 0; i < active.count(); ++i)
+        active[i]->engine_seek(tick, stop, m_playback_mode);
+}
+
+/**
+ *  Sets the tempo noted by set_beats_per_minute() in an earlier engine
+ *  cycle, if the lock of the master buss can be had now.  Called at the
+ *  start of each cycle of the JACK process engine.
+ *
+ *  The JACK transport tempo (jack_assistant::set_beats_per_minute()) is
+ *  not set here.  It queries and repositions the transport, which has no
+ *  place in the process cycle, and the engine is never used along with
+ *  JACK transport (see launch()), so there is no transport to tell.
+ */
+
+void
+perform::engine_tempo ()
+{
+    midibpm bpm = m_engine_bpm;
+    if (bpm > 0.0 && m_master_bus->try_beats_per_minute(bpm))
+    {
+        if (bpm != m_bpm)
+        {
+            m_us_per_quarter_note = tempo_us_from_bpm(bpm);
+            m_bpm = bpm;
+        }
+        m_engine_bpm = 0.0;
+    }
+}
+
 /**
  *  Set up the performance, and set the process to realtime privileges.
  *
@@ -4158,7 +4895,19 @@ perform::input_func ()
 
                         if (m_master_bus->is_dumping())
                         {
-                            ev.set_timestamp(m_tick);
+                            /*
+                             * Send it through first, so that live playing
+                             * does not wait for recording.  Then place the
+                             * event at the tick at which it arrived, not
+                             * the tick at which it was read.
+                             */
+
+                            m_master_bus->thru(ev);
+
+                            midipulse tick = m_tick -
+                                m_master_bus->input_age_ticks();
+
+                            ev.set_timestamp(tick > 0 ? tick : 0);
 #ifdef USE_STAZED_MIDI_DUMP
                             m_master_bus->dump_midi_input(ev);
 #else
@@ -5217,11 +5966,9 @@ perform::playback_action (playback_action_t p, bool songmode)
 void
 perform::print_triggers () const
 {
-    for (int s = 0; s < m_sequence_high; ++s)
-    {
-        if (is_active(s))
-            m_seqs[s]->print_triggers();
-    }
+    active_list active(*this);
+    for (int i = 0; i < active.count(); ++i)
+        active[i]->print_triggers();
 }
 
 /**
@@ -5244,11 +5991,9 @@ perform::print_busses () const
 void
 perform::apply_song_transpose ()
 {
-    for (int s = 0; s < m_sequence_high; ++s)       /* modest speed-up */
-    {
-        if (is_active(s))
-            get_sequence(s)->apply_song_transpose();
-    }
+    active_list active(*this);
+    for (int i = 0; i < active.count(); ++i)
+        active[i]->apply_song_transpose();
 }
 
 #endif      // SEQ64_STAZED_TRANSPOSE
@@ -111,7 +111,12 @@ rc_settings::rc_settings ()
     m_user_filename_alt         (),
     m_application_name          (SEQ64_APP_NAME),
     m_app_client_name           (SEQ64_CLIENT_NAME),
-    m_tempo_track_number        (0)
+    m_tempo_track_number        (0),
+    m_output_lookahead          (0),
+    m_jack_engine               (false),
+    m_undo_memory_limit         (SEQ64_UNDO_MEMORY_DEFAULT),
+    m_sysex_chunk               (SEQ64_SYSEX_CHUNK_DEFAULT),
+    m_sysex_rate                (SEQ64_SYSEX_RATE_DEFAULT)
 {
     // Empty body
 }
@@ -156,7 +161,12 @@ rc_settings::rc_settings (const rc_settings & rhs)
     m_user_filename_alt         (rhs.m_user_filename_alt),
     m_application_name          (rhs.m_application_name),
     m_app_client_name           (rhs.m_app_client_name),
-    m_tempo_track_number        (rhs.m_tempo_track_number)
+    m_tempo_track_number        (rhs.m_tempo_track_number),
+    m_output_lookahead          (rhs.m_output_lookahead),
+    m_jack_engine               (rhs.m_jack_engine),
+    m_undo_memory_limit         (rhs.m_undo_memory_limit),
+    m_sysex_chunk               (rhs.m_sysex_chunk),
+    m_sysex_rate                (rhs.m_sysex_rate)
 {
     // Empty body
 }
@@ -211,6 +221,11 @@ rc_settings::operator = (const rc_settings & rhs)
 
         m_app_client_name           = rhs.m_app_client_name;
         m_tempo_track_number        = rhs.m_tempo_track_number;
+        m_output_lookahead          = rhs.m_output_lookahead;
+        m_jack_engine               = rhs.m_jack_engine;
+        m_undo_memory_limit         = rhs.m_undo_memory_limit;
+        m_sysex_chunk               = rhs.m_sysex_chunk;
+        m_sysex_rate                = rhs.m_sysex_rate;
     }
     return *this;
 }
@@ -266,6 +281,11 @@ rc_settings::set_defaults ()
 
     m_app_client_name           = SEQ64_CLIENT_NAME;
     m_tempo_track_number        = 0;
+    m_output_lookahead          = 0;
+    m_jack_engine               = false;
+    m_undo_memory_limit         = SEQ64_UNDO_MEMORY_DEFAULT;
+    m_sysex_chunk               = SEQ64_SYSEX_CHUNK_DEFAULT;
+    m_sysex_rate                = SEQ64_SYSEX_RATE_DEFAULT;
 }
 
 /**
@@ -395,6 +415,82 @@ rc_settings::tempo_track_number (int track)
     m_tempo_track_number = track;
 }
 
+/**
+ *  \setter m_output_lookahead
+ *
+ * \param ms
+ *      The look-ahead in milliseconds.  Clamped to the range 0 to
+ *      SEQ64_OUTPUT_LOOKAHEAD_MAX.  Zero disables the scheduled output mode.
+ */
+
+void
+rc_settings::output_lookahead (int ms)
+{
+    if (ms < 0)
+        ms = 0;
+    else if (ms > SEQ64_OUTPUT_LOOKAHEAD_MAX)
+        ms = SEQ64_OUTPUT_LOOKAHEAD_MAX;
+
+    m_output_lookahead = ms;
+}
+
+/**
+ *  \setter m_undo_memory_limit
+ *
+ * \param kb
+ *      The limit in kilobytes.  Clamped to the range 0 to
+ *      SEQ64_UNDO_MEMORY_MAX.  Zero means no limit.
+ */
+
+void
+rc_settings::undo_memory_limit (int kb)
+{
+    if (kb < 0)
+        kb = 0;
+    else if (kb > SEQ64_UNDO_MEMORY_MAX)
+        kb = SEQ64_UNDO_MEMORY_MAX;
+
+    m_undo_memory_limit = kb;
+}
+
+/**
+ *  \setter m_sysex_chunk
+ *
+ * \param bytes
+ *      The size of the pieces.  Clamped to the range SEQ64_SYSEX_CHUNK_MIN to
+ *      SEQ64_SYSEX_CHUNK_MAX.
+ */
+
+void
+rc_settings::sysex_chunk (int bytes)
+{
+    if (bytes < SEQ64_SYSEX_CHUNK_MIN)
+        bytes = SEQ64_SYSEX_CHUNK_MIN;
+    else if (bytes > SEQ64_SYSEX_CHUNK_MAX)
+        bytes = SEQ64_SYSEX_CHUNK_MAX;
+
+    m_sysex_chunk = bytes;
+}
+
+/**
+ *  \setter m_sysex_rate
+ *
+ * \param bytespersec
+ *      The pacing rate.  Clamped to the range 0 to SEQ64_SYSEX_RATE_MAX.
+ *      Zero disables pacing.
+ */
+
+void
+rc_settings::sysex_rate (int bytespersec)
+{
+    if (bytespersec < 0)
+        bytespersec = 0;
+    else if (bytespersec > SEQ64_SYSEX_RATE_MAX)
+        bytespersec = SEQ64_SYSEX_RATE_MAX;
+
+    m_sysex_rate = bytespersec;
+}
+
 /**
  * \setter m_interaction_method
  *
@@ -42,6 +42,7 @@
  */
 
 #include <string.h>                     /* C::memset()                      */
+#include <algorithm>                    /* std::lower_bound()               */
 
 #include "calculations.hpp"
 #include "mastermidibus.hpp"
@@ -77,14 +78,34 @@ event_list sequence::m_events_clipboard;
 sequence::sequence (int ppqn)
  :
     m_parent                    (nullptr),      // set when sequence installed
-    m_events                    (),
+    m_event_pool                (std::make_shared<node_pool>()),
+    m_events                    (m_event_pool),
     m_triggers                  (*this),
     m_events_undo_hold          (),             // stazed
     m_have_undo                 (false),        // stazed
     m_have_redo                 (false),        // stazed
     m_events_undo               (),
     m_events_redo               (),
-    m_iterator_draw             (m_events.begin()),
+    m_iterator_draw             (m_events.cbegin()),
+    m_snapshot                  (),
+    m_edit_depth                (0),
+    m_snapshot_generation       (0),
+    m_snapshot_stale            (false),
+    m_transaction_depth         (0),
+    m_transaction_thread        (),
+    m_transaction_undo          (false),
+    m_transaction_relink        (false),
+    m_transaction_dirty         (false),
+    m_transaction_modified      (false),
+    m_play_index                (0),
+    m_play_offset_base          (0),
+    m_play_next_tick            (0),
+    m_play_serial               (0),
+    m_play_cursor_valid         (false),
+    m_off_tick                  (SEQ64_NULL_MIDIPULSE),
+    m_engine_seek_tick          (SEQ64_NULL_MIDIPULSE),
+    m_engine_seek_stop          (false),
+    m_engine_seek_song          (false),
     m_channel_match             (false),        // a future stazed feature
     m_midi_channel              (0),
     m_bus                       (0),
@@ -133,6 +154,7 @@ sequence::sequence (int ppqn)
     m_musical_scale             (int(c_scale_off)),
     m_background_sequence       (SEQ64_SEQUENCE_LIMIT),
     m_mutex                     (),
+    m_play_mutex                (),
     m_note_off_margin           (2)
 {
     m_ppqn = choose_ppqn(ppqn);
@@ -140,6 +162,8 @@ sequence::sequence (int ppqn)
     m_snap_tick = m_ppqn / 4;
     m_triggers.set_ppqn(m_ppqn);
     m_triggers.set_length(m_length);
+    m_events_undo.limit(std::size_t(rc().undo_memory_limit()) * 1024);
+    m_events_redo.limit(std::size_t(rc().undo_memory_limit()) * 1024);
     for (int i = 0; i < c_midi_notes; ++i)      /* no notes are playing now */
         m_playing_notes[i] = 0;
 }
@@ -150,7 +174,8 @@ sequence::sequence (int ppqn)
 
 sequence::~sequence ()
 {
-    // Empty body
+    if (m_thru && not_nullptr(m_masterbus))
+        m_masterbus->clear_thru_route(this);
 }
 
 /**
@@ -160,13 +185,16 @@ sequence::~sequence ()
  *  to keep a count/stack of modifications over all sequences in the
  *  performance.  Probably not practical, in general.  We will probably keep
  *  track of the modification of the buss (port) and channel numbers, as per
- *  GitHub Issue #47..
+ *  GitHub Issue #47..  Inside a transaction, the performance is told only
+ *  once, by commit_edit().
  */
 
 void
 sequence::modify ()
 {
-    if (not_nullptr(m_parent))
+    if (in_transaction())
+        m_transaction_modified = true;
+    else if (not_nullptr(m_parent))
         m_parent->modify();
 }
 
@@ -188,7 +216,8 @@ sequence::partial_assign (const sequence & rhs)
 {
     if (this != &rhs)
     {
-        automutex locker(m_mutex);
+        editlock locker(*this);
+        automutex playlocker(m_play_mutex);
         m_parent        = rhs.m_parent;             /* a pointer, careful!  */
         m_events        = rhs.m_events;
         m_triggers      = rhs.m_triggers;
@@ -226,7 +255,8 @@ sequence::set_hold_undo (bool hold)
     automutex locker(m_mutex);
     if (hold)
     {
-        for (event_list::iterator i = m_events.begin(); i != m_events.end(); ++i)
+        event_list::const_iterator i;
+        for (i = m_events.cbegin(); i != m_events.cend(); ++i)
             m_events_undo_hold.add(DREF(i));
     }
     else
@@ -258,7 +288,9 @@ sequence::event_count () const
  *
  * \param hold
  *      A new parameter for the stazed undo/redo support, not yet used.
- *      If true, then the events go into the undo-hold-list.
+ *      If true, then the events go into the undo-hold-list.  Otherwise,
+ *      inside a transaction, the events are pushed only if the transaction
+ *      has not yet saved them.
  */
 
 void
@@ -268,11 +300,78 @@ sequence::push_undo (bool hold)
     if (hold)
         m_events_undo.push(m_events_undo_hold);     // stazed
     else
-        m_events_undo.push(m_events);
+        save_undo();
 
     set_have_undo();                                // stazed
 }
 
+/**
+ *  Starts a transaction, a series of edits that are to be treated as one
+ *  edit.  Locks the sequence until the matching commit_edit(), and saves
+ *  the events in the undo history, once, just before the first change (see
+ *  save_transaction_undo()).  The edits done inside the
+ *  transaction save no undo state of their own, and their calls to
+ *  verify_and_link(), set_dirty(), and modify() are put off, so that the
+ *  events are linked, and the GUI and performance notified, only once, at
+ *  the end.  The output thread keeps playing the events as they were
+ *  before the transaction until then.
+ *
+ *  Transactions can be nested; only the outermost one counts.  Rather than
+ *  calling this function directly, use a sequence::transaction object.
+ *
+ * \threadsafe
+ */
+
+void
+sequence::begin_edit ()
+{
+    m_mutex.lock();
+    ++m_edit_depth;
+    m_snapshot_stale = true;
+    if (m_transaction_depth == 0)
+    {
+        m_transaction_thread = pthread_self();
+        m_transaction_undo = true;
+        m_transaction_relink = false;
+        m_transaction_dirty = false;
+        m_transaction_modified = false;
+    }
+    ++m_transaction_depth;
+}
+
+/**
+ *  Ends a transaction started by begin_edit().  At the end of the
+ *  outermost transaction, links the events if any edit asked for it, sets
+ *  the flags that the edits would have set, and publishes the new events to
+ *  the output thread.
+ *
+ * \threadsafe
+ */
+
+void
+sequence::commit_edit ()
+{
+    if (--m_transaction_depth == 0)
+    {
+        m_transaction_undo = false;
+        if (m_transaction_relink)
+        {
+            m_events.verify_and_link(m_length);
+            m_transaction_relink = false;
+        }
+        set_have_undo();                /* calls modify() if undo is there  */
+        if (m_transaction_dirty)
+            set_dirty();
+
+        if (m_transaction_modified)
+            modify();
+    }
+    if (--m_edit_depth == 0)
+        publish_snapshot();
+
+    m_mutex.unlock();
+}
+
 /**
  *  If there are items on the undo list, this function pushes the
  *  event-list into the redo-list, puts the top of the undo-list into the
@@ -289,11 +388,11 @@ sequence::push_undo (bool hold)
 void
 sequence::pop_undo ()
 {
-    automutex locker(m_mutex);
+    editlock locker(*this);
     if (! m_events_undo.empty())                // stazed: m_list_undo
     {
         m_events_redo.push(m_events);           // move to triggers module?
-        m_events = m_events_undo.top();
+        m_events_undo.top().unpack(m_events);
         m_events_undo.pop();
         verify_and_link();
         unselect();
@@ -314,11 +413,11 @@ sequence::pop_undo ()
 void
 sequence::pop_redo ()
 {
-    automutex locker(m_mutex);
+    editlock locker(*this);
     if (! m_events_redo.empty())                // move to triggers module?
     {
         m_events_undo.push(m_events);
-        m_events = m_events_redo.top();
+        m_events_redo.top().unpack(m_events);
         m_events_redo.pop();
         verify_and_link();
         unselect();
@@ -328,42 +427,44 @@ sequence::pop_redo ()
 }
 
 /**
- *  Calls triggers::push_undo() with locking.
+ *  Calls triggers::save() with locking.
  *
  * \threadsafe
- */
-
-void
-sequence::push_trigger_undo ()
-{
-    automutex locker(m_mutex);
-    m_triggers.push_undo(); // todo:  see how stazed's sequence function works
-}
-
-/**
- *  Calls triggers::pop_undo() with locking.
  *
- * \threadsafe
+ * \param [out] previous
+ *      Receives the triggers as they were last saved, if they changed.
+ *
+ * \return
+ *      Returns true if the triggers changed since they were last saved.
  */
 
-void
-sequence::pop_trigger_undo ()
+bool
+sequence::save_triggers (triggers::List & previous)
 {
-    automutex locker(m_mutex);
-    m_triggers.pop_undo();
+    automutex locker(m_play_mutex);
+    return m_triggers.save(previous);
 }
 
 /**
- *  Calls triggers::pop_redo() with locking.
+ *  Calls triggers::restore() with locking.
  *
  * \threadsafe
+ *
+ * \param trigs
+ *      The triggers to put in place.
+ *
+ * \param [out] previous
+ *      Receives the triggers that were replaced.
  */
 
 void
-sequence::pop_trigger_redo ()
+sequence::restore_triggers
+(
+    const triggers::List & trigs, triggers::List & previous
+)
 {
-    automutex locker(m_mutex);
-    m_triggers.pop_redo();
+    automutex locker(m_play_mutex);
+    m_triggers.restore(trigs, previous);
 }
 
 /**
@@ -476,6 +577,7 @@ sequence::select_even_or_odd_notes (int note_len, bool even)
 {
     int result = 0;
     automutex locker(m_mutex);
+    link_if_stale();
     unselect();
     for (event_list::iterator i = m_events.begin(); i != m_events.end(); ++i)
     {
@@ -558,7 +660,8 @@ sequence::select_note_events
 )
 {
     int result = 0;
-    automutex locker(m_mutex);
+    editlock locker(*this, false);      /* can remove one */
+    link_if_stale();
     for (event_list::iterator i = m_events.begin(); i != m_events.end(); ++i)
     {
         event & e = DREF(i);
@@ -899,6 +1002,7 @@ sequence::select_linked (midipulse tick_s, midipulse tick_f, midibyte status)
 {
     int result = 0;
     automutex locker(m_mutex);
+    link_if_stale();
     for (event_list::iterator i = m_events.begin(); i != m_events.end(); ++i)
     {
         event & e = DREF(i);
@@ -965,7 +1069,7 @@ sequence::set_rec_vol (int recvol)
 void
 sequence::toggle_queued ()
 {
-    automutex locker(m_mutex);
+    automutex locker(m_play_mutex);
     set_dirty_mp();
     m_queued = ! m_queued;
     m_queued_tick = m_last_tick - mod_last_tick() + m_length;
@@ -983,7 +1087,7 @@ sequence::toggle_queued ()
 void
 sequence::off_queued ()
 {
-    automutex locker(m_mutex);
+    automutex locker(m_play_mutex);
     set_dirty_mp();
     m_queued = false;
 }
@@ -1000,7 +1104,7 @@ sequence::off_queued ()
 void
 sequence::on_queued ()
 {
-    automutex locker(m_mutex);
+    automutex locker(m_play_mutex);
     m_queued = true;
     set_dirty_mp();
 }
@@ -1021,6 +1125,28 @@ sequence::on_queued ()
  *  function.  It's return value and side-effects tell if there's a change in
  *  playing based on triggers and tells the ticks that bracket it.
  *
+ *  The seq24 version of this function restarted at the beginning of the
+ *  event list on every call, skipping events until reaching the start of
+ *  the frame.  For long patterns, that skipping cost more than playing the
+ *  events.  Now the function saves a play cursor at the first unplayed event
+ *  (and the offset base of that event, to handle the wraparound at
+ *  m_length), and resumes there in the next frame.  The cursor is reused
+ *  only if the new frame starts exactly where the previous one ended, and
+ *  no new snapshot of the events has been published; otherwise it is rebuilt
+ *  the old way.  Thus the per-frame cost depends on the number of events
+ *  played, not on the size of the pattern.
+ *
+ *  The events are read from the published event_snapshot, not from
+ *  m_events, and only m_play_mutex is locked, so that an edit in progress
+ *  (which holds m_mutex) does not hold up the output thread.  The frame
+ *  plays the last finished edit.  The play cursor is an index into the
+ *  snapshot, and is dropped when a new snapshot is published.
+ *
+ *  The song transpose and the velocity scale are applied, by a
+ *  play_transform, to the packed word of each event just before it is
+ *  unpacked into the one reusable event that goes to the buss.  No event is
+ *  copied and nothing is allocated.
+ *
  * \param end_tick
  *      Provides the current end-tick value.  The tick comes in as a global
  *      tick.
@@ -1038,7 +1164,7 @@ sequence::on_queued ()
 void
 sequence::play (midipulse end_tick, bool playback_mode)
 {
-    automutex locker(m_mutex);
+    automutex locker(m_play_mutex);
     bool trigger_turning_off = false;       /* turn off after frame play    */
     midipulse start_tick = m_last_tick;     /* modified in triggers::play() */
     if (m_song_mute)
@@ -1052,72 +1178,214 @@ sequence::play (midipulse end_tick, bool playback_mode)
     }
     if (m_playing)                          /* play notes in frame  */
     {
-        midipulse offset = m_length - m_trigger_offset;
-        midipulse start_tick_offset = start_tick + offset;
-        midipulse end_tick_offset = end_tick + offset;
-        midipulse times_played = m_last_tick / m_length;
-        midipulse offset_base = times_played * m_length;
-#ifdef SEQ64_STAZED_TRANSPOSE
-        int transpose = get_transposable() ? m_parent->get_transpose() : 0 ;
-#endif
-        event_list::iterator e = m_events.begin();
-        while (e != m_events.end())
+        const event_snapshot * snap = m_snapshot.acquire();
+        int count = is_nullptr(snap) ? 0 : snap->count() ;
+        if (count > 0)
         {
-            event & er = DREF(e);
-            midipulse stamp = er.get_timestamp() + offset_base;
-            if (stamp >= start_tick_offset && stamp <= end_tick_offset)
+            midipulse offset = m_length - m_trigger_offset;
+            midipulse start_tick_offset = start_tick + offset;
+            midipulse end_tick_offset = end_tick + offset;
+            midipulse offset_base;
+            int i;
+            bool resume = m_play_cursor_valid &&
+                m_play_next_tick == start_tick_offset &&
+                m_play_serial == snap->serial();
+
+            if (resume)
             {
+                i = m_play_index;                   /* pick up where we were */
+                offset_base = m_play_offset_base;
+            }
+            else
+            {
+                midipulse times_played = m_last_tick / m_length;
+                offset_base = times_played * m_length;
+                i = 0;
+            }
 #ifdef SEQ64_STAZED_TRANSPOSE
-                if (transpose != 0 && er.is_note()) /* includes Aftertouch  */
-                {
-                    event transposed_event = er;    /* assign ALL members   */
-                    transposed_event.transpose_note(transpose);
-                    put_event_on_bus(transposed_event);
-                }
-                else
-                {
+            int transpose = get_transposable() ? m_parent->get_transpose() : 0 ;
+#else
+            int transpose = 0;
 #endif
-                    if (er.is_tempo())
+            play_transform xform(transpose, SEQ64_VELOCITY_SCALE_NONE);
+            bool transform = xform.active();
+            const midipulse * ticks = snap->ticks();
+            const event_snapshot::word * words = snap->words();
+            event ev;                               /* reused for each event */
+            for (;;)
+            {
+                midipulse stamp = ticks[i] + offset_base;
+                if (stamp >= start_tick_offset && stamp <= end_tick_offset)
+                {
+                    event_snapshot::word w = words[i];
+                    if (event_snapshot::is_tempo(w))
                     {
                         if (not_nullptr(m_parent))
-                            m_parent->set_beats_per_minute(er.tempo());
+                            m_parent->set_beats_per_minute(snap->tempo(w));
+                    }
+                    else
+                    {
+                        if (transform)              /* transpose, velocity  */
+                            w = xform.apply(w);
+
+                        ev.set_timestamp(ticks[i]);
+                        event_snapshot::unpack(w, ev);
+                        put_event_on_bus(ev, stamp - offset);
                     }
-                    else if (! er.is_ex_data())
-                        put_event_on_bus(er);       /* frame still going    */
-#ifdef SEQ64_STAZED_TRANSPOSE
                 }
-#endif
-            }
-            else if (stamp > end_tick_offset)
-                break;                              /* frame is done        */
+                else if (stamp > end_tick_offset)
+                    break;                          /* frame is done        */
 
-            ++e;                                    /* go to next event     */
-            if (e == m_events.end())                /* did we hit the end ? */
-            {
-                e = m_events.begin();               /* yes, start over      */
-                offset_base += m_length;            /* for another go at it */
+                if (++i == count)                   /* did we hit the end ? */
+                {
+                    i = 0;                          /* yes, start over      */
+                    offset_base += m_length;        /* for another go at it */
+                }
             }
+            m_play_index = i;                       /* first unplayed event */
+            m_play_offset_base = offset_base;
+            m_play_next_tick = end_tick_offset + 1;
+            m_play_serial = snap->serial();
+            m_play_cursor_valid = true;
         }
+        else
+            reset_play_cursor();
+
+        m_snapshot.release();
     }
+    else
+        reset_play_cursor();
+
     if (trigger_turning_off)                        /* triggers: "turn off" */
+    {
+        m_off_tick = end_tick;                      /* Note Offs at the end */
         set_playing(false);
+        m_off_tick = SEQ64_NULL_MIDIPULSE;
+    }
 
     m_last_tick = end_tick + 1;                     /* for next frame       */
     m_was_playing = m_playing;
 }
 
+/**
+ *  Builds a new playable snapshot of the events and publishes it to the
+ *  output thread, if the events might have changed since the last one.
+ *  Called by the outermost editlock when it is released, with m_mutex still
+ *  held.  The previous snapshot is freed later, once play() is no longer
+ *  using it.  Thus the snapshot is rebuilt only after an edit, never by the
+ *  output thread.
+ *
+ * \threadunsafe
+ */
+
+void
+sequence::publish_snapshot ()
+{
+    if (m_snapshot_stale || m_events.generation() != m_snapshot_generation)
+    {
+        m_snapshot.publish(new event_snapshot(m_events));
+        m_snapshot_generation = m_events.generation();
+        m_snapshot_stale = false;
+        wake_output();
+    }
+}
+
+/**
+ *  Finds the earliest global tick, at or after the given tick, at which
+ *  play() or play_queue() would have something to do for this sequence:  play
+ *  an event, toggle a queued pattern, or see a trigger edge in song mode.
+ *  The result can be early (e.g. an event after the trigger ends), but never
+ *  late, so that the output thread can safely sleep until then.
+ *
+ *  The event is found with a binary search of the published event_snapshot,
+ *  allowing for the wraparound at m_length in the same way as play().
+ *
+ * \param tick
+ *      Provides the first global tick not yet played.
+ *
+ * \param playbackmode
+ *      True for song mode, where trigger edges count.
+ *
+ * \return
+ *      Returns the tick, or SEQ64_NULL_MIDIPULSE if nothing will happen.
+ *
+ * \threadsafe
+ */
+
+midipulse
+sequence::next_event_tick (midipulse tick, bool playbackmode)
+{
+    automutex locker(m_play_mutex);
+    midipulse result = SEQ64_NULL_MIDIPULSE;
+    if (m_queued)
+        result = m_queued_tick;
+
+    if (playbackmode && ! m_song_mute)
+        result = earlier_pulse(result, m_triggers.next_edge(tick));
+
+    if (m_playing && ! m_song_mute && m_length > 0)
+    {
+        const event_snapshot * snap = m_snapshot.acquire();
+        int count = is_nullptr(snap) ? 0 : snap->count() ;
+        if (count > 0)
+        {
+            midipulse offset = m_length - m_trigger_offset;
+            midipulse tick_offset = tick + offset;
+            midipulse offset_base = tick_offset - (tick_offset % m_length);
+            const midipulse * first = snap->ticks();
+            const midipulse * last = first + count;
+            const midipulse * p = std::lower_bound
+            (
+                first, last, tick_offset - offset_base
+            );
+            midipulse stamp = *first + offset_base + m_length;
+            if (p != last && *p + offset_base < stamp)
+                stamp = *p + offset_base;
+
+            result = earlier_pulse(result, stamp - offset);
+        }
+        m_snapshot.release();
+    }
+    return result;
+}
+
 /**
  *  This function verifies state: all note-ons have a note-off, and it links
- *  note-offs with their note-ons.
+ *  note-offs with their note-ons.  Inside a transaction, this is put off
+ *  until commit_edit(), or until an edit needs the links (see
+ *  link_if_stale()).
  *
  * \threadsafe
  */
 
 void
 sequence::verify_and_link ()
+{
+    editlock locker(*this);
+    if (m_transaction_depth > 0)
+        m_transaction_relink = true;            /* done in commit_edit()    */
+    else
+        m_events.verify_and_link(m_length);
+}
+
+/**
+ *  Links the events now, if an edit in the current transaction has put off
+ *  the linking.  Called at the start of the functions that follow the
+ *  links between Note On and Note Off events.  Since linking also unmarks
+ *  the events, it must be called before any marking.
+ *
+ * \threadsafe
+ */
+
+void
+sequence::link_if_stale ()
 {
     automutex locker(m_mutex);
-    m_events.verify_and_link(m_length);
+    if (m_transaction_relink)
+    {
+        m_events.verify_and_link(m_length);
+        m_transaction_relink = false;
+    }
 }
 
 /**
@@ -1134,8 +1402,8 @@ sequence::link_new ()
 }
 
 /**
- *  A helper function, which does not lock/unlock, so it is unsafe to call
- *  without supplying an iterator from the event-list.  We no longer
+ *  A helper function, which does not lock/unlock m_mutex, so it is unsafe to
+ *  call without supplying an iterator from the event-list.  We no longer
  *  bother checking the pointer.  If it is bad, all hope is lost.
  *  If the event is a note off, and that note is currently playing, then send
  *  a note off.
@@ -1150,10 +1418,14 @@ void
 sequence::remove (event_list::iterator i)
 {
     event & er = DREF(i);
-    if (er.is_note_off() && m_playing_notes[er.get_note()] > 0)
+    if (er.is_note_off())
     {
-        m_masterbus->play(m_bus, &er, m_midi_channel);
-        --m_playing_notes[er.get_note()];                   // ugh
+        automutex locker(m_play_mutex);                     /* playing notes */
+        if (m_playing_notes[er.get_note()] > 0)
+        {
+            m_masterbus->play(m_bus, &er, m_midi_channel);
+            --m_playing_notes[er.get_note()];               // ugh
+        }
     }
     m_events.remove(i);                                     // erase(i)
 }
@@ -1199,7 +1471,7 @@ sequence::remove (event & e)
 bool
 sequence::remove_marked ()
 {
-    automutex locker(m_mutex);
+    editlock locker(*this);
 
 #ifdef LAYK_PULL_REQUEST_95
 
@@ -1207,7 +1479,8 @@ sequence::remove_marked ()
      * We have to make note off before moving and cutting. Here or in event_list?
      */
 
-    for (event_list::iterator i = m_events.begin(); i != m_events.end(); ++i)
+    event_list::const_iterator i;
+    for (i = m_events.cbegin(); i != m_events.cend(); ++i)
     {
         const event & e = m_events.dref(i);
         if (e.is_marked())
@@ -1257,10 +1530,10 @@ sequence::mark_selected ()
 void
 sequence::remove_selected ()
 {
-    automutex locker(m_mutex);
+    editlock locker(*this);
     if (m_events.mark_selected())
     {
-        m_events_undo.push(m_events);           /* push_undo() without lock */
+        save_undo();                            /* push_undo() without lock */
         (void) m_events.remove_marked();
         reset_draw_marker();
     }
@@ -1310,7 +1583,8 @@ sequence::get_selected_box
     tick_f = 0;
     note_h = 0;
     note_l = SEQ64_MIDI_COUNT_MAX;
-    for (event_list::iterator i = m_events.begin(); i != m_events.end(); ++i)
+    event_list::const_iterator i;
+    for (i = m_events.cbegin(); i != m_events.cend(); ++i)
     {
         if (DREF(i).is_selected())
         {
@@ -1368,8 +1642,8 @@ sequence::get_clipboard_box
     }
     else
     {
-        event_list::iterator i;
-        for (i = m_events_clipboard.begin(); i != m_events_clipboard.end(); ++i)
+        event_list::const_iterator i;
+        for (i = m_events_clipboard.cbegin(); i != m_events_clipboard.cend(); ++i)
         {
             midipulse time = DREF(i).get_timestamp();
             if (time < tick_s)
@@ -1468,7 +1742,8 @@ sequence::select_note_events
 )
 {
     int result = 0;
-    automutex locker(m_mutex);
+    editlock locker(*this, false);      /* can remove one */
+    link_if_stale();
     for (event_list::iterator i = m_events.begin(); i != m_events.end(); ++i)
     {
         event & er = DREF(i);
@@ -1674,7 +1949,7 @@ sequence::select_events
 )
 {
     int result = 0;
-    automutex locker(m_mutex);
+    editlock locker(*this, false);      /* can remove one */
     for (event_list::iterator i = m_events.begin(); i != m_events.end(); ++i)
     {
         event & er = DREF(i);
@@ -1802,8 +2077,8 @@ sequence::move_selected_notes (midipulse delta_tick, int delta_note)
 {
     if (mark_selected())                            /* locked recursively   */
     {
-        automutex locker(m_mutex);
-        m_events_undo.push(m_events);               /* push_undo(), no lock */
+        editlock locker(*this);
+        save_undo();                                /* push_undo(), no lock */
         for (event_list::iterator i = m_events.begin(); i != m_events.end(); ++i)
         {
             event & er = DREF(i);
@@ -1955,10 +2230,10 @@ sequence::stretch_selected (midipulse delta_tick)
 {
     if (mark_selected())
     {
-        automutex locker(m_mutex);
+        editlock locker(*this);
         unsigned first_ev = 0x7fffffff;             /* timestamp lower limit */
         unsigned last_ev = 0x00000000;              /* timestamp upper limit */
-        m_events_undo.push(m_events);               /* push_undo(), no lock  */
+        save_undo();                                /* push_undo(), no lock  */
         for (event_list::iterator i = m_events.begin(); i != m_events.end(); ++i)
         {
             event & er = DREF(i);
@@ -2044,10 +2319,11 @@ sequence::stretch_selected (midipulse delta_tick)
 void
 sequence::grow_selected (midipulse delta)
 {
+    link_if_stale();                                /* before the marking   */
     if (mark_selected())                            /* locked recursively   */
     {
-        automutex locker(m_mutex);                  /* lock it again, dude  */
-        m_events_undo.push(m_events);               /* push_undo(), no lock */
+        editlock locker(*this);                     /* one snapshot at end  */
+        save_undo();                                /* push_undo(), no lock */
         for (event_list::iterator i = m_events.begin(); i != m_events.end(); ++i)
         {
             event & er = DREF(i);
@@ -2105,8 +2381,8 @@ sequence::randomize_selected
     midibyte data[2];
     midibyte datitem;
     int datidx = 0;
-    automutex locker(m_mutex);
-    m_events_undo.push(m_events);               /* push_undo(), no lock  */
+    editlock locker(*this);
+    save_undo();                                /* push_undo(), no lock  */
     for (event_list::iterator i = m_events.begin(); i != m_events.end(); ++i)
     {
         event & e = DREF(i);
@@ -2149,7 +2425,7 @@ sequence::adjust_data_handle (midibyte status, int adata)
     midibyte data[2];
     midibyte datitem;
     int datidx = 0;
-    automutex locker(m_mutex);
+    editlock locker(*this);
     for (event_list::iterator i = m_events.begin(); i != m_events.end(); ++i)
     {
         event & e = DREF(i);
@@ -2205,7 +2481,7 @@ sequence::adjust_data_handle (midibyte status, int adata)
 void
 sequence::increment_selected (midibyte astat, midibyte /*acontrol*/)
 {
-    automutex locker(m_mutex);
+    editlock locker(*this);
     for (event_list::iterator i = m_events.begin(); i != m_events.end(); ++i)
     {
         event & er = DREF(i);
@@ -2248,7 +2524,7 @@ sequence::increment_selected (midibyte astat, midibyte /*acontrol*/)
 void
 sequence::decrement_selected (midibyte astat, midibyte /*acontrol*/)
 {
-    automutex locker(m_mutex);
+    editlock locker(*this);
     for (event_list::iterator i = m_events.begin(); i != m_events.end(); ++i)
     {
         event & er = DREF(i);
@@ -2296,7 +2572,8 @@ sequence::copy_selected ()
 {
     automutex locker(m_mutex);
     event_list clipbd;
-    for (event_list::iterator i = m_events.begin(); i != m_events.end(); ++i)
+    event_list::const_iterator i;
+    for (i = m_events.cbegin(); i != m_events.cend(); ++i)
     {
         if (DREF(i).is_selected())
             clipbd.add(DREF(i));
@@ -2415,9 +2692,10 @@ sequence::paste_selected (midipulse tick, int note)
 {
     if (! m_events_clipboard.empty())
     {
-        automutex locker(m_mutex);
-        event_list clipbd = m_events_clipboard;     /* copy the clipboard   */
-        m_events_undo.push(m_events);               /* push_undo(), no lock */
+        editlock locker(*this);
+        event_list clipbd(m_event_pool);            /* same pool to merge   */
+        clipbd = m_events_clipboard;                /* copy the clipboard   */
+        save_undo();                                /* push_undo(), no lock */
         for (event_list::iterator i = clipbd.begin(); i != clipbd.end(); ++i)
         {
             event & e = DREF(i);
@@ -2454,7 +2732,7 @@ sequence::paste_selected (midipulse tick, int note)
          * \change 0rel 2016-06-12 fix, see the banner notes.
          */
 
-        event_list clipbd_updated;
+        event_list clipbd_updated(m_event_pool);
         for (event_list::iterator i = clipbd.begin(); i != clipbd.end(); ++i)
             clipbd_updated.add(DREF(i));
 
@@ -2463,8 +2741,7 @@ sequence::paste_selected (midipulse tick, int note)
 
 #else
 
-        m_events.merge(clipbd, false);          /* don't presort clipboard  */
-        m_events.sort();                        /* does nothing in map      */
+        m_events.merge(clipbd);                 /* one sort, linear merge   */
 
 #endif      // SEQ64_USE_EVENT_MAP
 
@@ -2529,7 +2806,7 @@ sequence::change_event_data_range
     int data_s, int data_f
 )
 {
-    automutex locker(m_mutex);
+    editlock locker(*this);
     bool result = false;
     bool have_selection = get_num_selected_events(status, cc) > 0;
     for (event_list::iterator i = m_events.begin(); i != m_events.end(); ++i)
@@ -2649,7 +2926,7 @@ sequence::change_event_data_lfo
     wave_type_t wave, midibyte status, midibyte cc
 )
 {
-    automutex locker(m_mutex);
+    editlock locker(*this);
     double dlength = double(m_length);
     double dbw = double(m_time_beat_width);
     bool have_selection = false;            /* change only selected if true */
@@ -2768,7 +3045,8 @@ sequence::add_note
     bool result = false;
     if (tick >= 0 && note >= 0 && note < c_num_keys)
     {
-        automutex locker(m_mutex);
+        editlock locker(*this);
+        link_if_stale();
         bool hardwire = velocity == SEQ64_PRESERVE_VELOCITY;
         bool ignore = false;
         if (paint)                        /* see the banner above */
@@ -2918,7 +3196,7 @@ sequence::add_chord (int chord, midipulse tick, midipulse len, int note)
 bool
 sequence::add_event (const event & er)
 {
-    automutex locker(m_mutex);
+    editlock locker(*this);
     bool result = m_events.add(er);     /* post/auto-sorts by time & rank   */
     if (result)
     {
@@ -2935,7 +3213,10 @@ sequence::add_event (const event & er)
 /**
  *  An alternative to add_event() that does not sort the events, even if the
  *  event list is implemented by an std::list.  This function is meant mainly
- *  for reading the MIDI file, to save a lot of time.
+ *  for reading the MIDI file, to save a lot of time.  For the same reason,
+ *  it does not publish a new playable snapshot; the events are unsorted at
+ *  this point.  The sort_events() and set_length() calls that follow the
+ *  loading of the events take care of that.
  *
  * \param er
  *      Provide a reference to the event to be added; the event is copied into
@@ -2985,7 +3266,8 @@ sequence::add_event
     midibyte d0, midibyte d1, bool paint
 )
 {
-    automutex locker(m_mutex);
+    editlock locker(*this);
+    link_if_stale();
     bool result = false;
     if (tick >= 0)
     {
@@ -3031,7 +3313,9 @@ sequence::add_event
  *      -   If not playing, but the event is a Note On or Note Off, we add it
  *          and keep track of it.
  *
- *  If MIDI Thru is enabled, the event is put on the buss.
+ *  MIDI Thru is not done here.  The input thread sends the event through
+ *  mastermidibase::thru() before recording it, so that live playing does not
+ *  wait on the sequence lock (see update_thru_route()).
  *
  *  We are adding a feature where events are rejected if their channel
  *  doesn't match that of the sequence.  This has been a complaint of some
@@ -3064,7 +3348,7 @@ sequence::add_event
 bool
 sequence::stream_event (event & ev)
 {
-    automutex locker(m_mutex);
+    editlock locker(*this);
     bool result = channel_match(ev);            /* set if channel matches   */
     if (result)
     {
@@ -3112,7 +3396,11 @@ sequence::stream_event (event & ev)
                     if (! keepvelocity)
                         velocity = m_rec_vol;
 
-                    m_events_undo.push(m_events);       /* push_undo()      */
+                    /*
+                     * A run of step-entered notes is undone as one step.
+                     */
+
+                    save_undo(true);                    /* push_undo()      */
                     add_note                            /* more locking     */
                     (
                         mod_last_tick(), m_snap_tick - m_note_off_margin,
@@ -3125,12 +3413,9 @@ sequence::stream_event (event & ev)
                     --m_notes_on;
 
                 if (m_notes_on <= 0)
-                    m_last_tick += m_snap_tick;
+                    set_last_tick(m_last_tick + m_snap_tick);
             }
         }
-        if (m_thru)
-            put_event_on_bus(ev);                       /* more locking     */
-
         link_new();                                     /* more locking     */
         if (m_quantized_rec && m_parent->is_pattern_playing())
         {
@@ -3162,10 +3447,27 @@ void
 sequence::set_dirty_mp ()
 {
     m_dirty_names = m_dirty_main = m_dirty_perf = true;
+    wake_output();
 }
 
 /**
- *  Call set_dirty_mp() and then sets the dirty flag for editing.
+ *  Tells the performance output thread that something that affects playback
+ *  (events, triggers, queueing, or the playing status) has changed, so that
+ *  it does not sleep past the next event.
+ *
+ * \threadsafe
+ */
+
+void
+sequence::wake_output ()
+{
+    if (not_nullptr(m_parent))
+        m_parent->wake_output();
+}
+
+/**
+ *  Call set_dirty_mp() and then sets the dirty flag for editing.  Inside a
+ *  transaction, this is put off until commit_edit().
  *
  * \threadsafe
  */
@@ -3173,8 +3475,15 @@ sequence::set_dirty_mp ()
 void
 sequence::set_dirty ()
 {
-    set_dirty_mp();
-    m_dirty_edit = true;
+    if (in_transaction())
+    {
+        m_transaction_dirty = true;             /* done in commit_edit()    */
+    }
+    else
+    {
+        set_dirty_mp();
+        m_dirty_edit = true;
+    }
 }
 
 /**
@@ -3309,7 +3618,7 @@ sequence::play_note_off (int note)
 void
 sequence::clear_triggers ()
 {
-    automutex locker(m_mutex);
+    automutex locker(m_play_mutex);
     m_triggers.clear();
 }
 
@@ -3338,7 +3647,7 @@ sequence::add_trigger
     midipulse tick, midipulse len, midipulse offset, bool fixoffset
 )
 {
-    automutex locker(m_mutex);
+    automutex locker(m_play_mutex);
     m_triggers.add(tick, len, offset, fixoffset);
 }
 
@@ -3371,7 +3680,7 @@ sequence::intersect_triggers
     midipulse position, midipulse & start, midipulse & ender
 )
 {
-    automutex locker(m_mutex);
+    automutex locker(m_play_mutex);
     return m_triggers.intersect(position, start, ender);
 }
 
@@ -3496,9 +3805,10 @@ sequence::intersect_events
 {
     automutex locker(m_mutex);
     midipulse poslength = posend - posstart;
-    for (event_list::iterator on = m_events.begin(); on != m_events.end(); ++on)
+    event_list::const_iterator on;
+    for (on = m_events.cbegin(); on != m_events.cend(); ++on)
     {
-        event & eon = DREF(on);
+        const event & eon = DREF(on);
         if (status == eon.get_status())
         {
             midipulse ts = eon.get_timestamp();
@@ -3530,7 +3840,7 @@ sequence::intersect_events
 void
 sequence::grow_trigger (midipulse tickfrom, midipulse tickto, midipulse len)
 {
-    automutex locker(m_mutex);
+    automutex locker(m_play_mutex);
     m_triggers.grow(tickfrom, tickto, len);
 }
 
@@ -3547,7 +3857,7 @@ sequence::grow_trigger (midipulse tickfrom, midipulse tickto, midipulse len)
 void
 sequence::del_trigger (midipulse tick)
 {
-    automutex locker(m_mutex);
+    automutex locker(m_play_mutex);
     m_triggers.remove(tick);
 }
 
@@ -3564,7 +3874,7 @@ sequence::del_trigger (midipulse tick)
 void
 sequence::set_trigger_offset (midipulse trigger_offset)
 {
-    automutex locker(m_mutex);
+    automutex locker(m_play_mutex);
     if (m_length > 0)
     {
         m_trigger_offset = trigger_offset % m_length;
@@ -3587,7 +3897,7 @@ sequence::set_trigger_offset (midipulse trigger_offset)
 void
 sequence::split_trigger (midipulse splittick)
 {
-    automutex locker(m_mutex);
+    automutex locker(m_play_mutex);
     m_triggers.split(splittick);
 }
 
@@ -3606,7 +3916,7 @@ sequence::split_trigger (midipulse splittick)
 void
 sequence::adjust_trigger_offsets_to_length (midipulse newlength)
 {
-    automutex locker(m_mutex);
+    automutex locker(m_play_mutex);
     m_triggers.adjust_offsets_to_length(newlength);
 }
 
@@ -3626,7 +3936,7 @@ sequence::adjust_trigger_offsets_to_length (midipulse newlength)
 void
 sequence::copy_triggers (midipulse starttick, midipulse distance)
 {
-    automutex locker(m_mutex);
+    automutex locker(m_play_mutex);
     m_triggers.copy(starttick, distance);
 }
 
@@ -3653,7 +3963,7 @@ sequence::copy_triggers (midipulse starttick, midipulse distance)
 void
 sequence::move_triggers (midipulse starttick, midipulse distance, bool direction)
 {
-    automutex locker(m_mutex);
+    automutex locker(m_play_mutex);
     m_triggers.move(starttick, distance, direction);
 }
 
@@ -3670,7 +3980,7 @@ sequence::move_triggers (midipulse starttick, midipulse distance, bool direction
 midipulse
 sequence::selected_trigger_start ()
 {
-    automutex locker(m_mutex);
+    automutex locker(m_play_mutex);
     return m_triggers.get_selected_start();
 }
 
@@ -3687,7 +3997,7 @@ sequence::selected_trigger_start ()
 midipulse
 sequence::selected_trigger_end ()
 {
-    automutex locker(m_mutex);
+    automutex locker(m_play_mutex);
     return m_triggers.get_selected_end();
 }
 
@@ -3728,7 +4038,7 @@ sequence::move_selected_triggers_to
     midipulse tick, bool adjustoffset, triggers::grow_edit_t which
 )
 {
-    automutex locker(m_mutex);
+    automutex locker(m_play_mutex);
     return m_triggers.move_selected(tick, adjustoffset, which);
 }
 
@@ -3744,7 +4054,7 @@ sequence::move_selected_triggers_to
 midipulse
 sequence::get_max_trigger ()
 {
-    automutex locker(m_mutex);
+    automutex locker(m_play_mutex);
     return m_triggers.get_maximum();
 }
 
@@ -3762,7 +4072,7 @@ sequence::get_max_trigger ()
 bool
 sequence::get_trigger_state (midipulse tick)
 {
-    automutex locker(m_mutex);
+    automutex locker(m_play_mutex);
     return m_triggers.get_state(tick);
 }
 
@@ -3777,7 +4087,7 @@ sequence::get_trigger_state (midipulse tick)
 triggers::List
 sequence::get_triggers () const
 {
-    automutex locker(m_mutex);
+    automutex locker(m_play_mutex);
     return triggerlist();
 }
 
@@ -3797,7 +4107,7 @@ sequence::get_triggers () const
 bool
 sequence::select_trigger (midipulse tick)
 {
-    automutex locker(m_mutex);
+    automutex locker(m_play_mutex);
     return m_triggers.select(tick);
 }
 
@@ -3811,7 +4121,7 @@ sequence::select_trigger (midipulse tick)
 bool
 sequence::unselect_triggers ()
 {
-    automutex locker(m_mutex);
+    automutex locker(m_play_mutex);
     return m_triggers.unselect();
 }
 
@@ -3822,7 +4132,7 @@ sequence::unselect_triggers ()
 void
 sequence::del_selected_trigger ()
 {
-    automutex locker(m_mutex);
+    automutex locker(m_play_mutex);
     m_triggers.remove_selected();
 }
 
@@ -3835,7 +4145,7 @@ sequence::cut_selected_trigger ()
 {
     copy_selected_trigger();            /* locks itself */
 
-    automutex locker(m_mutex);
+    automutex locker(m_play_mutex);
     m_triggers.remove_selected();
 }
 
@@ -3847,18 +4157,18 @@ sequence::cut_selected_trigger ()
 void
 sequence::copy_selected_trigger ()
 {
-    automutex locker(m_mutex);
+    automutex locker(m_play_mutex);
     set_trigger_paste_tick(SEQ64_NO_PASTE_TRIGGER);
     m_triggers.copy_selected();
 }
 
 /**
  *  If there is a copied trigger, then this function grabs it from the trigger
- *  clipboard and adds it.
+ *  clipboard and adds it.  Like the other trigger edits, it takes
+ *  m_play_mutex, so that the output thread never sees the trigger list
+ *  and its index in the middle of a change.
  *
- *  Why isn't this protected by a mutex?  We will enable this if anything bad
- *  happens, such as a deadlock, or corruption, that we can prove happens
- *  here.
+ * \threadsafe
  *
  * \param paste_tick
  *      A new parameter that provides the tick for pasting, or
@@ -3868,7 +4178,7 @@ sequence::copy_selected_trigger ()
 void
 sequence::paste_trigger (midipulse paste_tick)
 {
-    automutex locker(m_mutex);          /* @new ca 2016-08-03   */
+    automutex locker(m_play_mutex);
     m_triggers.paste(paste_tick);
 }
 
@@ -3925,7 +4235,7 @@ void
 sequence::reset_draw_marker ()
 {
     automutex locker(m_mutex);
-    m_iterator_draw = m_events.begin();
+    m_iterator_draw = m_events.cbegin();
 }
 
 /**
@@ -3946,16 +4256,21 @@ sequence::inc_draw_marker ()
 }
 
 /**
- *  Sets the draw-trigger iterator to the beginning of the trigger list.
+ *  Sets the draw-trigger iterator to the first trigger that has not ended
+ *  before the given tick.
  *
  * \threadsafe
+ *
+ * \param tick
+ *      The first tick of interest, usually the left edge of the song editor.
+ *      The default, 0, selects the beginning of the trigger list.
  */
 
 void
-sequence::reset_draw_trigger_marker ()
+sequence::reset_draw_trigger_marker (midipulse tick)
 {
-    automutex locker(m_mutex);
-    m_triggers.reset_draw_trigger_marker();
+    automutex locker(m_play_mutex);
+    m_triggers.reset_draw_trigger_marker(tick);
 }
 
 /**
@@ -3990,9 +4305,10 @@ sequence::get_minmax_note_events (int & lowest, int & highest)
     bool result = false;
     int low = SEQ64_MAX_DATA_VALUE;
     int high = -1;
-    for (event_list::iterator i = m_events.begin(); i != m_events.end(); ++i)
+    event_list::const_iterator i;
+    for (i = m_events.cbegin(); i != m_events.cend(); ++i)
     {
-        event & er = DREF(i);
+        const event & er = DREF(i);
         if (er.is_note_on() || er.is_note_off())
         {
             if (er.get_note() < low)
@@ -4064,9 +4380,9 @@ sequence::get_next_note_event
 {
     // automutex locker(m_mutex);               // WILL IT HELP???? No.
     tick_f = 0;
-    while (m_iterator_draw != m_events.end())   /* NOT THREADSAFE!!!!!      */
+    while (m_iterator_draw != m_events.cend())   /* NOT THREADSAFE!!!!!      */
     {
-        event & drawevent = DREF(m_iterator_draw);
+        const event & drawevent = DREF(m_iterator_draw);
         bool isnoteon = drawevent.is_note_on();
         bool islinked = drawevent.is_linked();  /* not get_linked(), idiot! */
         tick_s   = drawevent.get_timestamp();
@@ -4130,10 +4446,10 @@ bool
 sequence::get_next_event (midibyte & status, midibyte & cc)
 {
     // automutex locker(m_mutex);                   // WILL IT HELP?? No.
-    while (m_iterator_draw != m_events.end())       /* NOT THREADSAFE!!!    */
+    while (m_iterator_draw != m_events.cend())       /* NOT THREADSAFE!!!    */
     {
         midibyte j;
-        event & drawevent = DREF(m_iterator_draw);
+        const event & drawevent = DREF(m_iterator_draw);
         status = drawevent.get_status();
         drawevent.get_data(cc, j);
         inc_draw_marker();
@@ -4149,7 +4465,7 @@ sequence::get_next_event (midibyte & status, midibyte & cc)
 void
 sequence::reset_ex_iterator (event_list::const_iterator & evi)
 {
-    evi = m_events.begin();
+    evi = m_events.cbegin();
 }
 
 /**
@@ -4200,7 +4516,7 @@ sequence::get_next_event_ex
     int evtype
 )
 {
-    while (evi != m_events.end())
+    while (evi != m_events.cend())
     {
         const event & drawevent = DREF(evi);
         bool istempo = drawevent.is_tempo();
@@ -4263,15 +4579,18 @@ sequence::get_next_trigger
 
 /**
  *  Clears all events from the event container.  Unsets the modified flag.
- *  (Why?) Also see the new copy_events() function.
+ *  (Why?) Also see the new copy_events() function.  Unless a copy of the
+ *  events still holds some of its nodes, the event pool gives all of its
+ *  memory back at once.
  */
 
 void
 sequence::remove_all ()
 {
-    automutex locker(m_mutex);
+    editlock locker(*this);
     m_events.clear();
     m_events.unmodify();
+    m_event_pool->release();                    /* frees it all at once     */
 }
 
 /**
@@ -4285,8 +4604,9 @@ sequence::remove_all ()
 void
 sequence::set_last_tick (midipulse tick)
 {
-    automutex locker(m_mutex);
+    automutex locker(m_play_mutex);
     m_last_tick = tick;
+    reset_play_cursor();                /* a seek, in effect                */
 }
 
 /**
@@ -4308,7 +4628,8 @@ sequence::get_last_tick () const
 }
 
 /**
- *  Sets the MIDI buss/port number to dump MIDI data to.
+ *  Sets the MIDI buss/port number to dump MIDI data to.  The play mutex is
+ *  held too, so that the change cannot come in the middle of play().
  *
  * \threadsafe
  *
@@ -4328,10 +4649,14 @@ void
 sequence::set_midi_bus (char mb, bool user_change)
 {
     automutex locker(m_mutex);
+    automutex playlocker(m_play_mutex); /* play() reads m_bus               */
     off_playing_notes();                /* off notes except initial         */
     if (mb != m_bus)
     {
         m_bus = mb;
+        if (m_thru)
+            update_thru_route();
+
         if (user_change)
             modify();                   /* no easy way to undo this, though */
     }
@@ -4393,7 +4718,8 @@ sequence::set_midi_bus (char mb, bool user_change)
 void
 sequence::set_length (midipulse len, bool adjust_triggers, bool verify)
 {
-    automutex locker(m_mutex);
+    editlock locker(*this);
+    automutex playlocker(m_play_mutex);
     bool was_playing = get_playing();
     set_playing(false);                 /* turn everything off              */
     if (len > 0)
@@ -4402,6 +4728,7 @@ sequence::set_length (midipulse len, bool adjust_triggers, bool verify)
             len = midipulse(m_ppqn / 4);
 
         m_length = len;
+        reset_play_cursor();            /* offset bases are now wrong       */
     }
     else
         len = m_length;
@@ -4488,7 +4815,7 @@ sequence::extend (midipulse len)
 void
 sequence::set_playing (bool p)
 {
-    automutex locker(m_mutex);
+    automutex locker(m_play_mutex);
     if (p != get_playing())
     {
         m_playing = p;
@@ -4512,6 +4839,7 @@ sequence::set_recording (bool r)
     automutex locker(m_mutex);
     m_recording = r;
     m_notes_on = 0;
+    m_events_undo.end_group();                  /* end any step-entry run   */
 }
 
 /**
@@ -4581,6 +4909,25 @@ sequence::set_thru (bool r)
 {
     automutex locker(m_mutex);
     m_thru = r;
+    update_thru_route();
+}
+
+/**
+ *  Tells the master buss where MIDI Thru input goes:  to the buss and
+ *  channel of this sequence if its thru button is on, else nowhere.  The
+ *  caller must hold m_mutex.
+ */
+
+void
+sequence::update_thru_route ()
+{
+    if (not_nullptr(m_masterbus))
+    {
+        if (m_thru)
+            m_masterbus->set_thru_route(this, m_bus, m_midi_channel);
+        else
+            m_masterbus->clear_thru_route(this);
+    }
 }
 
 /**
@@ -4645,7 +4992,8 @@ sequence::title () const
 }
 
 /**
- *  Sets the m_midi_channel number>
+ *  Sets the m_midi_channel number, under the play mutex too, as in
+ *  set_midi_bus().
  *
  * \threadsafe
  *
@@ -4664,10 +5012,14 @@ void
 sequence::set_midi_channel (midibyte ch, bool user_change)
 {
     automutex locker(m_mutex);
+    automutex playlocker(m_play_mutex); /* play() reads m_midi_channel      */
     off_playing_notes();
     if (ch != m_midi_channel)
     {
         m_midi_channel = ch;
+        if (m_thru)
+            update_thru_route();
+
         if (user_change)
             modify();                   /* no easy way to undo this, though */
     }
@@ -4707,13 +5059,19 @@ sequence::print_triggers () const
  * \param ev
  *      The event to put on the buss.
  *
+ * \param tick
+ *      The performance tick at which the event is due.  If a real tick, the
+ *      event is played with mastermidibase::play_at(), which schedules it in
+ *      the scheduled output mode.  The default, SEQ64_NULL_MIDIPULSE, plays
+ *      it directly.
+ *
  * \threadsafe
  */
 
 void
-sequence::put_event_on_bus (event & ev)
+sequence::put_event_on_bus (event & ev, midipulse tick)
 {
-    automutex locker(m_mutex);
+    automutex locker(m_play_mutex);
     midibyte note = ev.get_note();
     bool skip = false;
     if (ev.is_note_on())
@@ -4731,10 +5089,15 @@ sequence::put_event_on_bus (event & ev)
         /*
          * \change ca 2016-03-19
          *      Move the flush call into this condition; why flush() unless
-         *      actually playing an event?
+         *      actually playing an event?  During a perform::play() frame,
+         *      the flush is skipped, and done once at the end of the frame.
          */
 
-        m_masterbus->play(m_bus, &ev, m_midi_channel);
+        if (is_null_midipulse(tick))
+            m_masterbus->play(m_bus, &ev, m_midi_channel);
+        else
+            m_masterbus->play_at(m_bus, &ev, m_midi_channel, tick, number());
+
         m_masterbus->flush();
     }
 }
@@ -4743,13 +5106,23 @@ sequence::put_event_on_bus (event & ev)
  *  Sends a note-off event for all active notes.  This function does not
  *  bother checking if m_masterbus is a null pointer.
  *
+ *  In the scheduled output mode, events of this pattern may still be queued.
+ *  Normally, they are cancelled (except their Note Offs), and the Note Offs
+ *  are sent at once.  But when a trigger ends, the queued events are part
+ *  of the pattern's last frame, and play() sets m_off_tick so that the Note
+ *  Offs are queued at the end of the trigger instead.
+ *
  * \threadsafe
  */
 
 void
 sequence::off_playing_notes ()
 {
-    automutex locker(m_mutex);
+    automutex locker(m_play_mutex);
+    bool deferred = ! is_null_midipulse(m_off_tick);
+    if (! deferred)
+        m_masterbus->cancel_scheduled(number());
+
     event e;
     for (int x = 0; x < c_midi_notes; ++x)
     {
@@ -4757,7 +5130,16 @@ sequence::off_playing_notes ()
         {
             e.set_status(EVENT_NOTE_OFF);
             e.set_data(x, 0);
-            m_masterbus->play(m_bus, &e, m_midi_channel);
+            if (deferred)
+            {
+                m_masterbus->play_at
+                (
+                    m_bus, &e, m_midi_channel, m_off_tick, number()
+                );
+            }
+            else
+                m_masterbus->play(m_bus, &e, m_midi_channel);
+
             m_playing_notes[x]--;
         }
     }
@@ -4851,10 +5233,10 @@ sequence::transpose_notes (int steps, int scale)
 {
     if (mark_selected())                            /* mark original notes  */
     {
-        automutex locker(m_mutex);
-        event_list transposed_events;
+        editlock locker(*this);
+        event_list transposed_events(m_event_pool);  /* same pool to merge */
         const int * transpose_table;
-        m_events_undo.push(m_events);               /* push_undo(), no lock  */
+        save_undo();                                /* push_undo(), no lock  */
         if (steps < 0)
         {
             transpose_table = &c_scales_transpose_dn[scale][0];     /* down */
@@ -4902,9 +5284,9 @@ sequence::shift_notes (midipulse ticks)
 {
     if (mark_selected())
     {
-        automutex locker(m_mutex);
-        event_list shifted_events;
-        m_events_undo.push(m_events);               /* push_undo(), no lock  */
+        editlock locker(*this);
+        event_list shifted_events(m_event_pool);     /* same pool to merge */
+        save_undo();                                /* push_undo(), no lock  */
         for (event_list::iterator i = m_events.begin(); i != m_events.end(); ++i)
         {
             event & er = DREF(i);
@@ -4949,8 +5331,8 @@ sequence::apply_song_transpose ()
     int transpose = get_transposable() ? m_parent->get_transpose() : 0 ;
     if (transpose != 0)
     {
-        automutex locker(m_mutex);
-        m_events_undo.push(m_events);               /* push_undo(), no lock */
+        editlock locker(*this);
+        save_undo();                                /* push_undo(), no lock */
         for (event_list::iterator i = m_events.begin(); i != m_events.end(); ++i)
         {
             event & er = DREF(i);
@@ -5014,7 +5396,8 @@ sequence::quantize_events
     midipulse snap_tick, int divide, bool linked
 )
 {
-    automutex locker(m_mutex);
+    editlock locker(*this);
+    link_if_stale();
     if (mark_selected())
     {
         /*
@@ -5024,7 +5407,7 @@ sequence::quantize_events
          *      push_quantize() function!
          */
 
-        event_list quantized_events;
+        event_list quantized_events(m_event_pool);   /* same pool to merge */
         for (event_list::iterator i = m_events.begin(); i != m_events.end(); ++i)
         {
             event & er = DREF(i);
@@ -5136,8 +5519,8 @@ sequence::push_quantize
     midipulse snap_tick, int divide, bool linked
 )
 {
-    automutex locker(m_mutex);
-    m_events_undo.push(m_events);
+    editlock locker(*this);
+    save_undo();
     quantize_events(status, cc, snap_tick, divide, linked);
 }
 
@@ -5146,8 +5529,8 @@ sequence::push_quantize
 void
 sequence::multiply_pattern (double multiplier)
 {
-    automutex locker(m_mutex);
-    m_events_undo.push(m_events);               /* push_undo(), no lock */
+    editlock locker(*this);
+    save_undo();                                /* push_undo(), no lock */
     midipulse orig_length = get_length();
     midipulse new_length = midipulse(orig_length * multiplier);
     if (new_length > orig_length)
@@ -5222,7 +5605,7 @@ sequence::show_events () const
 void
 sequence::copy_events (const event_list & newevents)
 {
-    automutex locker(m_mutex);
+    editlock locker(*this);
     m_events.clear();
     m_events = newevents;
     if (m_events.empty())
@@ -5235,7 +5618,7 @@ sequence::copy_events (const event_list & newevents)
         // WTF?
     }
 
-    m_iterator_draw = m_events.begin();     /* same as in reset_draw_marker */
+    m_iterator_draw = m_events.cbegin();     /* same as in reset_draw_marker */
     if (! m_events.empty())                 /* need at least 1 (2?) events  */
     {
         /*
@@ -5284,17 +5667,95 @@ sequence::set_parent (perform * p)
  *
  * \param playbackmode
  *      Indicates if the playback is in live mode (false) or song mode (true).
+ *
+ * \param realtime
+ *      If true, the caller is the JACK process engine, which must not wait on
+ *      a lock.  If an editor holds the play mutex, the pattern is not played
+ *      now.  Since its last tick is then unchanged, the next call plays the
+ *      ticks that were missed, a cycle late, rather than losing them.  A
+ *      pending engine_seek() is done first.  The Note Offs of a queued
+ *      toggle go at the queued tick, rather than at the start of the cycle.
+ */
+
+void
+sequence::play_queue (midipulse tick, bool playbackmode, bool realtime)
+{
+    if (realtime)
+    {
+        if (m_play_mutex.try_lock())
+        {
+            apply_engine_seek();
+            if (check_queued_tick(tick))
+            {
+                midipulse qtick = get_queued_tick();
+                play(qtick - 1, playbackmode);
+                m_off_tick = qtick;
+                toggle_playing();
+                m_off_tick = SEQ64_NULL_MIDIPULSE;
+            }
+            play(tick, playbackmode);
+            m_play_mutex.unlock();
+        }
+    }
+    else
+    {
+        if (check_queued_tick(tick))
+        {
+            play(get_queued_tick() - 1, playbackmode);
+            toggle_playing();
+        }
+        play(tick, playbackmode);
+    }
+}
+
+/**
+ *  The form of stop() and set_last_tick() for the JACK process engine,
+ *  which uses it when playback starts or the song loops back.  If an editor
+ *  holds the play mutex, the change is kept, and done by the next real-time
+ *  play_queue(), before anything is played; a stop still pending is kept.
+ *  Called only by the engine.
+ *
+ * \param tick
+ *      The new last tick of the pattern.
+ *
+ * \param stop
+ *      If true, the pattern is stopped first (see stop()), which turns off
+ *      its playing notes.
+ *
+ * \param song_mode
+ *      Passed along to stop().
  */
 
 void
-sequence::play_queue (midipulse tick, bool playbackmode)
+sequence::engine_seek (midipulse tick, bool stop, bool song_mode)
 {
-    if (check_queued_tick(tick))
+    bool pending = ! is_null_midipulse(m_engine_seek_tick);
+    m_engine_seek_stop = stop || (pending && m_engine_seek_stop);  /* keep */
+    m_engine_seek_tick = tick;
+    m_engine_seek_song = song_mode;
+    if (m_play_mutex.try_lock())
     {
-        play(get_queued_tick() - 1, playbackmode);
-        toggle_playing();
+        apply_engine_seek();
+        m_play_mutex.unlock();
+    }
+}
+
+/**
+ *  Does the pending engine_seek(), if any.  The caller must hold
+ *  m_play_mutex.
+ */
+
+void
+sequence::apply_engine_seek ()
+{
+    if (! is_null_midipulse(m_engine_seek_tick))
+    {
+        if (m_engine_seek_stop)
+            stop(m_engine_seek_song);
+
+        set_last_tick(m_engine_seek_tick);
+        m_engine_seek_tick = SEQ64_NULL_MIDIPULSE;
     }
-    play(tick, playbackmode);
 }
 
 /**
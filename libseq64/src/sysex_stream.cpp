@@ -0,0 +1,296 @@
+/*
+ *  This file is part of seq24/sequencer64.
+ *
+ *  seq24 is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  seq24 is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with seq24; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          sysex_stream.cpp
+ *
+ *  This module defines the class that assembles incoming SysEx messages,
+ *  paces outgoing ones, and keeps statistics on both.
+ *
+ * \library       sequencer64 application
+ * \author        Chris Ahlstrom
+ * \date          2017-09-06
+ * \updates       2017-09-06
+ * \license       GNU GPLv2 or above
+ */
+
+#include <errno.h>                      /* EINTR                        */
+#include <stdio.h>                      /* printf()                     */
+#include <string.h>                     /* memset()                     */
+
+#include "app_limits.h"                 /* SEQ64_SYSEX_INPUT_MAX        */
+#include "event.hpp"                    /* EVENT_MIDI_SYSEX, etc.       */
+#include "sysex_stream.hpp"             /* seq64::sysex_stream          */
+
+/*
+ *  Do not document a namespace; it breaks Doxygen.
+ */
+
+namespace seq64
+{
+
+/**
+ *  Gets the microseconds from one time to a later one.
+ */
+
+static long
+elapsed_us (const struct timespec & earlier, const struct timespec & later)
+{
+    return (later.tv_sec - earlier.tv_sec) * 1000000L +
+        (later.tv_nsec - earlier.tv_nsec) / 1000L;
+}
+
+/**
+ *  Default constructor.  The arena takes no memory until the first
+ *  message arrives.
+ */
+
+sysex_stream::sysex_stream ()
+ :
+    m_arena         (),
+    m_receiving     (false),
+    m_truncated     (false),
+    m_start         (),
+    m_rate          (0),
+    m_stats         (),
+    m_mutex         ()
+{
+    memset(&m_stats, 0, sizeof m_stats);
+}
+
+/**
+ *  Tells if a piece of input belongs to a SysEx message.
+ *
+ * \param first
+ *      The first byte of the piece.
+ *
+ * \return
+ *      Returns true if the byte starts a message, or continues the message
+ *      being received.
+ */
+
+bool
+sysex_stream::accepts (midibyte first) const
+{
+    return first == EVENT_MIDI_SYSEX ||
+        (m_receiving && (first < 0x80 || first == EVENT_MIDI_SYSEX_END));
+}
+
+/**
+ *  Adds a piece of a SysEx message.  A piece that starts with 0xF0 starts a
+ *  new message; any message still being received is dropped.  The message
+ *  ends with 0xF7, or, if broken off, with any other status byte that is
+ *  not a real-time byte.  Real-time bytes are skipped.  Bytes that are not
+ *  kept are counted as dropped.
+ *
+ * \param data
+ *      The bytes of the piece.
+ *
+ * \param len
+ *      The number of bytes in the piece.
+ *
+ * \return
+ *      Returns true if the piece completed a message, which can then be
+ *      obtained via data() and size().
+ */
+
+bool
+sysex_stream::receive (const midibyte * data, int len)
+{
+    bool result = false;
+    long dropped = 0;
+    int i = 0;
+    if (len > 0 && data[0] == EVENT_MIDI_SYSEX)
+    {
+        if (m_receiving && ! m_truncated)
+            dropped += long(m_arena.size());    /* never ended; drop it */
+
+        m_arena.clear();
+        m_arena.push_back(data[0]);
+        m_receiving = true;
+        m_truncated = false;
+        i = 1;
+    }
+    for ( ; i < len && m_receiving; ++i)
+    {
+        midibyte b = data[i];
+        bool status = (b & 0x80) != 0;
+        if (status && b >= EVENT_MIDI_CLOCK)
+        {
+            /* a real-time byte, not part of the message */
+        }
+        else if (status && b != EVENT_MIDI_SYSEX_END)
+        {
+            if (! m_truncated)
+                dropped += long(m_arena.size());
+
+            m_receiving = false;                /* broken off, drop it  */
+            --i;                                /* the byte is not used */
+        }
+        else if (m_truncated)
+        {
+            ++dropped;
+        }
+        else if (int(m_arena.size()) >= SEQ64_SYSEX_INPUT_MAX)
+        {
+            dropped += long(m_arena.size()) + 1;
+            m_arena.clear();
+            m_truncated = true;
+        }
+        else
+            m_arena.push_back(b);
+
+        if (b == EVENT_MIDI_SYSEX_END)
+        {
+            m_receiving = false;
+            result = ! m_truncated;
+        }
+    }
+    dropped += long(len - i);                   /* not part of a message */
+
+    automutex locker(m_mutex);
+    m_stats.m_dropped_in += dropped;
+    if (result)
+    {
+        ++m_stats.m_messages_in;
+        m_stats.m_bytes_in += long(m_arena.size());
+    }
+    return result;
+}
+
+/**
+ *  Notes the start of sending a message.
+ *
+ * \param rate
+ *      The pacing rate, in bytes per second.  0 means no pacing.
+ */
+
+void
+sysex_stream::start_output (int rate)
+{
+    m_rate = rate;
+    clock_gettime(CLOCK_MONOTONIC, &m_start);
+}
+
+/**
+ *  Waits until the given number of bytes would have been sent at the pacing
+ *  rate, counting from the start of the message.  Returns at once if there
+ *  is no pacing, or if sending is already behind.
+ *
+ * \param bytes
+ *      The number of bytes of the message sent so far.
+ */
+
+void
+sysex_stream::pace (int bytes)
+{
+    if (m_rate > 0)
+    {
+        long long ns = (long long)(bytes) * 1000000000LL / m_rate;
+        struct timespec deadline = m_start;
+        deadline.tv_sec += time_t(ns / 1000000000LL);
+        deadline.tv_nsec += long(ns % 1000000000LL);
+        if (deadline.tv_nsec >= 1000000000L)
+        {
+            deadline.tv_nsec -= 1000000000L;
+            ++deadline.tv_sec;
+        }
+        while
+        (
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL)
+                == EINTR
+        )
+        {
+            /* interrupted by a signal, sleep again */
+        }
+    }
+}
+
+/**
+ *  Counts a message that has been sent, or partly sent.
+ *
+ * \param sent
+ *      The number of bytes sent.
+ *
+ * \param dropped
+ *      The number of bytes that could not be sent.
+ */
+
+void
+sysex_stream::end_output (int sent, int dropped)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    automutex locker(m_mutex);
+    if (sent > 0)
+        ++m_stats.m_messages_out;
+
+    m_stats.m_bytes_out += sent;
+    m_stats.m_dropped_out += dropped;
+    m_stats.m_us_out += elapsed_us(m_start, now);
+}
+
+/**
+ *  Gets a copy of the counts.
+ *
+ * \threadsafe
+ */
+
+sysex_statistics
+sysex_stream::statistics () const
+{
+    automutex locker(m_mutex);
+    return m_stats;
+}
+
+/**
+ *  Shows the counts, and the output throughput, if there has been any SysEx
+ *  traffic.
+ *
+ * \param name
+ *      The name of the buss, for the heading.
+ */
+
+void
+sysex_stream::print (const std::string & name) const
+{
+    sysex_statistics s = statistics();
+    if (s.m_messages_in > 0 || s.m_dropped_in > 0 || s.m_messages_out > 0)
+    {
+        long rate = s.m_us_out > 0 ?
+            long(double(s.m_bytes_out) * 1000000.0 / s.m_us_out) : 0 ;
+
+        printf
+        (
+            "%s SysEx: in %ld messages, %ld bytes, %ld dropped; "
+            "out %ld messages, %ld bytes, %ld dropped, %ld bytes/s\n",
+            name.c_str(), s.m_messages_in, s.m_bytes_in, s.m_dropped_in,
+            s.m_messages_out, s.m_bytes_out, s.m_dropped_out, rate
+        );
+    }
+}
+
+}           // namespace seq64
+
+/*
+ * sysex_stream.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
+
@@ -59,6 +59,7 @@
  */
 
 #include <stdlib.h>
+#include <algorithm>                    /* std::upper_bound()           */
 
 #include "sequence.hpp"                 /* the "parent" of the triggers */
 #include "settings.hpp"                 /* seq64::rc() settings access  */
@@ -82,11 +83,14 @@ namespace seq64
 triggers::triggers (sequence & parent)
  :
     m_parent                    (parent),
-    m_triggers                  (),
+    m_pool                      (std::make_shared<node_pool>()),
+    m_triggers                  (List::allocator_type(m_pool)),
     m_clipboard                 (),
-    m_undo_stack                (),
-    m_redo_stack                (),
-    m_iterator_play_trigger     (),
+    m_saved                     (List::allocator_type(m_pool)),
+    m_index                     (),
+    m_index_valid               (false),
+    m_play_cursor               (-1),
+    m_play_tick                 (SEQ64_NULL_MIDIPULSE),
     m_iterator_draw_trigger     (),
     m_trigger_copied            (false),
     m_paste_tick                (SEQ64_NO_PASTE_TRIGGER),   // stazed
@@ -132,11 +136,10 @@ triggers::operator = (const triggers & rhs)
 
         m_triggers = rhs.m_triggers;
         m_clipboard = rhs.m_clipboard;
-        m_undo_stack = rhs.m_undo_stack;
-        m_redo_stack = rhs.m_redo_stack;
-        m_iterator_play_trigger = rhs.m_iterator_play_trigger;
-        m_iterator_draw_trigger = rhs.m_iterator_draw_trigger;
+        m_saved = rhs.m_saved;
+        m_iterator_draw_trigger = m_triggers.begin();   /* not rhs's list! */
         m_trigger_copied = rhs.m_trigger_copied;
+        invalidate_index();
         
         /*
          * \new ca 2016-02-14
@@ -149,56 +152,205 @@ triggers::operator = (const triggers & rhs)
 }
 
 /**
- *  Pushes the list-trigger into the trigger undo-list, then flags each
- *  item in the undo-list as unselected.
+ *  Compares the triggers with the ones last saved, ignoring the selection
+ *  of the triggers.
+ *
+ * \return
+ *      Returns true if the lists hold the same triggers in the same order.
  */
 
-void
-triggers::push_undo ()                  // was push_trigger_undo ()
+bool
+triggers::same_as_saved () const
 {
-    m_undo_stack.push(m_triggers);
-    for
-    (
-        List::iterator i = m_undo_stack.top().begin();
-        i != m_undo_stack.top().end(); ++i
-    )
+    if (m_triggers.size() != m_saved.size())
+        return false;
+
+    List::const_iterator ib = m_saved.begin();
+    List::const_iterator ia = m_triggers.begin();
+    for ( ; ia != m_triggers.end(); ++ia, ++ib)
     {
-        i->selected(false);
+        if
+        (
+            ia->tick_start() != ib->tick_start() ||
+            ia->tick_end() != ib->tick_end() || ia->offset() != ib->offset()
+        )
+        {
+            return false;
+        }
     }
+    return true;
 }
 
 /**
- *  If the trigger undo-list has any items, the list-trigger is pushed
- *  into the redo list, the top of the undo-list is coped into the
- *  list-trigger, and then pops from the undo-list.
+ *  Saves the triggers for the trigger journal, if they changed since they
+ *  were last saved.  The saved copy is unselected, as the undo stack used
+ *  to be.
+ *
+ * \param [out] previous
+ *      Receives the triggers as they were last saved, if they changed.
+ *
+ * \return
+ *      Returns true if the triggers changed, and \a previous was set.
  */
 
-void
-triggers::pop_undo ()
+bool
+triggers::save (List & previous)
 {
-    if (m_undo_stack.size() > 0)
+    bool result = ! same_as_saved();
+    if (result)
     {
-        m_redo_stack.push(m_triggers);
-        m_triggers = m_undo_stack.top();
-        m_undo_stack.pop();
+        previous.swap(m_saved);
+        m_saved = m_triggers;
+        for (List::iterator i = m_saved.begin(); i != m_saved.end(); ++i)
+            i->selected(false);
     }
+    return result;
 }
 
 /**
- *  If the trigger redo-list has any items, the list-trigger is pushed
- *  into the undo list, the top of the redo-list is coped into the
- *  list-trigger, and then pops from the redo-list.
+ *  Replaces the triggers with a list from the trigger journal, for undo
+ *  or redo, and saves it.
+ *
+ * \param trigs
+ *      The triggers to put in place.
+ *
+ * \param [out] previous
+ *      Receives the triggers that were replaced, unselected, so that the
+ *      journal can reverse this change.
  */
 
 void
-triggers::pop_redo ()
+triggers::restore (const List & trigs, List & previous)
+{
+    previous = m_triggers;
+    for (List::iterator i = previous.begin(); i != previous.end(); ++i)
+        i->selected(false);
+
+    m_triggers = trigs;
+    m_saved = trigs;
+    invalidate_index();
+}
+
+/**
+ *  Marks the trigger index as out-of-date, so that the next lookup rebuilds
+ *  it.  Called by every function that changes the list.  Since a change
+ *  can add a trigger edge that is sooner than the output thread expects,
+ *  that thread is woken up (see perform::wake_output()).
+ */
+
+void
+triggers::invalidate_index ()
+{
+    m_index_valid = false;
+    m_parent.wake_output();
+}
+
+/**
+ *  Rebuilds the trigger index from the trigger list, and forces the next
+ *  playback lookup to do a binary search.
+ */
+
+void
+triggers::rebuild_index ()
+{
+    m_index.clear();
+    m_index.reserve(m_triggers.size());
+    for (List::iterator i = m_triggers.begin(); i != m_triggers.end(); ++i)
+        m_index.push_back(i);
+
+    m_index_valid = true;
+    m_play_cursor = -1;
+    m_play_tick = SEQ64_NULL_MIDIPULSE;
+}
+
+/**
+ *  Provides the comparison for the binary search done in find().  Compares
+ *  a tick to the start of the trigger pointed to by an index entry.
+ */
+
+static bool
+tick_before_trigger
+(
+    midipulse tick, std::list<trigger, pool_allocator<trigger> >::iterator t
+)
+{
+    return tick < t->tick_start();
+}
+
+/**
+ *  Does a binary search of the trigger index for the last trigger that
+ *  starts at or before the given tick.  The triggers are sorted by start
+ *  tick, and do not overlap (see add()), so this trigger is the only one
+ *  that can contain the tick.
+ *
+ * \param tick
+ *      Provides the tick to look up.
+ *
+ * \return
+ *      Returns the position of the trigger in the index, or -1 if there is
+ *      no trigger starting at or before the tick.
+ */
+
+int
+triggers::find (midipulse tick)
+{
+    if (! m_index_valid)
+        rebuild_index();
+
+    Index::iterator i = std::upper_bound
+    (
+        m_index.begin(), m_index.end(), tick, tick_before_trigger
+    );
+    return int(i - m_index.begin()) - 1;
+}
+
+/**
+ *  A version of find() for the playback thread, which asks about steadily
+ *  increasing ticks.  If the tick is not earlier than the previous one, the
+ *  cursor is stepped forward over the triggers that have started since then,
+ *  which is normally zero or one trigger.  If the step count gets too large
+ *  (a seek forward), or the tick is earlier (a seek backward), or the index
+ *  has been rebuilt, then a binary search is done.
+ *
+ * \param tick
+ *      Provides the tick to look up, normally the end tick of the frame.
+ *
+ * \return
+ *      Returns the position of the trigger in the index, or -1 if there is
+ *      no trigger starting at or before the tick.
+ */
+
+int
+triggers::find_play (midipulse tick)
 {
-    if (m_redo_stack.size() > 0)
+    static const int s_step_limit = 4;
+    if (! m_index_valid)
+        rebuild_index();
+
+    if (m_play_tick == SEQ64_NULL_MIDIPULSE || tick < m_play_tick)
     {
-        m_undo_stack.push(m_triggers);
-        m_triggers = m_redo_stack.top();
-        m_redo_stack.pop();
+        m_play_cursor = find(tick);
     }
+    else
+    {
+        int count = int(m_index.size());
+        int steps = 0;
+        while
+        (
+            m_play_cursor + 1 < count &&
+            m_index[m_play_cursor + 1]->tick_start() <= tick
+        )
+        {
+            if (++steps > s_step_limit)
+            {
+                m_play_cursor = find(tick);         /* a big jump forward   */
+                break;
+            }
+            ++m_play_cursor;
+        }
+    }
+    m_play_tick = tick;
+    return m_play_cursor;
 }
 
 /**
@@ -206,12 +358,15 @@ triggers::pop_redo ()
  *  and on/off triggers, this function handles that kind of playback.
  *  This is a new function for sequence::play() to call.
  *
- *  The for-loop goes through all the triggers, determining if there is are
- *  trigger start/end values before the \a end_tick.  If so, then the trigger
- *  state is set to true (start only within the tick range) or false (end is
- *  within the tick range), and the trigger tick is set to start or end.
- *  The first start or end trigger that is past the end tick cause the search
- *  to end.
+ *  The seq24 version of this function went through all the triggers from the
+ *  beginning of the list, determining if there were trigger start/end values
+ *  before the \a end_tick, on every output frame.  Since the triggers are
+ *  sorted and do not overlap, the result depends only on the last trigger
+ *  that starts at or before the end tick, which find_play() locates in
+ *  constant time (amortized) during normal playback.  If that trigger also
+ *  ends at or before the end tick, the trigger state is false, and the
+ *  trigger tick is its end; otherwise the state is true, and the trigger
+ *  tick is its start.
  *
  *  If the trigger state has changed, then the start/end ticks are passed back
  *  to the sequence, and the trigger offset is adjusted.
@@ -236,22 +391,21 @@ triggers::play (midipulse & start_tick, midipulse & end_tick)
     bool trigger_state = false;
     midipulse trigger_offset = 0;
     midipulse trigger_tick = 0;
-    for (List::iterator i = m_triggers.begin(); i != m_triggers.end(); ++i)
+    int t = find_play(end_tick);
+    if (t >= 0)
     {
-        if (i->tick_start() <= end_tick)
+        const trigger & trig = *m_index[t];
+        trigger_offset = trig.offset();
+        if (trig.tick_end() <= end_tick)
         {
-            trigger_state = true;
-            trigger_tick = i->tick_start();
-            trigger_offset = i->offset();
+            trigger_state = false;
+            trigger_tick = trig.tick_end();
         }
-        if (i->tick_end() <= end_tick)
+        else
         {
-            trigger_state = false;
-            trigger_tick = i->tick_end();
-            trigger_offset = i->offset();
+            trigger_state = true;
+            trigger_tick = trig.tick_start();
         }
-        if (i->tick_start() > end_tick || i->tick_end() > end_tick)
-            break;
     }
 
     /*
@@ -282,6 +436,33 @@ triggers::play (midipulse & start_tick, midipulse & end_tick)
     return result;
 }
 
+/**
+ *  Finds the first tick, at or after the given tick, at which play() would
+ *  see the trigger state change:  the end of the trigger that contains the
+ *  tick, or the start of the next trigger.  Does not move the playback
+ *  cursor.
+ *
+ * \param tick
+ *      Provides the tick from which to look.
+ *
+ * \return
+ *      Returns the tick of the next trigger edge, or SEQ64_NULL_MIDIPULSE if
+ *      there is none.
+ */
+
+midipulse
+triggers::next_edge (midipulse tick)
+{
+    midipulse result = SEQ64_NULL_MIDIPULSE;
+    int t = find(tick);
+    if (t >= 0 && m_index[t]->tick_end() >= tick)
+        result = m_index[t]->tick_end();
+    else if (t + 1 < int(m_index.size()))
+        result = m_index[t + 1]->tick_start();
+
+    return result;
+}
+
 /**
  *  Adjusts the given offset by mod'ing it with m_length and adding
  *  m_length if needed, and returning the result.
@@ -388,6 +569,7 @@ triggers::add
     }
     m_triggers.push_front(t);
     m_triggers.sort();                          /* hmmm, another sort       */
+    invalidate_index();
 }
 
 /**
@@ -485,6 +667,7 @@ triggers::remove (midipulse tick)
         if (i->tick_start() <= tick && tick <= i->tick_end())
         {
             m_triggers.erase(i);
+            invalidate_index();
             break;
         }
     }
@@ -511,6 +694,7 @@ triggers::split (trigger & trig, midipulse splittick)
     midipulse new_tick_end = trig.tick_end();
     midipulse new_tick_start = splittick;
     trig.tick_end(splittick - 1);
+    invalidate_index();
 
     midipulse len = new_tick_end - new_tick_start;
     if (len > 1)
@@ -678,6 +862,7 @@ triggers::copy (midipulse starttick, midipulse distance)
         }
     }
     m_triggers.sort();
+    invalidate_index();
 }
 
 /**
@@ -700,6 +885,7 @@ void
 triggers::move (midipulse starttick, midipulse distance, bool direction)
 {
     midipulse endtick = starttick + distance;
+    invalidate_index();
     for (List::iterator i = m_triggers.begin(); i != m_triggers.end(); ++i)
     {
         if (i->tick_start() < starttick && starttick < i->tick_end())
@@ -905,6 +1091,7 @@ triggers::move_selected (midipulse tick, bool fixoffset, grow_edit_t which)
                 s->increment_offset(deltatick);
                 s->offset(adjust_offset(s->offset()));
             }
+            invalidate_index();
             break;
         }
         else
@@ -933,7 +1120,9 @@ triggers::get_maximum ()
 
 /**
  *  Checks the list of triggers against the given tick.  If any
- *  trigger is found to bracket that tick, then true is returned.
+ *  trigger is found to bracket that tick, then true is returned.  Uses a
+ *  binary search of the trigger index, and leaves the playback cursor
+ *  alone.
  *
  * \param tick
  *      Provides the tick of interest.
@@ -945,16 +1134,8 @@ triggers::get_maximum ()
 bool
 triggers::get_state (midipulse tick)
 {
-    bool result = false;
-    for (List::iterator i = m_triggers.begin(); i != m_triggers.end(); ++i)
-    {
-        if (i->tick_start() <= tick && tick <= i->tick_end())
-        {
-            result = true;
-            break;
-        }
-    }
-    return result;
+    int t = find(tick);
+    return t >= 0 && tick <= m_index[t]->tick_end();
 }
 
 /**
@@ -1012,6 +1193,7 @@ triggers::remove_selected ()
         if (i->selected())
         {
             m_triggers.erase(i);
+            invalidate_index();
             break;
         }
     }
@@ -1078,6 +1260,38 @@ triggers::paste (midipulse paste_tick)
     }
 }
 
+/**
+ *  Sets the draw-trigger iterator to the first trigger that is not over by
+ *  the given tick, so that the song editor can skip the triggers that lie
+ *  before its visible area.  The default tick of 0 selects the beginning of
+ *  the trigger list.
+ *
+ * \param tick
+ *      Provides the first tick of interest.
+ */
+
+void
+triggers::reset_draw_trigger_marker (midipulse tick)
+{
+    if (tick <= 0)
+    {
+        m_iterator_draw_trigger = m_triggers.begin();
+    }
+    else
+    {
+        int t = find(tick);
+        if (t >= 0 && m_index[t]->tick_end() < tick)
+            ++t;                                    /* it ends too soon     */
+        else if (t < 0)
+            t = 0;
+
+        if (t < int(m_index.size()))
+            m_iterator_draw_trigger = m_index[t];
+        else
+            m_iterator_draw_trigger = m_triggers.end();
+    }
+}
+
 /**
  *  Get the next trigger in the trigger list, and set the parameters based
  *  on that trigger.
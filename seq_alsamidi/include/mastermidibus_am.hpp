@@ -82,6 +82,14 @@ private:
 
     struct pollfd * m_poll_descriptors;
 
+    /**
+     *  The ALSA MIDI parser used to decode all of the input events.  It is
+     *  made once, and reset before each event, rather than being made and
+     *  freed for every event.
+     */
+
+    snd_midi_event_t * m_decoder;
+
 public:
 
     mastermidibus
@@ -106,6 +114,9 @@ private:
     virtual void api_stop ();
     virtual void api_continue_from (midipulse tick);
     virtual void api_port_start (int client, int port);
+    virtual bool api_set_lookahead (int ms);
+    virtual midipulse api_queue_tick ();
+    virtual void api_cancel_scheduled (int tag);
 
     /*
      * Not implemented:
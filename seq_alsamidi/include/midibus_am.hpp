@@ -108,6 +108,14 @@ private:
 
     const std::string m_input_port_name;
 
+    /**
+     *  The ALSA MIDI encoder for the rare output events that are not
+     *  channel-voice messages.  Made once, with the buss, instead of for
+     *  every event.  Used only under the lock of the master buss.
+     */
+
+    snd_midi_event_t * m_encoder;
+
 public:
 
     /*
@@ -176,7 +184,11 @@ protected:
     virtual bool api_init_in_sub ();
     virtual bool api_deinit_in ();
     virtual void api_play (event * e24, midibyte channel);
-    virtual void api_sysex (event * e24);
+    virtual void api_play_at
+    (
+        event * e24, midibyte channel, midipulse tick, int tag
+    );
+    virtual bool api_sysex (const midibyte * data, int len);
     virtual void api_flush ();
     virtual void api_continue_from (midipulse tick, midipulse beats);
     virtual void api_start ();
@@ -186,6 +198,7 @@ protected:
 private:
 
     bool set_virtual_name (int portid, const std::string & portname);
+    void encode (event * e24, midibyte channel, snd_seq_event_t & ev);
 
 };          // class midibus (ALSA version)
 
@@ -93,6 +93,12 @@
 #define ALSA_CLIENT_CHECK(pinfo) \
     (snd_seq_client_id(m_alsa_seq) != snd_seq_port_info_get_client(pinfo))
 
+/**
+ *  The size of the buffer that an input event is decoded into.
+ */
+
+#define SEQ64_MIDI_DECODE_SIZE      0x1000
+
 /*
  *  Do not document a namespace; it breaks Doxygen.
  */
@@ -119,7 +125,8 @@ mastermidibus::mastermidibus (int ppqn, midibpm bpm)
     mastermidibase          (ppqn, bpm),
     m_alsa_seq              (nullptr),
     m_num_poll_descriptors  (0),
-    m_poll_descriptors      (nullptr)
+    m_poll_descriptors      (nullptr),
+    m_decoder               (nullptr)
 {
     /*
      * Open the sequencer client.  This line of code results in a loss of
@@ -150,6 +157,19 @@ mastermidibus::mastermidibus (int ppqn, midibpm bpm)
     snd_seq_set_client_name(m_alsa_seq, SEQ64_PACKAGE); /* "sequencer64"    */
     m_queue = snd_seq_alloc_queue(m_alsa_seq);          /* protected member */
 
+    /*
+     * Make the MIDI parser for the input events.  Running status is turned
+     * off, so that each decoded message starts with its status byte.
+     */
+
+    if (snd_midi_event_new(SEQ64_MIDI_DECODE_SIZE, &m_decoder) == 0)
+        snd_midi_event_no_status(m_decoder, 1);
+    else
+    {
+        m_decoder = nullptr;
+        errprint("snd_midi_event_new() error");
+    }
+
 #ifdef SEQ64_LASH_SUPPORT
 
     /*
@@ -193,6 +213,11 @@ mastermidibus::~mastermidibus ()
         delete [] m_poll_descriptors;
         m_poll_descriptors = nullptr;
     }
+    if (not_nullptr(m_decoder))
+    {
+        snd_midi_event_free(m_decoder);
+        m_decoder = nullptr;
+    }
 }
 
 /**
@@ -492,7 +517,79 @@ mastermidibus::api_flush ()
 }
 
 /**
- *  Initiate a poll() on the existing poll descriptors.
+ *  Prepares for the scheduled output mode.  The events are scheduled by tick
+ *  on our queue, so the queue must be running.  Its tempo and PPQN already
+ *  follow those of the performance (see api_set_beats_per_minute() and
+ *  api_set_ppqn()), and its tick position does not matter, since
+ *  mastermidibase::frame_start() measures the offset for each frame.
+ *
+ * \threadsafe
+ *
+ * \param ms
+ *      The look-ahead, unused here.
+ *
+ * \return
+ *      Always returns true; ALSA can schedule events.
+ */
+
+bool
+mastermidibus::api_set_lookahead (int /* ms */)
+{
+    snd_seq_start_queue(m_alsa_seq, m_queue, NULL);     /* start timer */
+    snd_seq_drain_output(m_alsa_seq);
+    return true;
+}
+
+/**
+ *  Gets the current tick of our ALSA queue.
+ *
+ * \threadsafe
+ *
+ * \return
+ *      Returns the tick time from the queue status.
+ */
+
+midipulse
+mastermidibus::api_queue_tick ()
+{
+    snd_seq_queue_status_t * status;
+    snd_seq_queue_status_alloca(&status);
+    snd_seq_get_queue_status(m_alsa_seq, m_queue, status);
+    return midipulse(snd_seq_queue_status_get_tick_time(status));
+}
+
+/**
+ *  Removes our pending output events from the ALSA queue (and from the
+ *  local output buffer), except the Note Offs.
+ *
+ * \threadsafe
+ *
+ * \param tag
+ *      The event tag of the pattern whose events are to be removed (see
+ *      mastermidibase::pattern_tag()).  If -1, all of our pending events
+ *      are removed.
+ */
+
+void
+mastermidibus::api_cancel_scheduled (int tag)
+{
+    unsigned condition = SND_SEQ_REMOVE_OUTPUT | SND_SEQ_REMOVE_IGNORE_OFF;
+    snd_seq_remove_events_t * remove;
+    snd_seq_remove_events_alloca(&remove);
+    if (tag >= 0)
+    {
+        condition |= SND_SEQ_REMOVE_TAG_MATCH;
+        snd_seq_remove_events_set_tag(remove, tag);
+    }
+    snd_seq_remove_events_set_condition(remove, condition);
+    snd_seq_remove_events_set_queue(remove, m_queue);
+    snd_seq_remove_events(m_alsa_seq, remove);
+}
+
+/**
+ *  Initiate a poll() on the existing poll descriptors.  The input thread
+ *  sleeps here until input arrives; the timeout only lets it check, once a
+ *  second, whether it is to exit.
  *
  *  No locking needed?
  *
@@ -615,7 +712,17 @@ mastermidibus::api_port_start (int bus, int port)
  *  not in force, then we check to see if the event is a port-start,
  *  port-exit, or port-change event, and we prcess it, and are done.
  *
- *  Otherwise, we create a "MIDI event parser" and decode the MIDI event.
+ *  Otherwise, we reset our "MIDI event parser" and decode the MIDI event.
+ *  The input ports are subscribed with real-time stamps (see
+ *  midibus::api_init_in()), so the time this event spent waiting, from its
+ *  arrival until now, when it is read, is passed along via set_input_age().
+ *  The real time of our queue is read for each event, since the events
+ *  read after one wakeup of the input thread are read at different times.
+ *
+ *  SysEx events are collected in m_sysex_in until a whole message has
+ *  arrived.  The input thread is never held waiting for the rest of a
+ *  message.  Note that two sources sending SysEx at the same time are not
+ *  kept apart.
  *
  * \threadsafe
  *
@@ -624,17 +731,16 @@ mastermidibus::api_port_start (int bus, int port)
  *
  * \return
  *      Returns true if a normal MIDI event was received, and false if either
- *      an ALSA MIDI Start, Change, or Exit event was received, or decoding
- *      the MIDI event failed.
+ *      an ALSA MIDI Start, Change, or Exit event was received, decoding
+ *      the MIDI event failed, or only part of a SysEx message arrived.
  */
 
 bool
 mastermidibus::api_get_midi_event (event * inev)
 {
     snd_seq_event_t * ev;
-    bool sysex = false;
     bool result = false;
-    midibyte buffer[0x1000];                /* temporary buffer for MIDI data */
+    midibyte buffer[SEQ64_MIDI_DECODE_SIZE];    /* buffer for the MIDI data */
     snd_seq_event_input(m_alsa_seq, &ev);
     if (! rc().manual_alsa_ports())
     {
@@ -664,60 +770,67 @@ mastermidibus::api_get_midi_event (event * inev)
     if (result)
         return false;
 
-    snd_midi_event_t * midi_ev;                     /* for ALSA MIDI parser  */
-    snd_midi_event_new(sizeof(buffer), &midi_ev);   /* make ALSA MIDI parser */
-    long bytes = snd_midi_event_decode(midi_ev, buffer, sizeof(buffer), ev);
-    if (bytes <= 0)                                 /* happens at startup    */
-        return false;
+    long age = 0;
+    if ((ev->flags & SND_SEQ_TIME_STAMP_MASK) == SND_SEQ_TIME_STAMP_REAL)
+    {
+        snd_seq_queue_status_t * status;
+        snd_seq_queue_status_alloca(&status);
+        snd_seq_get_queue_status(m_alsa_seq, m_queue, status);
 
-    inev->set_timestamp(ev->time.tick);
-    inev->set_status_keep_channel(buffer[0]);
+        const snd_seq_real_time_t * now =
+            snd_seq_queue_status_get_real_time(status);
+
+        age = long(now->tv_sec) - long(ev->time.time.tv_sec);
+        age = age * 1000000 +
+            (long(now->tv_nsec) - long(ev->time.time.tv_nsec)) / 1000;
+        inev->set_timestamp(0);
+    }
+    else
+        inev->set_timestamp(ev->time.tick);
+
+    set_input_age(age);
+    inev->restart_sysex();                          /* no stale SysEx        */
 
-    /**
-     *  We will only get EVENT_SYSEX on the first packet of MIDI data;
-     *  the rest we have to poll for.  SysEx processing is currently
-     *  disabled.
+    /*
+     *  ALSA delivers a long SysEx message as a series of SysEx events.  Their
+     *  bytes are collected by m_sysex_in, without the decoder, and an event
+     *  is returned only when the message is complete.
      */
 
-#ifdef USE_SYSEX_PROCESSING                    /* currently disabled           */
-    inev->set_sysex_size(bytes);
-    if (buffer[0] == EVENT_MIDI_SYSEX)
+    if (ev->type == SND_SEQ_EVENT_SYSEX)
     {
-        inev->restart_sysex();              /* set up for sysex if needed   */
-        sysex = inev->append_sysex(buffer, bytes);
+        const midibyte * data = static_cast<const midibyte *>(ev->data.ext.ptr);
+        result = m_sysex_in.receive(data, int(ev->data.ext.len));
+        if (result)
+        {
+            inev->set_status(EVENT_MIDI_SYSEX);
+            inev->set_sysex(m_sysex_in.data(), m_sysex_in.size());
+        }
+        return result;
     }
-    else
-    {
-#endif
-        /*
-         *  Some keyboards send Note On with velocity 0 for Note Off, so we
-         *  take care of that situation here by creating a Note Off event,
-         *  with the channel nybble preserved. Note that we call
-         *  event :: set_status_keep_channel() instead of using stazed's
-         *  set_status function with the "record" parameter.  A little more
-         *  confusing, but faster.
-         */
 
-        inev->set_data(buffer[1], buffer[2]);
-        if (inev->is_note_off_recorded())
-            inev->set_status_keep_channel(EVENT_NOTE_OFF);
+    if (is_nullptr(m_decoder))
+        return false;
 
-        sysex = false;
+    snd_midi_event_reset_decode(m_decoder);         /* forget prior message  */
+    long bytes = snd_midi_event_decode(m_decoder, buffer, sizeof(buffer), ev);
+    if (bytes <= 0)                                 /* happens at startup    */
+        return false;
 
-#ifdef USE_SYSEX_PROCESSING
-    }
-#endif
+    /*
+     *  Some keyboards send Note On with velocity 0 for Note Off, so we
+     *  take care of that situation here by creating a Note Off event,
+     *  with the channel nybble preserved. Note that we call
+     *  event :: set_status_keep_channel() instead of using stazed's
+     *  set_status function with the "record" parameter.  A little more
+     *  confusing, but faster.
+     */
+
+    inev->set_status_keep_channel(buffer[0]);
+    inev->set_data(buffer[1], buffer[2]);
+    if (inev->is_note_off_recorded())
+        inev->set_status_keep_channel(EVENT_NOTE_OFF);
 
-    while (sysex)       /* sysex messages might be more than one message */
-    {
-        snd_seq_event_input(m_alsa_seq, &ev);
-        long bytes = snd_midi_event_decode(midi_ev, buffer, sizeof(buffer), ev);
-        if (bytes > 0)
-            sysex = inev->append_sysex(buffer, bytes);
-        else
-            sysex = false;
-    }
-    snd_midi_event_free(midi_ev);
     return true;
 }
 
@@ -44,6 +44,14 @@
 namespace seq64
 {
 
+/**
+ *  Defines the size of the MIDI event buffer, which should be large enough to
+ *  accomodate the largest MIDI message to be encoded.
+ *  A local define for visibility.
+ */
+
+#define SEQ64_MIDI_EVENT_SIZE_MAX   10
+
 /**
  *  Creates a normal ALSA MIDI port, which will correspond to an existing
  *  system ALSA port, such as one provided by Timidity.  Provides a
@@ -123,9 +131,10 @@ midibus::midibus
     m_dest_addr_port    (destport),     // actually the port ID
     m_local_addr_client (localclient),
     m_local_addr_port   (-1),
-    m_input_port_name   (rc().app_client_name() + " in")
+    m_input_port_name   (rc().app_client_name() + " in"),
+    m_encoder           (nullptr)
 {
-    // Functionality moved into the base class
+    snd_midi_event_new(SEQ64_MIDI_EVENT_SIZE_MAX, &m_encoder);
 }
 
 /**
@@ -178,18 +187,20 @@ midibus::midibus
     m_dest_addr_port    (SEQ64_NO_PORT),
     m_local_addr_client (localclient),
     m_local_addr_port   (SEQ64_NO_PORT),
-    m_input_port_name   (rc().app_client_name() + " in")
+    m_input_port_name   (rc().app_client_name() + " in"),
+    m_encoder           (nullptr)
 {
-    // Functionality moved to the base class
+    snd_midi_event_new(SEQ64_MIDI_EVENT_SIZE_MAX, &m_encoder);
 }
 
 /**
- *  A rote empty destructor.
+ *  Frees the MIDI encoder.
  */
 
 midibus::~midibus()
 {
-    // empty body
+    if (not_nullptr(m_encoder))
+        snd_midi_event_free(m_encoder);
 }
 
 /**
@@ -273,11 +284,13 @@ midibus::api_init_in ()
     snd_seq_port_subscribe_set_dest(subs, &dest);       /* local              */
 
     /*
-     * Use the master queue, and get ticks, then subscribe.
+     * Use the master queue, and have each event stamped with the real time
+     * of the queue on arrival, then subscribe.
      */
 
     snd_seq_port_subscribe_set_queue(subs, queue_number());
     snd_seq_port_subscribe_set_time_update(subs, 1);
+    snd_seq_port_subscribe_set_time_real(subs, 1);
     result = snd_seq_subscribe_port(m_seq, subs);
     if (result < 0)
     {
@@ -426,7 +439,8 @@ midibus::api_deinit_in ()
     snd_seq_port_subscribe_set_dest(subs, &dest);
 
     snd_seq_port_subscribe_set_queue(subs, queue_number()); /* master queue */
-    snd_seq_port_subscribe_set_time_update(subs, 1);        /* get ticks    */
+    snd_seq_port_subscribe_set_time_update(subs, 1);        /* get stamps   */
+    snd_seq_port_subscribe_set_time_real(subs, 1);          /* real time    */
 
     int result = snd_seq_unsubscribe_port(m_seq, subs);     /* subscribe    */
     if (result < 0)
@@ -442,18 +456,87 @@ midibus::api_deinit_in ()
 }
 
 /**
- *  Defines the size of the MIDI event buffer, which should be large enough to
- *  accomodate the largest MIDI message to be encoded.
- *  A local define for visibility.
+ *  Fills in an ALSA sequencer event from a native event.  The channel-voice
+ *  messages, which are nearly all of the output, are built directly, with
+ *  the ALSA macros.  Anything else goes through the encoder of the buss.
+ *  Either way, nothing is allocated.
+ *
+ * \param e24
+ *      The event to be encoded.
+ *
+ * \param channel
+ *      The channel of the playback.
+ *
+ * \param ev
+ *      The ALSA event to fill in.  It is cleared first.
  */
 
-#define SEQ64_MIDI_EVENT_SIZE_MAX   10
+void
+midibus::encode (event * e24, midibyte channel, snd_seq_event_t & ev)
+{
+    midibyte d0, d1;
+    e24->get_data(d0, d1);
+    channel &= 0x0F;
+    snd_seq_ev_clear(&ev);                          /* clear event          */
+    switch (e24->get_status())
+    {
+    case EVENT_NOTE_OFF:
+        snd_seq_ev_set_noteoff(&ev, channel, d0, d1);
+        break;
+
+    case EVENT_NOTE_ON:
+        snd_seq_ev_set_noteon(&ev, channel, d0, d1);
+        break;
+
+    case EVENT_AFTERTOUCH:
+        snd_seq_ev_set_keypress(&ev, channel, d0, d1);
+        break;
+
+    case EVENT_CONTROL_CHANGE:
+        snd_seq_ev_set_controller(&ev, channel, d0, d1);
+        break;
+
+    case EVENT_PROGRAM_CHANGE:
+        snd_seq_ev_set_pgmchange(&ev, channel, d0);
+        break;
+
+    case EVENT_CHANNEL_PRESSURE:
+        snd_seq_ev_set_chanpress(&ev, channel, d0);
+        break;
+
+    case EVENT_PITCH_WHEEL:
+        snd_seq_ev_set_pitchbend
+        (
+            &ev, channel, ((int(d1) << 7) | int(d0)) - 0x2000
+        );
+        break;
+
+    default:
+        {
+            midibyte buffer[4];                     /* temp for MIDI data   */
+            buffer[0] = e24->get_status() + channel;
+            buffer[1] = d0;
+            buffer[2] = d1;
+            snd_midi_event_reset_encode(m_encoder);
+            snd_midi_event_encode(m_encoder, buffer, 3, &ev);
+        }
+        break;
+    }
+}
 
 /**
  *  This play() function takes a native event, encodes it to an ALSA MIDI
  *  sequencer event, sets the broadcasting to the subscribers, sets the
  *  direct-passing mode to send the event without queueing, and puts it in the
- *  queue.
+ *  output buffer of the client.  ALSA drains the buffer only when it is
+ *  full, or when api_flush() is called.  It used to make and free an ALSA
+ *  MIDI encoder for every event.
+ *
+ *  During playback, the events of the output thread are staged without the
+ *  master buss lock, and reach this function from
+ *  mastermidibase::batch_end(), once per frame, under one lock and followed
+ *  by one flush.  Events played by other threads come here at once, under
+ *  the master buss lock.
  *
  * \threadsafe
  *
@@ -468,18 +551,8 @@ midibus::api_deinit_in ()
 void
 midibus::api_play (event * e24, midibyte channel)
 {
-    midibyte buffer[4];                             /* temp for MIDI data   */
-    buffer[0] = e24->get_status();                  /* fill buffer          */
-    buffer[0] += (channel & 0x0F);
-    e24->get_data(buffer[1], buffer[2]);            /* set MIDI data        */
-
-    snd_midi_event_t * midi_ev;                     /* ALSA MIDI parser     */
-    snd_midi_event_new(SEQ64_MIDI_EVENT_SIZE_MAX, &midi_ev);
-
     snd_seq_event_t ev;
-    snd_seq_ev_clear(&ev);                          /* clear event          */
-    snd_midi_event_encode(midi_ev, buffer, 3, &ev); /* encode 3 raw bytes   */
-    snd_midi_event_free(midi_ev);                   /* free the parser      */
+    encode(e24, channel, ev);
     snd_seq_ev_set_source(&ev, m_local_addr_port);  /* set source           */
     snd_seq_ev_set_subs(&ev);
     snd_seq_ev_set_direct(&ev);                     /* it is immediate      */
@@ -487,41 +560,61 @@ midibus::api_play (event * e24, midibyte channel)
 }
 
 /**
- *  min() for long values.
+ *  The scheduled version of api_play().  Instead of sending the event
+ *  directly, it schedules it on our ALSA queue at the given tick, so that
+ *  the ALSA sequencer timer, not the wake-up of the output thread, decides
+ *  when it goes out.  The event is tagged, so that the pending events of a
+ *  pattern can be removed (see mastermidibus::api_cancel_scheduled()).
+ *  Scheduled events are not staged:  each comes here as it is played, under
+ *  the master buss lock, and the output buffer is drained at the end of the
+ *  frame.
  *
- * \param a
- *      First operand.
+ * \threadsafe
  *
- * \param b
- *      Second operand.
+ * \param e24
+ *      The event to be played on this bus.
  *
- * \return
- *      Returns the minimum value of a and b.
+ * \param channel
+ *      The channel of the playback.
+ *
+ * \param tick
+ *      The absolute tick of the ALSA queue at which to send the event.
+ *
+ * \param tag
+ *      The event tag lent to the pattern, from 0 to 255, so that it fits in
+ *      the ALSA tag (see mastermidibase::pattern_tag()).
  */
 
-inline long
-min (long a, long b)
+void
+midibus::api_play_at (event * e24, midibyte channel, midipulse tick, int tag)
 {
-    return (a < b) ? a : b ;
+    snd_seq_event_t ev;
+    encode(e24, channel, ev);
+    snd_seq_ev_set_source(&ev, m_local_addr_port);  /* set source           */
+    snd_seq_ev_set_subs(&ev);
+    snd_seq_ev_schedule_tick(&ev, m_queue, 0, snd_seq_tick_time_t(tick));
+    snd_seq_ev_set_tag(&ev, (unsigned char)(tag));
+    snd_seq_event_output(m_seq, &ev);               /* pump into the queue  */
 }
 
 /**
- *  Defines the value used for sleeping, in microseconds.  Defined locally
- *  simply for visibility.  Why 80000?
- */
-
-#define SEQ64_USLEEP_US     80000
-
-/**
- *  Takes a native SYSEX event, encodes it to an ALSA event, and then
- *  puts it in the queue.
+ *  Sends one piece of a SysEx message (see midibase::sysex()) as an ALSA
+ *  SysEx event, directly, not through the queue.  The sequencer handle is
+ *  blocking, so ALSA waits for room in its output pool, which throttles a
+ *  long dump to what the device can take.
  *
- * \param e24
- *      The event to be handled.
+ * \param data
+ *      The bytes of the piece.
+ *
+ * \param len
+ *      The number of bytes in the piece.
+ *
+ * \return
+ *      Returns true if ALSA took the piece.
  */
 
-void
-midibus::api_sysex (event * e24)
+bool
+midibus::api_sysex (const midibyte * data, int len)
 {
     snd_seq_event_t ev;
     snd_seq_ev_clear(&ev);                              /* clear event      */
@@ -529,31 +622,15 @@ midibus::api_sysex (event * e24)
     snd_seq_ev_set_source(&ev, m_local_addr_port);      /* set source       */
     snd_seq_ev_set_subs(&ev);
     snd_seq_ev_set_direct(&ev);                         /* it's immediate   */
+    snd_seq_ev_set_sysex(&ev, len, const_cast<midibyte *>(data));
 
-    /*
-     *  Replaced by a vector of midibytes:
-     *
-     *      midibyte * data = e24->get_sysex();
-     *
-     *  This is a bit tricky, and relies on the standard property of
-     *  std::vector where all n elements of the vector are guaranteed to be
-     *  stored contiguously (in order to be accessible via random-access
-     *  iterators).
-     */
-
-    event::SysexContainer & data = e24->get_sysex();
-    int data_size = e24->get_sysex_size();
-    for (int offset = 0; offset < data_size; offset += c_midibus_sysex_chunk)
+    bool result = snd_seq_event_output_direct(m_seq, &ev) >= 0;
+    if (! result)
     {
-        int data_left = data_size - offset;
-        snd_seq_ev_set_sysex
-        (
-            &ev, min(data_left, c_midibus_sysex_chunk), &data[offset]
-        );
-        snd_seq_event_output_direct(m_seq, &ev);        /* pump into queue  */
-        usleep(SEQ64_USLEEP_US);
-        flush();
+        errprint("SysEx output failed");
     }
+
+    return result;
 }
 
 /**
@@ -594,9 +594,10 @@ perfroll::draw_sequence_on (int seqnum)
     {
         midipulse tick_offset = m_4bar_offset;          //  * m_ticks_per_bar;
         midipulse x_offset = tick_offset / m_perf_scale_x;
+        midipulse tick_limit = tick_offset + m_window_x * m_perf_scale_x;
         m_sequence_active[seqnum] = true;
         sequence * seq = perf().get_sequence(seqnum);
-        seq->reset_draw_trigger_marker();
+        seq->reset_draw_trigger_marker(tick_offset);    /* skip unseen ones */
         seqnum -= m_sequence_offset;
 
         midipulse sequence_length = seq->get_length();
@@ -607,6 +608,9 @@ perfroll::draw_sequence_on (int seqnum)
         bool selected;
         while (seq->get_next_trigger(tick_on, tick_off, selected, offset))
         {
+            if (tick_on > tick_limit)
+                break;                                  /* past the window  */
+
             if (tick_off > 0)
             {
                 midipulse x_on  = tick_on  / m_perf_scale_x;
@@ -1650,10 +1650,11 @@ seqroll::button_press (GdkEventButton * ev)
                 if (eventcount == 0)                    /* no note? add one */
                 {
                     /*
-                     * Do we need push_undo() here?  Stazed does.
+                     * A chord is added as one edit:  one undo state, and
+                     * the output thread sees all of its notes at once.
                      */
 
-                    m_seq.push_undo();
+                    sequence::transaction t(m_seq);
                     add_note(tick_s, note_h);           /* also does chords */
                     needs_update = true;
                 }
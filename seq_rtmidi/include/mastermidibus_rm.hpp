@@ -121,6 +121,16 @@ protected:
         m_midi_master.api_port_start(masterbus, bus, port);
     }
 
+    /**
+     *  Provides MIDI API-specific functionality for the set_engine()
+     *  function.  Only JACK supports it.
+     */
+
+    virtual bool api_set_engine (engine_callback cb, void * arg)
+    {
+        return m_midi_master.api_set_engine(cb, arg);
+    }
+
 private:
 
     void port_list (const std::string & tag);
@@ -20,6 +20,7 @@
 #include "midi_info.hpp"                /* seq64::midi_port_info etc.   */
 #include "mastermidibus_rm.hpp"
 #include "midibus.hpp"                  /* seq64::midibus               */
+#include "sysex_stream.hpp"             /* seq64::sysex_stream          */
 
 /*
  * Do not document the namespace; it breaks Doxygen.
@@ -71,6 +72,12 @@ private:
 
     struct pollfd * m_poll_descriptors;
 
+    /**
+     *  Collects the pieces of incoming SysEx messages.
+     */
+
+    sysex_stream m_sysex_in;
+
 public:
 
     midi_alsa_info
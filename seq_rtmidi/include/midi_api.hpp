@@ -138,7 +138,28 @@ public:
     virtual int api_poll_for_midi () = 0;
 
     virtual void api_play (event * e24, midibyte channel) = 0;
-    virtual void api_sysex (event * e24) = 0;
+
+    /**
+     *  Plays the event directly.  Only midi_jack writes it at the given
+     *  frame of its process cycle, for the engine mode.
+     */
+
+    virtual void api_play_frame (event * e24, midibyte channel, int /*frame*/)
+    {
+        api_play(e24, channel);
+    }
+
+    /**
+     *  Plays the event now.  Only midi_jack stamps it with the frame at
+     *  which it was due, for the direct output mode.
+     */
+
+    virtual void api_play_due (event * e24, midibyte channel, long /*ago_us*/)
+    {
+        api_play(e24, channel);
+    }
+
+    virtual bool api_sysex (const midibyte * data, int len) = 0;
     virtual void api_continue_from (midipulse tick, midipulse beats) = 0;
     virtual void api_start () = 0;
     virtual void api_stop () = 0;
@@ -37,6 +37,7 @@
 
 #include "app_limits.h"                 /* SEQ64_DEFAULT_PPQN etc.  */
 #include "easy_macros.h"
+#include "midibus_common.hpp"           /* seq64::engine_callback   */
 #include "rterror.hpp"
 #include "rtmidi_types.hpp"
 
@@ -428,6 +429,19 @@ public:
         // Empty body
     }
 
+    /**
+     *  Used only in the midi_jack_info class, which can run the playback
+     *  engine in its process callback.
+     *
+     * \return
+     *      Returns false, as the engine mode is not supported by default.
+     */
+
+    virtual bool api_set_engine (engine_callback /* cb */, void * /* arg */)
+    {
+        return false;
+    }
+
     virtual bool api_get_midi_event (event * inev) = 0;
     virtual int api_poll_for_midi () = 0;
     virtual void api_flush () = 0;
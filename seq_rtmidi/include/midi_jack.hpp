@@ -180,6 +180,8 @@ protected:
 
 protected:
 
+    bool push_message (const char * data, int nbytes, long ago_us = 0);
+
     virtual bool open_client () = 0;    // replaces "connect()"
     virtual bool api_connect ();
     virtual bool api_init_out ();       // still in progress
@@ -211,7 +213,9 @@ protected:
     }
 
     virtual void api_play (event * e24, midibyte channel);
-    virtual void api_sysex (event * e24);
+    virtual void api_play_frame (event * e24, midibyte channel, int frame);
+    virtual void api_play_due (event * e24, midibyte channel, long ago_us);
+    virtual bool api_sysex (const midibyte * data, int len);
     virtual void api_flush ();
     virtual void api_continue_from (midipulse tick, midipulse beats);
     virtual void api_start ();
@@ -8,7 +8,7 @@
  *
  * \author        Chris Ahlstrom
  * \date          2017-01-02
- * \updates       2017-01-02
+ * \updates       2017-08-22
  * \license       See the rtexmidi.lic file.  Too big for a header file.
  *
  */
@@ -25,6 +25,33 @@
 namespace seq64
 {
 
+/**
+ *  Precedes each MIDI message written to the JACK output ring-buffers.  The
+ *  message bytes go into midi_jack_data::m_jack_buffmessage, and this header
+ *  goes into midi_jack_data::m_jack_buffsize, after the message bytes, so
+ *  that the process callback never sees a header without its message.
+ */
+
+struct midi_jack_header
+{
+    /**
+     *  The JACK frame time (jack_frame_time()) at which the message was due:
+     *  the time it was sent, less the time since its tick, if the caller
+     *  gave one (see midi_jack::api_play_due()).  The process callback plays
+     *  the message one period later, at the same frame offset within the
+     *  period, so that the spacing of the events is kept.
+     */
+
+    jack_nframes_t m_frame;
+
+    /**
+     *  The number of bytes in the message.
+     */
+
+    int m_size;
+
+};          // struct midi_jack_header
+
 /**
  *  Contains the JACK MIDI API data as a kind of scratchpad for this object.
  *  This guy needs a constructor taking parameters for an rtmidi_in_data
@@ -53,8 +80,9 @@ struct midi_jack_data
     jack_port_t * m_jack_port;
 
     /**
-     *  Holds the size of data for communicating between the client
-     *  ring-buffer and the JACK port's internal buffer.
+     *  Holds the midi_jack_header (size and send time) of each message
+     *  passed between the client ring-buffer and the JACK port's internal
+     *  buffer.
      */
 
     jack_ringbuffer_t * m_jack_buffsize;
@@ -73,6 +101,21 @@ struct midi_jack_data
 
     jack_time_t m_jack_lasttime;
 
+    /**
+     *  The JACK port buffer of the current process cycle, while the
+     *  playback engine runs in that cycle (see jack_process_io()).  Null at
+     *  other times.  Touched only by the JACK thread.
+     */
+
+    void * m_jack_cycle_buffer;
+
+    /**
+     *  The frame offset of the last event written to the port buffer in the
+     *  current cycle.  JACK needs the events of a buffer in frame order.
+     */
+
+    jack_nframes_t m_jack_last_offset;
+
     /**
      *  Holds special data peculiar to the client and its MIDI input
      *  processing.
@@ -90,6 +133,8 @@ struct midi_jack_data
         m_jack_buffsize     (nullptr),
         m_jack_buffmessage  (nullptr),
         m_jack_lasttime     (0),
+        m_jack_cycle_buffer (nullptr),
+        m_jack_last_offset  (0),
         m_jack_rtmidiin     (nullptr)
     {
         // Empty body
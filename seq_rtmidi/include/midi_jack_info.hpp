@@ -89,6 +89,20 @@ private:
 
     jack_client_t * m_jack_client_2;
 
+    /**
+     *  The function that runs the playback engine in each cycle of the JACK
+     *  process callback, and its argument.  Null unless the engine mode was
+     *  requested via api_set_engine().
+     */
+
+    engine_callback m_engine_callback;
+
+    /**
+     *  The argument passed to m_engine_callback.
+     */
+
+    void * m_engine_arg;
+
 public:
 
     midi_jack_info
@@ -127,6 +141,7 @@ public:
     virtual void api_set_beats_per_minute (midibpm b);
     virtual void api_port_start (mastermidibus & masterbus, int bus, int port);
     virtual void api_flush ();
+    virtual bool api_set_engine (engine_callback cb, void * arg);
 
 private:
 
@@ -115,6 +115,9 @@ protected:
     virtual void api_stop ();
     virtual void api_clock (midipulse tick);
     virtual void api_play (event * e24, midibyte channel);
+    virtual void api_play_frame (event * e24, midibyte channel, int frame);
+    virtual void api_play_due (event * e24, midibyte channel, long ago_us);
+    virtual bool api_sysex (const midibyte * data, int len);
 
 };          // class midibus (rtmidi version)
 
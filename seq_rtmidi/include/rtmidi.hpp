@@ -77,6 +77,16 @@ public:
         get_api()->api_play(e24, channel);
     }
 
+    virtual void api_play_frame (event * e24, midibyte channel, int frame)
+    {
+        get_api()->api_play_frame(e24, channel, frame);
+    }
+
+    virtual void api_play_due (event * e24, midibyte channel, long ago_us)
+    {
+        get_api()->api_play_due(e24, channel, ago_us);
+    }
+
     virtual void api_continue_from (midipulse tick, midipulse beats)
     {
         get_api()->api_continue_from(tick, beats);
@@ -142,9 +152,9 @@ public:
         return get_api()->api_poll_for_midi();
     }
 
-    virtual void api_sysex (event * e24)
+    virtual bool api_sysex (const midibyte * data, int len)
     {
-        get_api()->api_sysex(e24);
+        return get_api()->api_sysex(data, len);
     }
 
     virtual void api_flush ()
@@ -267,6 +267,11 @@ public:
         get_api_info()->api_flush();
     }
 
+    bool api_set_engine (engine_callback cb, void * arg)
+    {
+        return get_api_info()->api_set_engine(cb, arg);
+    }
+
     int api_poll_for_midi ()
     {
         return get_api_info()->api_poll_for_midi();
@@ -16,6 +16,7 @@
  *  refactor and partition, and slightly easier to read.
  */
 
+#include <atomic>                           /* std::atomic<>                */
 #include <string>                           /* std::string                  */
 #include <vector>                           /* std::vector container        */
 
@@ -75,6 +76,21 @@
 
 #define SEQ64_DEFAULT_QUEUE_SIZE    100
 
+/**
+ *  Default number of records in the MIDI input ring, and the default size of
+ *  its overflow area for messages too long to fit in a record.
+ */
+
+#define SEQ64_DEFAULT_RING_SIZE     1024
+#define SEQ64_DEFAULT_RING_OVERFLOW 0x10000
+
+/**
+ *  The longest message that fits in a midi_ring record.  All channel and
+ *  system-common messages fit.
+ */
+
+#define SEQ64_RING_RECORD_BYTES     4
+
 /*
  * Do not document the namespace; it breaks Doxygen.
  */
@@ -289,6 +305,126 @@ public:
 
 };
 
+/**
+ *  Provides a lock-free queue of incoming MIDI messages, for one producer
+ *  thread, the JACK process callback, and one consumer thread, the input
+ *  thread.  Unlike midi_queue, which copies a midi_message (and thus its
+ *  vector) for every message, all of the memory is taken up front, so that
+ *  the producer never allocates, locks, or blocks.
+ *
+ *  Each message takes a fixed-size record, holding its arrival time (a JACK
+ *  frame time) and, if it fits, the message itself.  The bytes of a longer
+ *  message, such as SysEx, go into a separate byte ring, the overflow area,
+ *  in the same order as the records.  If either the records or the overflow
+ *  area are full, the message is dropped and counted.
+ *
+ *  The two threads share only the record counters and the read position of
+ *  the overflow area.  The counters run freely and are reduced modulo the
+ *  size of the ring when used.
+ */
+
+class midi_ring
+{
+
+public:
+
+    /**
+     *  Holds one message, or the size of a message kept in the overflow
+     *  area.
+     */
+
+    struct record
+    {
+        unsigned m_frame;               /**< Frame time of arrival.         */
+        unsigned m_size;                /**< The number of message bytes.   */
+        midibyte m_bytes[SEQ64_RING_RECORD_BYTES]; /**< A short message.    */
+    };
+
+private:
+
+    /**
+     *  The records, allocated once by allocate().
+     */
+
+    std::vector<record> m_records;
+
+    /**
+     *  The overflow area for long messages, allocated once by allocate().
+     */
+
+    std::vector<midibyte> m_overflow;
+
+    /**
+     *  The number of records written.  Written by the producer only.
+     */
+
+    std::atomic<unsigned> m_head;
+
+    /**
+     *  The number of records read.  Written by the consumer only.
+     */
+
+    std::atomic<unsigned> m_tail;
+
+    /**
+     *  The number of overflow bytes written.  Used by the producer only.
+     */
+
+    unsigned m_overflow_head;
+
+    /**
+     *  The number of overflow bytes read.  Written by the consumer only.
+     */
+
+    std::atomic<unsigned> m_overflow_tail;
+
+    /**
+     *  The number of messages dropped because the ring was full.
+     */
+
+    std::atomic<unsigned> m_dropped;
+
+public:
+
+    midi_ring ();
+
+    void allocate
+    (
+        unsigned records  = SEQ64_DEFAULT_RING_SIZE,
+        unsigned overflow = SEQ64_DEFAULT_RING_OVERFLOW
+    );
+    bool push (unsigned frame, const midibyte * bytes, unsigned size);
+    bool front (record & r) const;
+    unsigned payload (unsigned offset, midibyte * dest, unsigned count) const;
+    void pop ();
+
+    /**
+     *  Gets the number of messages waiting.  Can be called from either
+     *  thread.
+     */
+
+    int count () const
+    {
+        return int(m_head.load(std::memory_order_acquire) -
+            m_tail.load(std::memory_order_acquire));
+    }
+
+    /**
+     * \getter m_dropped
+     */
+
+    unsigned dropped () const
+    {
+        return m_dropped.load(std::memory_order_relaxed);
+    }
+
+private:
+
+    midi_ring (const midi_ring &);                          /* no copying   */
+    midi_ring & operator = (const midi_ring &);
+
+};
+
 /**
  *  The rtmidi_in_data structure is used to pass private class data to the
  *  MIDI input handling function or thread.  Used to be nested in the
@@ -301,6 +437,7 @@ class rtmidi_in_data
 private:
 
     midi_queue m_queue;
+    midi_ring m_ring;
     midi_message m_message;
     midibyte m_ignore_flags;
     bool m_do_input;
@@ -333,6 +470,16 @@ public:
         return m_queue;
     }
 
+    /**
+     * \getter m_ring
+     *      Used instead of the queue by the JACK input callback.
+     */
+
+    midi_ring & ring ()
+    {
+        return m_ring;
+    }
+
     const midi_message & message () const
     {
         return m_message;
@@ -308,6 +308,10 @@ mastermidibus::api_is_more_input ()
 /**
  *  Grab a MIDI event.  For the ALSA implementation, this call
  *
+ *  For JACK, the input buss gives the time the event waited, in
+ *  microseconds, as its input age (see midi_in_jack::api_get_midi_event()),
+ *  which is passed along via set_input_age().
+ *
  * \threadsafe
  */
 
@@ -316,7 +320,12 @@ mastermidibus::api_get_midi_event (event * inev)
 {
     if (m_use_jack_polling)
     {
-        return m_inbus_array.get_midi_event(inev);
+        long age = 0;
+        bool result = m_inbus_array.get_midi_event(inev, &age);
+        if (result)
+            set_input_age(age);
+
+        return result;
     }
     else
     {
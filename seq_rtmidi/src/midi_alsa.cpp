@@ -586,41 +586,23 @@ midi_alsa::api_play (event * e24, midibyte channel)
 }
 
 /**
- *  min() for long values.
+ *  Sends one piece of a SysEx message (see midibase::sysex()) as an ALSA
+ *  SysEx event, directly, not through the queue.  The sequencer handle is
+ *  blocking, so ALSA waits for room in its output pool, which throttles a
+ *  long dump to what the device can take.
  *
- * \param a
- *      First operand.
+ * \param data
+ *      The bytes of the piece.
  *
- * \param b
- *      Second operand.
+ * \param len
+ *      The number of bytes in the piece.
  *
  * \return
- *      Returns the minimum value of a and b.
+ *      Returns true if ALSA took the piece.
  */
 
-inline long
-min (long a, long b)
-{
-    return (a < b) ? a : b ;
-}
-
-/**
- *  Defines the value used for sleeping, in microseconds.  Defined locally
- *  simply for visibility.  Why 80000?
- */
-
-#define SEQ64_USLEEP_US     80000
-
-/**
- *  Takes a native SYSEX event, encodes it to an ALSA event, and then
- *  puts it in the queue.
- *
- * \param e24
- *      The event to be handled.
- */
-
-void
-midi_alsa::api_sysex (event * e24)
+bool
+midi_alsa::api_sysex (const midibyte * data, int len)
 {
     snd_seq_event_t ev;
     snd_seq_ev_clear(&ev);                              /* clear event      */
@@ -628,31 +610,15 @@ midi_alsa::api_sysex (event * e24)
     snd_seq_ev_set_source(&ev, m_local_addr_port);      /* set source       */
     snd_seq_ev_set_subs(&ev);
     snd_seq_ev_set_direct(&ev);                         /* it's immediate   */
+    snd_seq_ev_set_sysex(&ev, len, const_cast<midibyte *>(data));
 
-    /*
-     *  Replaced by a vector of midibytes:
-     *
-     *      midibyte * data = e24->get_sysex();
-     *
-     *  This is a bit tricky, and relies on the standard property of
-     *  std::vector where all n elements of the vector are guaranteed to be
-     *  stored contiguously (in order to be accessible via random-access
-     *  iterators).
-     *
-     *  256 == c_midi_alsa_sysex_chunk
-     */
-
-    const int chunk = 256;
-    event::SysexContainer & data = e24->get_sysex();
-    int data_size = e24->get_sysex_size();
-    for (int offset = 0; offset < data_size; offset += chunk)
+    bool result = snd_seq_event_output_direct(m_seq, &ev) >= 0;
+    if (! result)
     {
-        int data_left = data_size - offset;
-        snd_seq_ev_set_sysex(&ev, min(data_left, chunk), &data[offset]);
-        snd_seq_event_output_direct(m_seq, &ev);        /* pump into queue  */
-        usleep(SEQ64_USLEEP_US);
-        api_flush();
+        errprint("SysEx output failed");
     }
+
+    return result;
 }
 
 /**
@@ -88,7 +88,8 @@ midi_alsa_info::midi_alsa_info
     midi_info               (appname, ppqn, bpm),
     m_alsa_seq              (nullptr),
     m_num_poll_descriptors  (0),            /* from ALSA mastermidibus      */
-    m_poll_descriptors      (nullptr)       /* ditto                        */
+    m_poll_descriptors      (nullptr),      /* ditto                        */
+    m_sysex_in              ()
 {
     snd_seq_t * seq;                        /* point to member              */
     int result = snd_seq_open               /* set up ALSA sequencer client */
@@ -479,15 +480,14 @@ midi_alsa_info::api_port_start (mastermidibus & masterbus, int bus, int port)
  * \return
  *      This function returns false if we are not using virtual/manual ports
  *      and the event is an ALSA port-start, port-exit, or port-change event.
- *      It also returns false if there is no event to decode.  Otherwise, it
- *      returns true.
+ *      It also returns false if there is no event to decode, or if only part
+ *      of a SysEx message has arrived.  Otherwise, it returns true.
  */
 
 bool
 midi_alsa_info::api_get_midi_event (event * inev)
 {
     snd_seq_event_t * ev;
-    bool sysex = false;
     bool result = false;
     midibyte buffer[0x1000];                /* temporary buffer for MIDI data */
     int remcount = snd_seq_event_input(m_alsa_seq, &ev);
@@ -538,6 +538,26 @@ midi_alsa_info::api_get_midi_event (event * inev)
     if (result)
         return false;
 
+    /*
+     *  ALSA delivers a long SysEx message as a series of SysEx events.  Their
+     *  bytes are collected by m_sysex_in, and an event is returned only when
+     *  the message is complete.
+     */
+
+    inev->set_timestamp(ev->time.tick);
+    inev->restart_sysex();                          /* no stale SysEx        */
+    if (ev->type == SND_SEQ_EVENT_SYSEX)
+    {
+        const midibyte * data = static_cast<const midibyte *>(ev->data.ext.ptr);
+        result = m_sysex_in.receive(data, int(ev->data.ext.len));
+        if (result)
+        {
+            inev->set_status(EVENT_MIDI_SYSEX);
+            inev->set_sysex(m_sysex_in.data(), m_sysex_in.size());
+        }
+        return result;
+    }
+
     snd_midi_event_t * midi_ev;                     /* make ALSA MIDI parser */
     int rc = snd_midi_event_new(sizeof(buffer), &midi_ev);
     if (rc < 0 || is_nullptr(midi_ev))
@@ -547,67 +567,33 @@ midi_alsa_info::api_get_midi_event (event * inev)
     }
 
     long bytes = snd_midi_event_decode(midi_ev, buffer, sizeof(buffer), ev);
+    snd_midi_event_free(midi_ev);
     if (bytes <= 0)
     {
         /*
          * This happens even at startup, before anything is really happening.
          */
 
-        snd_midi_event_free(midi_ev);
         return false;
     }
 
-    inev->set_timestamp(ev->time.tick);
-    inev->set_status_keep_channel(buffer[0]);
-
-    /**
-     *  We will only get EVENT_SYSEX on the first packet of MIDI data;
-     *  the rest we have to poll for.  SysEx processing is currently
-     *  disabled.
+    /*
+     *  Some keyboards send Note On with velocity 0 for Note Off, so we
+     *  take care of that situation here by creating a Note Off event,
+     *  with the channel nybble preserved. Note that we call
+     *  event::set_status_keep_channel() instead of using stazed's
+     *  set_status function with the "record" parameter.  We do need to
+     *  mask in the actual channel number!
      */
 
-#ifdef USE_SYSEX_PROCESSING                    /* currently disabled           */
-    inev->set_sysex_size(bytes);
-    if (buffer[0] == EVENT_MIDI_SYSEX)
-    {
-        inev->restart_sysex();              /* set up for sysex if needed   */
-        sysex = inev->append_sysex(buffer, bytes);
-    }
-    else
-    {
-#endif
-        /*
-         *  Some keyboards send Note On with velocity 0 for Note Off, so we
-         *  take care of that situation here by creating a Note Off event,
-         *  with the channel nybble preserved. Note that we call
-         *  event::set_status_keep_channel() instead of using stazed's
-         *  set_status function with the "record" parameter.  We do need to
-         *  mask in the actual channel number!
-         */
-
-        inev->set_data(buffer[1], buffer[2]);
-        if (inev->is_note_off_recorded())
-        {
-            midibyte channel = buffer[0] & EVENT_GET_CHAN_MASK;
-            midibyte status = EVENT_NOTE_OFF | channel;
-            inev->set_status_keep_channel(status);
-        }
-        sysex = false;
-
-#ifdef USE_SYSEX_PROCESSING
-    }
-#endif
-
-    while (sysex)       /* sysex messages might be more than one message */
+    inev->set_status_keep_channel(buffer[0]);
+    inev->set_data(buffer[1], buffer[2]);
+    if (inev->is_note_off_recorded())
     {
-        snd_seq_event_input(m_alsa_seq, &ev);
-        long bytes = snd_midi_event_decode(midi_ev, buffer, sizeof(buffer), ev);
-        if (bytes > 0)
-            sysex = inev->append_sysex(buffer, bytes);
-        else
-            sysex = false;
+        midibyte channel = buffer[0] & EVENT_GET_CHAN_MASK;
+        midibyte status = EVENT_NOTE_OFF | channel;
+        inev->set_status_keep_channel(status);
     }
-    snd_midi_event_free(midi_ev);
     return true;
 }
 
@@ -145,6 +145,7 @@
 #include "midibus_rm.hpp"               /* seq64::midibus for rtmidi        */
 #include "midi_jack.hpp"                /* seq64::midi_jack                 */
 #include "settings.hpp"                 /* seq64::rc() accessor function    */
+#include "sysex_stream.hpp"             /* seq64::sysex_stream              */
 
 /**
  *  Delimits the size of the JACK ringbuffer.
@@ -152,6 +153,13 @@
 
 #define JACK_RINGBUFFER_SIZE 16384      /* default size for ringbuffer  */
 
+/**
+ *  The number of bytes of a long input message copied out of the input ring
+ *  at a time, on the stack, to be added to the SysEx arena.
+ */
+
+#define SEQ64_JACK_SYSEX_PIECE  256
+
 /*
  * Do not document the namespace; it breaks Doxygen.
  */
@@ -159,6 +167,20 @@
 namespace seq64
 {
 
+/*
+ * The two halves of jack_process_rtmidi_output(), also used separately by
+ * jack_process_io() in midi_jack_info.cpp.
+ */
+
+void * jack_begin_rtmidi_output
+(
+    jack_nframes_t nframes, midi_jack_data * jackdata
+);
+void jack_drain_rtmidi_output
+(
+    jack_nframes_t nframes, void * buf, midi_jack_data * jackdata
+);
+
 /**
  *  Defines the JACK input process callback.  It is the JACK process callback
  *  for a MIDI output port (e.g. "system:midi_capture_1", which gives us the
@@ -172,17 +194,17 @@ namespace seq64
  *
  *      -#  Get the JACK port buffer and the MIDI event-count into this
  *          buffer.
- *      -#  For each MIDI event, get the event from JACK and push it into a
- *          local midi_message object.
- *      -#  Get the event time, converting it to a delta time if possible.
+ *      -#  For each MIDI event, get the event from JACK, and its frame time:
+ *          the frame time of the start of the cycle plus its offset.
  *      -#  If it is not a SysEx continuation, then:
- *          -#  If we're using a callback, pass the data to that callback.  Do
- *              we need this callback to interface with the midibus-based
- *              code?
- *          -#  Otherwise, add the midi_message container to the rtmidi input
- *              queue.  One can then grab this data in a midibase ::
- *              poll_for_midi() call.  We still ought to check the add
- *              success.
+ *          -#  If we're using a callback, copy the event to a midi_message
+ *              and pass it to that callback.  Do we need this callback to
+ *              interface with the midibus-based code?
+ *          -#  Otherwise, add the event bytes and frame time to the rtmidi
+ *              input ring.  One can then grab this data in a midibase ::
+ *              poll_for_midi() call.  The ring is allocated beforehand and is
+ *              lock-free, so nothing here allocates or blocks; if the ring is
+ *              full, the event is dropped and counted.
  *
  *  The ALSA code polls for events, and that model is also available here.
  *  We're still working exactly how it will work best.
@@ -237,41 +259,34 @@ jack_process_rtmidi_input (jack_nframes_t nframes, void * arg)
     if (not_nullptr(buff))
     {
         jack_midi_event_t jmevent;
-        jack_time_t jtime;
+        jack_nframes_t cycle = not_nullptr(jackdata->m_jack_client) ?
+            jack_last_frame_time(jackdata->m_jack_client) : 0 ;
+
         int evcount = jack_midi_get_event_count(buff);
         for (int j = 0; j < evcount; ++j)
         {
-            midi_message message;
             int rc = jack_midi_event_get(&jmevent, buff, j);
             if (rc == 0)
             {
-                int eventsize = int(jmevent.size);
-                for (int i = 0; i < eventsize; ++i)
-                    message.push(jmevent.buffer[i]);
-
-                jtime = jack_get_time();            /* compute delta time   */
-                if (rtindata->first_message())
-                {
-                    rtindata->first_message(false);
-                }
-                else
-                {
-                    message.timestamp
-                    (
-                        (jtime - jackdata->m_jack_lasttime) * 0.000001
-                    );
-                }
-                jackdata->m_jack_lasttime = jtime;
                 if (! rtindata->continue_sysex())
                 {
                     if (rtindata->using_callback())
                     {
+                        midi_message message;
+                        int eventsize = int(jmevent.size);
+                        for (int i = 0; i < eventsize; ++i)
+                            message.push(jmevent.buffer[i]);
+
                         rtmidi_callback_t callback = rtindata->user_callback();
                         callback(message, rtindata->user_data());
                     }
                     else
                     {
-                        (void) rtindata->queue().add(message);
+                        (void) rtindata->ring().push
+                        (
+                            unsigned(cycle + jmevent.time),
+                            jmevent.buffer, unsigned(jmevent.size)
+                        );
                     }
                 }
             }
@@ -299,22 +314,33 @@ jack_process_rtmidi_input (jack_nframes_t nframes, void * arg)
  *  qjackctl.  Here's how it works:
  *
  *      -#  Get the JACK port buffer, for our local jack port.  Clear it.
- *      -#  Loop while the number of bytes available for reading [via
- *          jack_ringbuffer_read_space()] is non-zero.  Note that the second
- *          parameter is where the data is copied.
- *      -#  Get the size of each event, and allocate space for an event to be
- *          written to an event port buffer (the JACK "reserve" function).
+ *      -#  Loop while a midi_jack_header is available for reading [via
+ *          jack_ringbuffer_read_space()].  Peek at the header, to get the
+ *          size of the message and the frame time at which it was due.
+ *      -#  Convert the frame time to a frame offset in this period.  A
+ *          message is played one period after it was due, so that it
+ *          keeps its place relative to the other messages.  If it belongs
+ *          to a later period, leave it (and the messages after it) in the
+ *          ringbuffer for the next call.
+ *      -#  Allocate space for the event in the event port buffer (the JACK
+ *          "reserve" function), at that frame offset.
  *      -#  Read the data from the ringbuffer into this port buffer.  JACK
  *          should then send it to the remote port.
  *
  *  Since this is an output port, "buff" is the area to which we can write
  *  data, to send it to the "remote" (i.e. outside our application) port.  The
- *  data is written to the ringbuffer in api_init_out(), and here we read the
+ *  data is written to the ringbuffer in push_message(), and here we read the
  *  ring buffer and pass it to the output buffer.
  *
- *  We were wondering if, like the JACK midiseq example program, we need to
- *  wrap out process in a for-loop over the number of frames.  In our tests,
- *  we are getting 1024 frames, and the code seems to work without that loop.
+ *  A large message (a piece of a SysEx dump) that does not fit in the rest
+ *  of the port buffer is held, along with the messages after it, for the
+ *  next period.
+ *
+ *  JACK refuses events that are not in frame-offset order.  Messages are
+ *  sent from more than one thread (e.g. the output thread and the GUI), so
+ *  the due times are not strictly increasing, and an offset is never
+ *  allowed to be less than the previous one.  A message that is late (e.g.
+ *  after an xrun) is played at the start of the period.
  *
  * \param nframes
  *    The frame number to be processed.
@@ -329,8 +355,32 @@ jack_process_rtmidi_input (jack_nframes_t nframes, void * arg)
 int
 jack_process_rtmidi_output (jack_nframes_t nframes, void * arg)
 {
-    static bool s_null_detected = false;
     midi_jack_data * jackdata = reinterpret_cast<midi_jack_data *>(arg);
+    void * buf = jack_begin_rtmidi_output(nframes, jackdata);
+    if (not_nullptr(buf))
+        jack_drain_rtmidi_output(nframes, buf, jackdata);
+
+    return 0;
+}
+
+/**
+ *  The first half of jack_process_rtmidi_output().  Gets the JACK port
+ *  buffer of an output port for this cycle, and clears it.
+ *
+ * \param nframes
+ *    The number of frames in the cycle.
+ *
+ * \param jackdata
+ *    The JACK data of the output port.
+ *
+ * \return
+ *    Returns the port buffer, or a null pointer if the port is not set up.
+ */
+
+void *
+jack_begin_rtmidi_output (jack_nframes_t nframes, midi_jack_data * jackdata)
+{
+    static bool s_null_detected = false;
     if (is_nullptr(jackdata->m_jack_port))          /* is port created?     */
     {
         if (! s_null_detected)
@@ -338,7 +388,7 @@ jack_process_rtmidi_output (jack_nframes_t nframes, void * arg)
             s_null_detected = true;
             apiprint("jack_process_rtmidi_output", "null jack port");
         }
-        return 0;
+        return nullptr;
     }
     if (is_nullptr(jackdata->m_jack_buffsize))      /* port set up?        */
     {
@@ -347,10 +397,9 @@ jack_process_rtmidi_output (jack_nframes_t nframes, void * arg)
             s_null_detected = true;
             apiprint("jack_process_rtmidi_output", "null jack buffer");
         }
-        return 0;
+        return nullptr;
     }
 
-    static size_t soffset = 0;
     void * buf = jack_port_get_buffer(jackdata->m_jack_port, nframes);
 
 #ifdef SEQ64_SHOW_API_CALLS_TMI
@@ -362,30 +411,91 @@ jack_process_rtmidi_output (jack_nframes_t nframes, void * arg)
 #endif
 
     jack_midi_clear_buffer(buf);
+    jackdata->m_jack_last_offset = 0;
+    return buf;
+}
 
-    /*
-     * A for-loop over the number of nframes?  See discussion above.
-     */
+/**
+ *  The second half of jack_process_rtmidi_output().  Moves the messages
+ *  that are due in this cycle from the ring-buffers to the port buffer.
+ *  Offsets start at the last one used in the cycle, so that messages come
+ *  after any events the process engine has already written.
+ *
+ * \param nframes
+ *    The number of frames in the cycle.
+ *
+ * \param buf
+ *    The port buffer, from jack_begin_rtmidi_output().
+ *
+ * \param jackdata
+ *    The JACK data of the output port.
+ */
+
+void
+jack_drain_rtmidi_output
+(
+    jack_nframes_t nframes, void * buf, midi_jack_data * jackdata
+)
+{
+    bool timed = not_nullptr(jackdata->m_jack_client);
+    jack_nframes_t cyclestart = timed ?
+        jack_last_frame_time(jackdata->m_jack_client) : 0 ;
 
-    while (jack_ringbuffer_read_space(jackdata->m_jack_buffsize) > 0)
+    jack_nframes_t lastoffset = jackdata->m_jack_last_offset;
+    midi_jack_header header;
+    while
+    (
+        jack_ringbuffer_read_space(jackdata->m_jack_buffsize) >= sizeof header
+    )
     {
-        int space;
-        (void) jack_ringbuffer_read
+        (void) jack_ringbuffer_peek
         (
-            jackdata->m_jack_buffsize, (char *) &space, sizeof space
+            jackdata->m_jack_buffsize, (char *) &header, sizeof header
         );
-        jack_midi_data_t * md = jack_midi_event_reserve(buf, soffset, space);
+
+        /*
+         * The difference is taken as signed, so that the wrap-around of the
+         * JACK frame time does no harm.
+         */
+
+        int32_t offset = timed ?
+            int32_t(header.m_frame + nframes - cyclestart) : 0 ;
+
+        if (offset >= int32_t(nframes))
+            break;                              /* for a later period   */
+
+        /*
+         * A SysEx piece that does not fit in what is left of the port
+         * buffer waits for the next period, unless the buffer is empty, in
+         * which case it can never fit, and is dropped below.
+         */
+
+        if
+        (
+            size_t(header.m_size) > jack_midi_max_event_size(buf) &&
+            jack_midi_get_event_count(buf) > 0
+        )
+        {
+            break;
+        }
+        jack_ringbuffer_read_advance(jackdata->m_jack_buffsize, sizeof header);
+        if (offset < int32_t(lastoffset))
+            offset = int32_t(lastoffset);       /* late, or out of order */
+
+        lastoffset = jack_nframes_t(offset);
+        size_t space = size_t(header.m_size);
+        jack_midi_data_t * md = jack_midi_event_reserve(buf, lastoffset, space);
         if (not_nullptr(md))
         {
             char * mididata = reinterpret_cast<char *>(md);
             (void) jack_ringbuffer_read         /* copy into mididata */
             (
-                jackdata->m_jack_buffmessage, mididata, size_t(space)
+                jackdata->m_jack_buffmessage, mididata, space
             );
 
 #ifdef SEQ64_SHOW_API_CALLS_TMI
-            printf("%d bytes read: ", space);
-            for (int i = 0; i < space; ++i)
+            printf("%d bytes read at %d: ", int(space), int(lastoffset));
+            for (int i = 0; i < int(space); ++i)
                 printf("%x ", (unsigned char)(mididata[i]));
 
             printf("\n");
@@ -393,10 +503,11 @@ jack_process_rtmidi_output (jack_nframes_t nframes, void * arg)
         }
         else
         {
+            jack_ringbuffer_read_advance(jackdata->m_jack_buffmessage, space);
             errprint("jack_midi_event_reserve() returned a null pointer");
         }
     }
-    return 0;
+    jackdata->m_jack_last_offset = lastoffset;
 }
 
 /*
@@ -801,59 +912,138 @@ midi_jack::api_deinit_in ()
 }
 
 /**
- *  We could push the bytes of the event into a midibyte vector, as done in
- *  send_message().  The ALSA code (seq_alsamidi/src/midibus.cpp) sticks the
- *  event bytes in an array, which might be a little faster than using
- *  push_back(), but let's try the vector first.  The rtmidi code here is from
- *  midi_out_jack::send_message().
+ *  Plays an event now.  See api_play_due().
  */
 
 void
 midi_jack::api_play (event * e24, midibyte channel)
 {
-    midibyte status = e24->get_status() + (channel & 0x0F);
+    api_play_due(e24, channel, 0);
+}
+
+/**
+ *  Writes the bytes of the event into a small array, as the ALSA code
+ *  (seq_alsamidi/src/midibus.cpp) does, rather than into a midi_message,
+ *  to avoid allocating a vector for every event, and passes them to
+ *  push_message(), along with the time since the event was due.  Thus the
+ *  message is stamped with the frame of its tick, and the wakeup jitter of
+ *  the output thread does not carry over into the JACK output.
+ *
+ * \param e24
+ *      The event to play.
+ *
+ * \param channel
+ *      The channel on which to play the event.
+ *
+ * \param ago_us
+ *      How long before now the event was due, in microseconds.
+ */
+
+void
+midi_jack::api_play_due (event * e24, midibyte channel, long ago_us)
+{
+    midibyte buffer[3];
     midibyte d0, d1;
     e24->get_data(d0, d1);
+    buffer[0] = e24->get_status() + (channel & 0x0F);
+    buffer[1] = d0;
+    buffer[2] = d1;
 
-    midi_message message;
-    message.push(status);
-    message.push(d0);
-    if (e24->is_two_bytes())                    /* \change ca 2017-04-26 */
-        message.push(d1);
+    int nbytes = e24->is_two_bytes() ? 3 : 2 ;  /* \change ca 2017-04-26 */
 
 #ifdef SEQ64_SHOW_API_CALLS_TMI
     printf("midi_jack::play()\n");
 #endif
 
-    int nbytes = message.count();               /* send_message(message) */
-    if (nbytes > 0 && m_jack_data.valid_buffer())
+    if (! push_message(reinterpret_cast<const char *>(buffer), nbytes, ago_us))
     {
-        int count1 = jack_ringbuffer_write
-        (
-            m_jack_data.m_jack_buffmessage,
-            message.array(),                    /* (const char *) &m[0] */
-            message.count()
-        );
-        int count2 = jack_ringbuffer_write
-        (
-            m_jack_data.m_jack_buffsize, (char *) &nbytes, sizeof nbytes
-        );
-        if ((count1 <= 0) || (count2 <= 0))
+        errprint("JACK api_play failed");
+    }
+}
+
+/**
+ *  Writes an event straight into the JACK port buffer at the given frame.
+ *  Used by the playback engine, which runs in the JACK process callback
+ *  (see jack_process_io()), and passes the events of a cycle in frame
+ *  order.  Outside of such a cycle, the event is played with api_play().
+ *  A system real-time event, such as the MIDI clock, is one byte, with no
+ *  channel.
+ *
+ * \param e24
+ *      The event to write.
+ *
+ * \param channel
+ *      The channel on which to play the event.
+ *
+ * \param frame
+ *      The frame offset in the current cycle.
+ */
+
+void
+midi_jack::api_play_frame (event * e24, midibyte channel, int frame)
+{
+    void * buf = m_jack_data.m_jack_cycle_buffer;
+    if (not_nullptr(buf))
+    {
+        midibyte buffer[3];
+        midibyte d0, d1;
+        size_t nbytes = 1;
+        e24->get_data(d0, d1);
+        buffer[0] = e24->get_status();
+        buffer[1] = d0;
+        buffer[2] = d1;
+        if (buffer[0] < EVENT_MIDI_CLOCK)       /* not system real-time     */
         {
-            errprint("JACK api_play failed");
+            buffer[0] += channel & 0x0F;
+            nbytes = e24->is_two_bytes() ? 3 : 2 ;
         }
+
+        jack_nframes_t offset = jack_nframes_t(frame);
+        if (offset < m_jack_data.m_jack_last_offset)
+            offset = m_jack_data.m_jack_last_offset;
+
+        if (jack_midi_event_write(buf, offset, buffer, nbytes) == 0)
+            m_jack_data.m_jack_last_offset = offset;
     }
+    else
+        api_play(e24, channel);
 }
 
 /**
- * \todo
- *      Flesh out this routine.
+ *  Sends one piece of a SysEx message (see midibase::sysex()) as a JACK
+ *  MIDI event.  If the output ring-buffers are full, this function waits for
+ *  the process callback to drain them, a millisecond at a time, for up to a
+ *  second, so that a long dump is throttled to what JACK can take.
+ *
+ * \param data
+ *      The bytes of the piece.
+ *
+ * \param len
+ *      The number of bytes in the piece.
+ *
+ * \return
+ *      Returns true if the piece was queued.
  */
 
-void
-midi_jack::api_sysex (event * /* e24 */)
+bool
+midi_jack::api_sysex (const midibyte * data, int len)
 {
-    // Will put this one off until later....
+    const char * bytes = reinterpret_cast<const char *>(data);
+    bool result = push_message(bytes, len);
+    for (int ms = 0; ! result && ms < 1000; ++ms)
+    {
+        if (! m_jack_data.valid_buffer())
+            break;
+
+        millisleep(1);
+        result = push_message(bytes, len);
+    }
+    if (! result)
+    {
+        errprint("JACK SysEx output failed");
+    }
+
+    return result;
 }
 
 /**
@@ -975,29 +1165,15 @@ midi_jack::api_clock (midipulse tick)
 void
 midi_jack::send_byte (midibyte evbyte, midipulse tick)
 {
-    midi_message message;
-    message.push(evbyte);
-    int nbytes = 1;
-
     if (is_null_midipulse(tick))
     {
         // TODO
     }
 
-    if (m_jack_data.valid_buffer())
+    char byte = char(evbyte);
+    if (m_jack_data.valid_buffer() && ! push_message(&byte, 1))
     {
-        int count1 = jack_ringbuffer_write
-        (
-            m_jack_data.m_jack_buffmessage, message.array(), 1
-        );
-        int count2 = jack_ringbuffer_write
-        (
-            m_jack_data.m_jack_buffsize, (char *) &nbytes, sizeof nbytes
-        );
-        if ((count1 <= 0) || (count2 <= 0))
-        {
-            errprint("JACK send_byte() failed");
-        }
+        errprint("JACK send_byte() failed");
     }
 }
 
@@ -1390,6 +1566,72 @@ midi_jack::create_ringbuffer (size_t rbsize)
     return result;
 }
 
+/**
+ *  Writes a MIDI message to the JACK output ring-buffers, first the message
+ *  bytes and then its midi_jack_header, which is stamped with the JACK
+ *  frame time at which the message was due:  the current frame time, less
+ *  the given delay.  jack_process_rtmidi_output() uses that time to place
+ *  the message at the proper frame within the JACK period.
+ *
+ *  Nothing is written unless both ring-buffers have room for the whole
+ *  message, so that a full buffer cannot leave a header without its bytes.
+ *
+ * \param data
+ *      Provides the bytes of the message.
+ *
+ * \param nbytes
+ *      Provides the number of bytes in the message.
+ *
+ * \param ago_us
+ *      How long before now the message was due, in microseconds.  The
+ *      default is 0, for a message that is due now.
+ *
+ * \return
+ *      Returns true if the message was written.
+ */
+
+bool
+midi_jack::push_message (const char * data, int nbytes, long ago_us)
+{
+    bool result = nbytes > 0 && m_jack_data.valid_buffer();
+    if (result)
+    {
+        midi_jack_header header;
+        header.m_size = nbytes;
+        header.m_frame = 0;
+        if (not_nullptr(client_handle()))
+        {
+            header.m_frame = jack_frame_time(client_handle());
+            if (ago_us > 0)
+            {
+                double rate = double(jack_get_sample_rate(client_handle()));
+                header.m_frame -= jack_nframes_t(ago_us * rate / 1000000.0);
+            }
+        }
+
+        result =
+        (
+            jack_ringbuffer_write_space(m_jack_data.m_jack_buffmessage) >=
+                size_t(nbytes) &&
+            jack_ringbuffer_write_space(m_jack_data.m_jack_buffsize) >=
+                sizeof header
+        );
+        if (result)
+        {
+            (void) jack_ringbuffer_write
+            (
+                m_jack_data.m_jack_buffmessage, data, size_t(nbytes)
+            );
+            (void) jack_ringbuffer_write
+            (
+                m_jack_data.m_jack_buffsize, (const char *) &header,
+                sizeof header
+            );
+        }
+    }
+    return result;
+}
+
 /*
  * MIDI JACK input class.
  */
@@ -1425,15 +1667,15 @@ midi_in_jack::midi_in_jack (midibus & parentbus, midi_info & masterinfo)
      */
 
     m_jack_data.m_jack_rtmidiin = input_data();
+    input_data()->ring().allocate();            /* before the port exists   */
 }
 
 /**
- *  Checks the rtmidi_in_data queue for the number of items in the queue.
- *
- *  WE MAY NEED LOCKING.
+ *  Checks the rtmidi_in_data ring for the number of messages in it.  No
+ *  locking is needed; the ring is safe for one reader and one writer.
  *
  * \return
- *      Returns the value of rtindata->queue().count(), unless the caller is
+ *      Returns the value of rtindata->ring().count(), unless the caller is
  *      using an rtmidi callback function, in which case 0 is always returned.
  */
 
@@ -1449,13 +1691,23 @@ midi_in_jack::api_poll_for_midi ()
     else
     {
         millisleep(1);
-        return rtindata->queue().count();
+        return rtindata->ring().count();
     }
 }
 
 /**
- *  Gets a MIDI event.  This implementation gets a midi_message off the front
- *  of the queue and converts it to a Sequencer64 event.
+ *  Gets a MIDI event.  This implementation takes the oldest message out of
+ *  the ring and converts it to a Sequencer64 event.
+ *
+ *  The input age of the parent buss (midibase::set_input_age()) is set to
+ *  the time the message waited, in microseconds, from its arrival in a JACK
+ *  cycle until now, measured in frames.  The rtmidi mastermidibus hands it
+ *  on to mastermidibase::set_input_age(), which converts it to ticks for
+ *  the input thread.  The timestamp of the event is left alone.
+ *
+ *  SysEx bytes are collected by the buss's sysex_stream, and no event is
+ *  returned until a whole message has arrived.  JACK can deliver a long
+ *  message in more than one event.
  *
  * \param inev
  *      Provides the destination for the MIDI event.
@@ -1469,15 +1721,61 @@ bool
 midi_in_jack::api_get_midi_event (event * inev)
 {
     rtmidi_in_data * rtindata = m_jack_data.m_jack_rtmidiin;
-    bool result = ! rtindata->queue().empty();
+    midi_ring::record mm;
+    bool result = rtindata->ring().front(mm);
     if (result)
     {
-        midi_message mm = rtindata->queue().pop_front();
-        inev->set_timestamp(mm.timestamp());
-        if (mm.count() == 3)
+        long age = 0;
+        if (not_nullptr(client_handle()))
+        {
+            jack_nframes_t frames = jack_frame_time(client_handle()) -
+                jack_nframes_t(mm.m_frame);
+
+            jack_nframes_t rate = jack_get_sample_rate(client_handle());
+            if (rate > 0 && frames < rate)          /* ignore wild values   */
+                age = long(uint64_t(frames) * 1000000 / rate);
+        }
+        parent_bus().set_input_age(age);
+        inev->restart_sysex();                      /* no stale SysEx       */
+
+        /*
+         *  Bytes that belong to a SysEx message are handed to the buss's
+         *  sysex_stream, a piece at a time if the message is long, and an
+         *  event is returned only when the message is complete.
+         */
+
+        midibyte buffer[SEQ64_JACK_SYSEX_PIECE];
+        const midibyte * bytes = mm.m_bytes;
+        unsigned count = mm.m_size;
+        if (count > SEQ64_RING_RECORD_BYTES)
         {
-            inev->set_status_keep_channel(mm[0]);
-            inev->set_data(mm[1], mm[2]);
+            count = rtindata->ring().payload(0, buffer, sizeof buffer);
+            bytes = buffer;
+        }
+
+        sysex_stream & sx = parent_bus().sysex_io();
+        if (count > 0 && sx.accepts(bytes[0]))
+        {
+            bool complete = false;
+            unsigned offset = 0;
+            while (count > 0)
+            {
+                complete = sx.receive(bytes, int(count));
+                offset += count;
+                count = rtindata->ring().payload(offset, buffer, sizeof buffer);
+                bytes = buffer;
+            }
+            result = complete;
+            if (complete)
+            {
+                inev->set_status(EVENT_MIDI_SYSEX);
+                inev->set_sysex(sx.data(), sx.size());
+            }
+        }
+        else if (count == 3)
+        {
+            inev->set_status_keep_channel(bytes[0]);
+            inev->set_data(bytes[1], bytes[2]);
 
             /*
              *  Some keyboards send Note On with velocity 0 for Note Off, so
@@ -1490,37 +1788,25 @@ midi_in_jack::api_get_midi_event (event * inev)
 
             if (inev->is_note_off_recorded())
             {
-                midibyte channel = mm[0] & EVENT_GET_CHAN_MASK;
+                midibyte channel = bytes[0] & EVENT_GET_CHAN_MASK;
                 midibyte status = EVENT_NOTE_OFF | channel;
                 inev->set_status_keep_channel(status);
             }
         }
-        else if (mm.count() == 2)
+        else if (count == 2)
         {
-            inev->set_status_keep_channel(mm[0]);
-            inev->set_data(mm[1]);
+            inev->set_status_keep_channel(bytes[0]);
+            inev->set_data(bytes[1]);
         }
-        else
+        else if (count == 1)
         {
-            infoprint("SysEx information encountered?");
-
-#ifdef USE_SYSEX_PROCESSING                 /* currently disabled           */
-
-            /**
-             *  We will only get EVENT_SYSEX on the first packet of MIDI data;
-             *  the rest we have to poll for.  SysEx processing is currently
-             *  disabled.  The code that follows has a big bug!
-             */
-
-            midibyte buffer[0x1000];        /* temporary buffer for Sysex   */
-            inev->set_sysex_size(bytes);
-            if (buffer[0] == EVENT_MIDI_SYSEX)
-            {
-                inev->restart_sysex();      /* set up for sysex if needed   */
-                sysex = inev->append_sysex(buffer, bytes);
-            }
-#endif
+            inev->set_status_keep_channel(bytes[0]);
+            inev->set_data(0, 0);
         }
+        else
+            result = false;                         /* not a MIDI message   */
+
+        rtindata->ring().pop();
     }
     return result;
 }
@@ -1576,8 +1862,8 @@ midi_out_jack::~midi_out_jack ()
 }
 
 /**
- *  Sends a JACK MIDI output message.  It writes the full message size and
- *  the message itself to the JACK ring buffer.
+ *  Sends a JACK MIDI output message.  It writes the message itself and its
+ *  header (size and send time) to the JACK ring buffers.
  *
  * \param message
  *      Provides the MIDI message object, which contains the bytes to send.
@@ -1590,17 +1876,8 @@ midi_out_jack::~midi_out_jack ()
 bool
 midi_out_jack::send_message (const midi_message & message)
 {
-    int nbytes = message.count();
-    int count1 = jack_ringbuffer_write
-    (
-        m_jack_data.m_jack_buffmessage, message.array(), message.count()
-    );
-    int count2 = jack_ringbuffer_write
-    (
-        m_jack_data.m_jack_buffsize, (char *) &nbytes, sizeof(nbytes)
-    );
     apiprint("send_message", "jack");
-    return (count1 > 0) && (count2 > 0);
+    return push_message(message.array(), message.count());
 }
 
 }           // namespace seq64
@@ -52,6 +52,14 @@ namespace seq64
 
 extern int jack_process_rtmidi_input (jack_nframes_t nframes, void * arg);
 extern int jack_process_rtmidi_output (jack_nframes_t nframes, void * arg);
+extern void * jack_begin_rtmidi_output
+(
+    jack_nframes_t nframes, midi_jack_data * jackdata
+);
+extern void jack_drain_rtmidi_output
+(
+    jack_nframes_t nframes, void * buf, midi_jack_data * jackdata
+);
 
 /**
  *  Provides a JACK callback function that uses the callbacks defined in the
@@ -59,6 +67,12 @@ extern int jack_process_rtmidi_output (jack_nframes_t nframes, void * arg);
  *  the output callback, depending on the port type.  This may lead to
  *  delays, depending on the size of the JACK MIDI buffer.
  *
+ *  If the playback engine runs in this callback (see api_set_engine()), the
+ *  output port buffers are cleared first, and made available to the ports
+ *  while the engine function renders the cycle and writes its events into
+ *  them.  Then the messages from the other threads, in the ring-buffers of
+ *  the ports, are added after those events.
+ *
  * \param nframes
  *      The frame number from the JACK API.
  *
@@ -82,6 +96,7 @@ jack_process_io (jack_nframes_t nframes, void * arg)
              * appropriately.
              */
 
+            bool engine = not_nullptr(self->m_engine_callback);
             std::vector<midi_jack *>::iterator mi;
             for
             (
@@ -95,11 +110,37 @@ jack_process_io (jack_nframes_t nframes, void * arg)
                 {
                     (void) jack_process_rtmidi_input(nframes, mjp);
                 }
+                else if (engine)
+                {
+                    mjp->m_jack_cycle_buffer =
+                        jack_begin_rtmidi_output(nframes, mjp);
+                }
                 else
                 {
                     (void) jack_process_rtmidi_output(nframes, mjp);
                 }
             }
+            if (engine)
+            {
+                int rate = int(jack_get_sample_rate(self->m_jack_client));
+                self->m_engine_callback(self->m_engine_arg, int(nframes), rate);
+                for
+                (
+                    mi = self->m_jack_ports.begin();
+                    mi != self->m_jack_ports.end(); ++mi
+                )
+                {
+                    midi_jack_data * mjp = &(*mi)->jack_data();
+                    if (not_nullptr(mjp->m_jack_cycle_buffer))
+                    {
+                        jack_drain_rtmidi_output
+                        (
+                            nframes, mjp->m_jack_cycle_buffer, mjp
+                        );
+                        mjp->m_jack_cycle_buffer = nullptr;
+                    }
+                }
+            }
         }
     }
     return 0;
@@ -131,7 +172,9 @@ midi_jack_info::midi_jack_info
     m_multi_client          (SEQ64_RTMIDI_NO_MULTICLIENT),
     m_jack_ports            (),
     m_jack_client           (nullptr),              /* inited for connect() */
-    m_jack_client_2         (nullptr)
+    m_jack_client_2         (nullptr),
+    m_engine_callback       (nullptr),
+    m_engine_arg            (nullptr)
 {
     silence_jack_info();
     m_jack_client = connect();
@@ -435,6 +478,33 @@ midi_jack_info::api_flush ()
     // No code yet
 }
 
+/**
+ *  Makes jack_process_io() run the playback engine in each JACK cycle.
+ *  Must be called before the JACK client is activated.  Not supported in
+ *  the multi-client mode, where each port has its own process callback.
+ *
+ * \param cb
+ *      The function to call in each cycle.
+ *
+ * \param arg
+ *      The value to pass to that function.
+ *
+ * \return
+ *      Returns true if the engine will be run.
+ */
+
+bool
+midi_jack_info::api_set_engine (engine_callback cb, void * arg)
+{
+    bool result = not_nullptr(m_jack_client) && ! multi_client();
+    if (result)
+    {
+        m_engine_arg = arg;
+        m_engine_callback = cb;
+    }
+    return result;
+}
+
 /**
  *  Sets up all of the ports, represented by midibus objects, that have
  *  been created.
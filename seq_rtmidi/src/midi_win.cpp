@@ -415,10 +415,10 @@ midi_win::api_play (event * e24, midibyte channel)
  *      Flesh out this routine.
  */
 
-void
-midi_win::api_sysex (event * /* e24 */)
+bool
+midi_win::api_sysex (const midibyte * /* data */, int /* len */)
 {
-    // Will put this one off until later....
+    return false;   // Will put this one off until later....
 }
 
 /**
@@ -377,6 +377,65 @@ midibus::api_play (event * e24, midibyte channel)
     m_rt_midi->api_play(e24, channel);
 }
 
+/**
+ *  Writes an event at a frame of the current process cycle, for the engine
+ *  mode.  Forwarded like api_play().
+ *
+ * \param e24
+ *      The MIDI event to play.
+ *
+ * \param channel
+ *      The channel on which to play the event.
+ *
+ * \param frame
+ *      The frame offset in the current cycle.
+ */
+
+void
+midibus::api_play_frame (event * e24, midibyte channel, int frame)
+{
+    m_rt_midi->api_play_frame(e24, channel, frame);
+}
+
+/**
+ *  Plays an event that was due a while ago, for the direct output mode.
+ *  Forwarded like api_play().
+ *
+ * \param e24
+ *      The MIDI event to play.
+ *
+ * \param channel
+ *      The channel on which to play the event.
+ *
+ * \param ago_us
+ *      How long before now the event was due, in microseconds.
+ */
+
+void
+midibus::api_play_due (event * e24, midibyte channel, long ago_us)
+{
+    m_rt_midi->api_play_due(e24, channel, ago_us);
+}
+
+/**
+ *  Sends one piece of a SysEx message.  Forwarded like api_play().
+ *
+ * \param data
+ *      The bytes of the piece.
+ *
+ * \param len
+ *      The number of bytes in the piece.
+ *
+ * \return
+ *      Returns true if the piece was sent.
+ */
+
+bool
+midibus::api_sysex (const midibyte * data, int len)
+{
+    return not_nullptr(m_rt_midi) ? m_rt_midi->api_sysex(data, len) : false ;
+}
+
 /**
  *  Continue from the given tick.  This function implements only the
  *  RtMidi-specific code.
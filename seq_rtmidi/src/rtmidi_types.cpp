@@ -12,6 +12,8 @@
  *  loosely based on Gary Scavone's RtMidi library.
  */
 
+#include <string.h>                     /* memcpy()                     */
+
 #include "easy_macros.h"                /* errprintfunc() macro, etc.   */
 #include "rtmidi_types.hpp"             /* seq64::rtmidi, etc.          */
 
@@ -169,6 +171,194 @@ midi_queue::pop_front ()
     return result;
 }
 
+/*
+ * class midi_ring
+ */
+
+/**
+ *  Default constructor.  No memory is taken until allocate() is called, so
+ *  that output ports do not pay for a ring they never use.
+ */
+
+midi_ring::midi_ring ()
+ :
+    m_records       (),
+    m_overflow      (),
+    m_head          (0),
+    m_tail          (0),
+    m_overflow_head (0),
+    m_overflow_tail (0),
+    m_dropped       (0)
+{
+    // Empty body
+}
+
+/**
+ *  Takes all of the memory of the ring.  Must be called before the producer
+ *  starts, and only once.  Both sizes must be powers of 2, so that the
+ *  free-running counters stay consistent when they wrap around.
+ *
+ * \param records
+ *      The number of messages the ring can hold.
+ *
+ * \param overflow
+ *      The number of bytes of long messages the ring can hold.
+ */
+
+void
+midi_ring::allocate (unsigned records, unsigned overflow)
+{
+    if (m_records.empty())
+    {
+        m_records.resize(records);
+        m_overflow.resize(overflow);
+    }
+}
+
+/**
+ *  Adds a message to the ring.  Called by the producer only.  Does not
+ *  allocate, lock, or block.
+ *
+ * \param frame
+ *      The JACK frame time at which the message arrived.
+ *
+ * \param bytes
+ *      The bytes of the message.
+ *
+ * \param size
+ *      The number of bytes in the message.
+ *
+ * \return
+ *      Returns true if the message was added, and false if it was dropped
+ *      because the ring was full (or not allocated).
+ */
+
+bool
+midi_ring::push (unsigned frame, const midibyte * bytes, unsigned size)
+{
+    unsigned head = m_head.load(std::memory_order_relaxed);
+    unsigned tail = m_tail.load(std::memory_order_acquire);
+    unsigned ringsize = unsigned(m_records.size());
+    bool result = head - tail < ringsize;
+    if (result && size > SEQ64_RING_RECORD_BYTES)
+    {
+        unsigned areasize = unsigned(m_overflow.size());
+        unsigned used = m_overflow_head -
+            m_overflow_tail.load(std::memory_order_acquire);
+
+        result = size <= areasize - used;
+        if (result)
+        {
+            unsigned start = m_overflow_head % areasize;
+            unsigned first = areasize - start;
+            if (first > size)
+                first = size;
+
+            memcpy(&m_overflow[start], bytes, first);
+            if (first < size)
+                memcpy(&m_overflow[0], bytes + first, size - first);
+
+            m_overflow_head += size;
+        }
+    }
+    if (result)
+    {
+        record & r = m_records[head % ringsize];
+        r.m_frame = frame;
+        r.m_size = size;
+        if (size <= SEQ64_RING_RECORD_BYTES)
+            memcpy(r.m_bytes, bytes, size);
+
+        m_head.store(head + 1, std::memory_order_release);
+    }
+    else
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+
+    return result;
+}
+
+/**
+ *  Copies the oldest record.  Called by the consumer only.
+ *
+ * \param [out] r
+ *      The destination of the record.  If its m_size is greater than
+ *      SEQ64_RING_RECORD_BYTES, the message bytes must be obtained with
+ *      payload().
+ *
+ * \return
+ *      Returns true if there was a record to copy.
+ */
+
+bool
+midi_ring::front (record & r) const
+{
+    unsigned tail = m_tail.load(std::memory_order_relaxed);
+    bool result = m_head.load(std::memory_order_acquire) != tail;
+    if (result)
+        r = m_records[tail % unsigned(m_records.size())];
+
+    return result;
+}
+
+/**
+ *  Copies some of the bytes of the oldest message from the overflow area.
+ *  Called by the consumer only, for a record found by front() that is too
+ *  long to hold its own bytes.
+ *
+ * \param offset
+ *      The index of the first byte to copy, within the message.
+ *
+ * \param dest
+ *      The destination of the bytes.
+ *
+ * \param count
+ *      The most bytes to copy.
+ *
+ * \return
+ *      Returns the number of bytes copied.
+ */
+
+unsigned
+midi_ring::payload (unsigned offset, midibyte * dest, unsigned count) const
+{
+    record r;
+    unsigned result = 0;
+    if (front(r) && r.m_size > SEQ64_RING_RECORD_BYTES && offset < r.m_size)
+    {
+        unsigned areasize = unsigned(m_overflow.size());
+        unsigned index = m_overflow_tail.load(std::memory_order_relaxed);
+        index += offset;
+        result = r.m_size - offset;
+        if (result > count)
+            result = count;
+
+        for (unsigned i = 0; i < result; ++i)
+            dest[i] = m_overflow[(index + i) % areasize];
+    }
+    return result;
+}
+
+/**
+ *  Discards the oldest record, and its bytes in the overflow area, if any.
+ *  Called by the consumer only.
+ */
+
+void
+midi_ring::pop ()
+{
+    record r;
+    if (front(r))
+    {
+        if (r.m_size > SEQ64_RING_RECORD_BYTES)
+        {
+            unsigned ot = m_overflow_tail.load(std::memory_order_relaxed);
+            m_overflow_tail.store(ot + r.m_size, std::memory_order_release);
+        }
+        unsigned tail = m_tail.load(std::memory_order_relaxed);
+        m_tail.store(tail + 1, std::memory_order_release);
+    }
+}
+
 /*
  * class rtmidi_in_data
  */
@@ -176,6 +366,7 @@ midi_queue::pop_front ()
 rtmidi_in_data::rtmidi_in_data ()
  :
     m_queue             (),
+    m_ring              (),
     m_message           (),
     m_ignore_flags      (7),
     m_do_input          (false),